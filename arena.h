@@ -0,0 +1,80 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator for data that is freed all at once
+ *
+ * Memory is taken from large zeroed blocks by moving a pointer along, so
+ * an allocation costs a few instructions and no malloc() call; a new
+ * block is only allocated when the current one is full. Nothing is freed
+ * on its own: arena_free() releases every block together.
+ *
+ * Allocations are aligned to ARENA_ALIGN and come back zeroed. An
+ * allocation bigger than the block size gets a block of its own.
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGN 16
+
+struct arena_block
+{
+    struct arena_block *next;
+    size_t size;                // bytes in data[]
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+struct arena
+{
+    struct arena_block *blocks; // newest first
+    size_t used;                // bytes taken from the newest block
+    size_t block_size;          // size of a new block
+    size_t allocated;           // bytes in all blocks, for reporting
+};
+
+static inline void arena_init(struct arena *arena, size_t block_size)
+{
+    arena->blocks = NULL;
+    arena->used = 0;
+    arena->block_size = block_size;
+    arena->allocated = 0;
+}
+
+/// @brief Take 'size' zeroed bytes from the arena
+/// @return the memory, or NULL if a new block could not be allocated
+static inline void *arena_alloc(struct arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (!arena->blocks || arena->blocks->size - arena->used < size)
+    {
+        size_t block_size = size > arena->block_size ? size : arena->block_size;
+        struct arena_block *block = calloc(1, sizeof(*block) + block_size);
+        if (!block)
+            return NULL;
+        block->size = block_size;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->used = 0;
+        arena->allocated += block_size;
+    }
+
+    void *memory = arena->blocks->data + arena->used;
+    arena->used += size;
+    return memory;
+}
+
+static inline void arena_free(struct arena *arena)
+{
+    while (arena->blocks)
+    {
+        struct arena_block *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    arena->used = 0;
+    arena->allocated = 0;
+}
+
+#endif // ARENA_H
@@ -0,0 +1,504 @@
+/**
+ * @file bench.c
+ * @brief Microbenchmarks of the scoring hot path
+ *
+ * Times the single game functions (ball(), throw_frame(), play_game(),
+ * validate_game(), calculate_game_scores(), print_frame()) and the batch,
+ * live, rendering and leaderboard paths built on them. Built and run by
+ * `make bench`.
+ *
+ * Every benchmark is run --reps times (default 10) over the same fixed
+ * seeded work, after one untimed warm-up run, and reports:
+ * - mean, standard deviation and fastest time per operation in ns
+ * - games per second, for benchmarks where an operation is a game or a
+ *   known part of one
+ *
+ * Results go to stdout as tab-separated lines, with a '#' header, so a run
+ * can be saved and diffed against later:
+ * @code
+ * # name	ops	reps	mean_ns	stddev_ns	min_ns	games_per_sec
+ * play_game	200000	10	95.210	0.812	94.301	10503098
+ * @endcode
+ * A human readable table goes to stderr.
+ *
+ * Usage:
+ *   bowling_bench [--reps R] [--scale X] [--filter TEXT] [--baseline FILE] [--threshold P]
+ *
+ * Options:
+ * --reps R        timed runs of each benchmark
+ * --scale X       multiply the operations per run by X
+ * --filter TEXT   only run benchmarks whose name contains TEXT
+ * --baseline FILE compare against saved results; the exit status is 1 if
+ *                 any benchmark's mean is more than P percent slower
+ * --threshold P   regression threshold for --baseline, default 10
+ */
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bowling_game.h"
+#include "bowling_rng.h"
+#include "frame_validator.h"
+#include "score_calculator.h"
+#include "game_display.h"
+#include "game_batch.h"
+#include "game_render.h"
+#include "live_score.h"
+#include "roll_model.h"
+#include "leaderboard.h"
+#include "frame_codes.h"
+
+#define BENCH_SEED 1
+#define POOL_GAMES 4096     // games the validate and score benchmarks cycle through
+#define MAX_REPS 1000
+#define MAX_BENCHMARKS 32
+
+struct benchmark
+{
+    const char *name;
+    unsigned long long ops;     // operations per run at --scale 1
+    double ops_per_game;        // operations in one game, 0 if that isn't meaningful
+    void (*run)(unsigned long long ops, int arg);
+    int arg;
+};
+
+struct bench_result
+{
+    char name[64];
+    unsigned long long ops;
+    int reps;
+    double mean_ns;
+    double stddev_ns;
+    double min_ns;
+    double games_per_sec;
+};
+
+// results are folded into here so the compiler can't drop the work
+static volatile unsigned long long sink;
+
+static struct roll_model model;
+static struct frame_results pool[POOL_GAMES][MAX_FRAMES];
+static uint8_t pool_rolls[POOL_GAMES][MAX_ROLLS];
+static int pool_roll_count[POOL_GAMES];
+static struct game_batch pool_batch;
+static uint8_t pool_errors[POOL_GAMES];
+static uint8_t pool_codes[POOL_GAMES][MAX_FRAMES];
+static uint16_t pool_totals[POOL_GAMES];
+
+/// @brief Fill the game pool from a fixed seed
+static int make_pool(void)
+{
+    struct bowling_rng rng;
+
+    roll_model_default(&model);
+    bowling_rng_init(&rng, RNG_XOSHIRO256, BENCH_SEED, 0);
+    if (!game_batch_init(&pool_batch, POOL_GAMES))
+        return 0;
+
+    for (int g = 0; g < POOL_GAMES; g++)
+    {
+        init_game_results(pool[g]);
+        play_game_r(pool[g], &model, &rng);
+        calculate_game_scores(pool[g]);
+        pool_roll_count[g] = rolls_from_frames(pool[g], pool_rolls[g]);
+        encode_game(pool[g], pool_codes[g]);
+        game_batch_add(&pool_batch, pool[g]);
+    }
+    return 1;
+}
+
+static void run_ball(unsigned long long ops, int arg)
+{
+    unsigned long long sum = 0;
+
+    (void)arg;
+    seed_game(BENCH_SEED);
+    for (unsigned long long i = 0; i < ops; i++)
+        sum += (unsigned)ball(MAX_PINS);
+    sink += sum;
+}
+
+static void run_throw_frame(unsigned long long ops, int arg)
+{
+    struct frame_results frames[MAX_FRAMES];
+    unsigned long long sum = 0;
+
+    (void)arg;
+    seed_game(BENCH_SEED);
+    for (unsigned long long i = 0; i < ops; i++)
+    {
+        // a played frame is skipped, so start a new game every MAX_FRAMES frames
+        int frame = (int)(i % MAX_FRAMES);
+        if (frame == 0)
+            init_game_results(frames);
+        throw_frame(frames, frame);
+        sum += (unsigned)frames[frame].first_ball;
+    }
+    sink += sum;
+}
+
+static void run_play_game(unsigned long long ops, int arg)
+{
+    struct frame_results frames[MAX_FRAMES];
+    unsigned long long sum = 0;
+
+    (void)arg;
+    seed_game(BENCH_SEED);
+    for (unsigned long long i = 0; i < ops; i++)
+    {
+        init_game_results(frames);
+        play_game(frames);
+        sum += (unsigned)frames[MAX_FRAMES - 1].first_ball;
+    }
+    sink += sum;
+}
+
+static void run_validate_game(unsigned long long ops, int arg)
+{
+    unsigned long long sum = 0;
+
+    (void)arg;
+    for (unsigned long long i = 0; i < ops; i++)
+        sum += validate_game(pool[i % POOL_GAMES]);
+    sink += sum;
+}
+
+static void run_calculate_game_scores(unsigned long long ops, int arg)
+{
+    unsigned long long sum = 0;
+
+    (void)arg;
+    for (unsigned long long i = 0; i < ops; i++)
+    {
+        struct frame_results *frames = pool[i % POOL_GAMES];
+        calculate_game_scores(frames);
+        sum += (unsigned)frames[MAX_FRAMES - 1].score;
+    }
+    sink += sum;
+}
+
+static void run_validate_and_score_game(unsigned long long ops, int arg)
+{
+    unsigned long long sum = 0;
+
+    (void)arg;
+    for (unsigned long long i = 0; i < ops; i++)
+        sum += validate_and_score_game(pool[i % POOL_GAMES], NULL);
+    sink += sum;
+}
+
+/// @brief print_frame() to /dev/null
+static void run_print_frame(unsigned long long ops, int arg)
+{
+    (void)arg;
+    FILE *null = fopen("/dev/null", "w");
+    if (!null)
+        return;
+
+    int total = 0;
+    for (unsigned long long i = 0; i < ops; i++)
+    {
+        const struct frame_results *frames = pool[(i / MAX_FRAMES) % POOL_GAMES];
+        int frame = (int)(i % MAX_FRAMES);
+        total = frame == 0 ? frames[0].score : total + frames[frame].score;
+        print_frame(frames[frame], frame, total, null);
+    }
+    fclose(null);
+}
+
+static void run_render_game(unsigned long long ops, int arg)
+{
+    struct game_renderer render;
+    int null = open("/dev/null", O_WRONLY);
+
+    if (null < 0)
+        return;
+    if (renderer_init(&render, null, (enum render_format)arg, NULL))
+    {
+        for (unsigned long long i = 0; i < ops; i++)
+            render_game(&render, i, pool[i % POOL_GAMES], NO_ERROR);
+        renderer_finish(&render);
+    }
+    close(null);
+}
+
+static void run_validate_game_batch(unsigned long long ops, int arg)
+{
+    (void)arg;
+    for (unsigned long long done = 0; done < ops; done += POOL_GAMES)
+        sink += validate_game_batch(&pool_batch, pool_errors);
+}
+
+static void run_score_batch(unsigned long long ops, int arg)
+{
+    for (unsigned long long done = 0; done < ops; done += POOL_GAMES)
+        sink += calculate_game_scores_batch_kernel(&pool_batch, (enum score_kernel)arg);
+}
+
+static void run_validate_and_score_batch(unsigned long long ops, int arg)
+{
+    (void)arg;
+    for (unsigned long long done = 0; done < ops; done += POOL_GAMES)
+        sink += validate_and_score_game_batch(&pool_batch, pool_errors);
+}
+
+static void run_push_roll(unsigned long long ops, int arg)
+{
+    struct game_state state;
+    unsigned long long sum = 0;
+
+    (void)arg;
+    for (unsigned long long g = 0, rolls = 0; rolls < ops; g++)
+    {
+        const uint8_t *game = pool_rolls[g % POOL_GAMES];
+        int count = pool_roll_count[g % POOL_GAMES];
+        init_game_state(&state);
+        for (int r = 0; r < count; r++)
+            sum += push_roll(&state, game[r]);
+        sum += (unsigned)state.total;
+        rolls += (unsigned)count;
+    }
+    sink += sum;
+}
+
+static void run_score_game_codes(unsigned long long ops, int arg)
+{
+    unsigned long long sum = 0;
+    int total;
+
+    (void)arg;
+    for (unsigned long long i = 0; i < ops; i++)
+    {
+        score_game_codes(pool_codes[i % POOL_GAMES], NULL, &total);
+        sum += (unsigned)total;
+    }
+    sink += sum;
+}
+
+static void run_score_game_codes_batch(unsigned long long ops, int arg)
+{
+    (void)arg;
+    for (unsigned long long done = 0; done < ops; done += POOL_GAMES)
+        sink += score_game_codes_batch(pool_codes[0], MAX_FRAMES, POOL_GAMES, pool_totals, pool_errors);
+}
+
+// a day at a big center: games spread over 100000 players, three to a session
+static void run_leaderboard_add(unsigned long long ops, int arg)
+{
+    static struct leaderboard board;
+
+    (void)arg;
+    leaderboard_init(&board, 100, LEADERBOARD_WINDOW);
+    for (unsigned long long i = 0; i < ops; i++)
+    {
+        const struct frame_results *frames = pool[i % POOL_GAMES];
+        int score = 0;
+        for (int f = 0; f < MAX_FRAMES; f++)
+            score += frames[f].score;
+        leaderboard_add_game(&board, (uint32_t)(i / 3 % 100000), (uint32_t)(i / 300000), score);
+    }
+    sink += board.order;
+    leaderboard_free(&board);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void time_benchmark(const struct benchmark *bench, const char *name, double scale, int reps,
+                           struct bench_result *result)
+{
+    unsigned long long ops = (unsigned long long)(bench->ops * scale);
+    double per_op[MAX_REPS];
+
+    if (ops == 0)
+        ops = 1;
+    bench->run(ops, bench->arg);   // warm up caches and branch predictors
+
+    for (int r = 0; r < reps; r++)
+    {
+        double start = now_ns();
+        bench->run(ops, bench->arg);
+        per_op[r] = (now_ns() - start) / ops;
+    }
+
+    double sum = 0.0;
+    double min = HUGE_VAL;
+    for (int r = 0; r < reps; r++)
+    {
+        sum += per_op[r];
+        if (per_op[r] < min)
+            min = per_op[r];
+    }
+    double mean = sum / reps;
+    double squares = 0.0;
+    for (int r = 0; r < reps; r++)
+        squares += (per_op[r] - mean) * (per_op[r] - mean);
+
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->ops = ops;
+    result->reps = reps;
+    result->mean_ns = mean;
+    result->stddev_ns = reps > 1 ? sqrt(squares / (reps - 1)) : 0.0;
+    result->min_ns = min;
+    result->games_per_sec = bench->ops_per_game > 0 ? 1e9 / (mean * bench->ops_per_game) : 0.0;
+}
+
+/// @brief Read results saved from an earlier run
+/// @return number of results read, or -1 if the file can't be read
+static int load_baseline(const char *path, struct bench_result baseline[], int max)
+{
+    char line[256];
+    int count = 0;
+    FILE *file = fopen(path, "r");
+
+    if (!file)
+        return -1;
+    while (count < max && fgets(line, sizeof(line), file))
+    {
+        struct bench_result *result = &baseline[count];
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%63s %llu %d %lf %lf %lf %lf", result->name, &result->ops, &result->reps,
+                   &result->mean_ns, &result->stddev_ns, &result->min_ns, &result->games_per_sec) == 7)
+            count++;
+    }
+    fclose(file);
+    return count;
+}
+
+/// @brief Print the change from the baseline of each benchmark
+/// @return number of benchmarks slower than the threshold
+static int compare_baseline(const struct bench_result results[], int count,
+                            const struct bench_result baseline[], int baseline_count, double threshold)
+{
+    int regressions = 0;
+
+    fprintf(stderr, "\n%-28s %10s %10s %8s\n", "vs baseline", "was ns", "now ns", "change");
+    for (int i = 0; i < count; i++)
+    {
+        for (int b = 0; b < baseline_count; b++)
+        {
+            if (strcmp(results[i].name, baseline[b].name) != 0)
+                continue;
+
+            double change = 100.0 * (results[i].mean_ns - baseline[b].mean_ns) / baseline[b].mean_ns;
+            int regressed = change > threshold;
+            regressions += regressed;
+            fprintf(stderr, "%-28s %10.3f %10.3f %+7.1f%%%s\n", results[i].name, baseline[b].mean_ns,
+                    results[i].mean_ns, change, regressed ? "  SLOWER" : "");
+            break;
+        }
+    }
+    return regressions;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--reps R] [--scale X] [--filter TEXT] [--baseline FILE] [--threshold P]\n",
+            program);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct benchmark benchmarks[] =
+    {
+        { "ball", 20000000, 0, run_ball, 0 },
+        { "throw_frame", 5000000, MAX_FRAMES, run_throw_frame, 0 },
+        { "play_game", 500000, 1, run_play_game, 0 },
+        { "validate_game", 5000000, 1, run_validate_game, 0 },
+        { "calculate_game_scores", 5000000, 1, run_calculate_game_scores, 0 },
+        { "validate_and_score_game", 5000000, 1, run_validate_and_score_game, 0 },
+        { "print_frame", 2000000, MAX_FRAMES, run_print_frame, 0 },
+        { "render_game_human", 1000000, 1, run_render_game, RENDER_HUMAN },
+        { "render_game_csv", 1000000, 1, run_render_game, RENDER_CSV },
+        { "render_game_json", 1000000, 1, run_render_game, RENDER_JSON },
+        { "validate_game_batch", 20000000, 1, run_validate_game_batch, 0 },
+        { "score_batch_scalar", 20000000, 1, run_score_batch, SCORE_KERNEL_SCALAR },
+        { "score_batch_sse4.2", 20000000, 1, run_score_batch, SCORE_KERNEL_SSE42 },
+        { "score_batch_avx2", 20000000, 1, run_score_batch, SCORE_KERNEL_AVX2 },
+        { "validate_and_score_batch", 20000000, 1, run_validate_and_score_batch, 0 },
+        { "push_roll", 10000000, 0, run_push_roll, 0 },
+        { "score_game_codes", 5000000, 1, run_score_game_codes, 0 },
+        { "score_game_codes_batch", 20000000, 1, run_score_game_codes_batch, 0 },
+        { "leaderboard_add", 5000000, 1, run_leaderboard_add, 0 },
+    };
+    static struct bench_result results[MAX_BENCHMARKS];
+    static struct bench_result baseline[MAX_BENCHMARKS];
+    const char *filter = NULL;
+    const char *baseline_path = NULL;
+    double threshold = 10.0;
+    double scale = 1.0;
+    int reps = 10;
+    int count = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--reps") == 0)
+            reps = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--scale") == 0)
+            scale = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--filter") == 0)
+            filter = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--baseline") == 0)
+            baseline_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--threshold") == 0)
+            threshold = atof(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (reps < 1 || reps > MAX_REPS || scale <= 0.0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!make_pool())
+    {
+        fprintf(stderr, "Error: out of memory\n");
+        return 2;
+    }
+
+    printf("# name\tops\treps\tmean_ns\tstddev_ns\tmin_ns\tgames_per_sec\n");
+    fprintf(stderr, "%-28s %10s %10s %10s %14s\n", "benchmark", "ns/op", "stddev", "min", "games/sec");
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+    {
+        const struct benchmark *bench = &benchmarks[b];
+        if (filter && !strstr(bench->name, filter))
+            continue;
+        if (bench->run == run_score_batch && !score_kernel_available((enum score_kernel)bench->arg))
+            continue;
+
+        struct bench_result *result = &results[count++];
+        time_benchmark(bench, bench->name, scale, reps, result);
+
+        printf("%s\t%llu\t%d\t%.3f\t%.3f\t%.3f\t%.0f\n", result->name, result->ops, result->reps,
+               result->mean_ns, result->stddev_ns, result->min_ns, result->games_per_sec);
+        fflush(stdout);
+        fprintf(stderr, "%-28s %10.3f %10.3f %10.3f %14.0f\n", result->name, result->mean_ns,
+                result->stddev_ns, result->min_ns, result->games_per_sec);
+    }
+
+    game_batch_free(&pool_batch);
+
+    if (!baseline_path)
+        return 0;
+
+    int baseline_count = load_baseline(baseline_path, baseline, MAX_BENCHMARKS);
+    if (baseline_count < 0)
+    {
+        fprintf(stderr, "Error: can't read baseline %s\n", baseline_path);
+        return 2;
+    }
+    return compare_baseline(results, count, baseline, baseline_count, threshold) > 0;
+}
@@ -13,15 +13,6 @@
  * - Special handling for the 10th frame
  * 
  * Main Functions:
- * @fn main()
- *     Entry point that coordinates the complete game flow:
- *     1. Initializes random number generator
- *     2. Sets up initial game state
- *     3. Executes game play
- *     4. Validates game results
- *     5. Calculates final scores
- *     6. Displays game results
- * 
  * @fn play_game()
  *     Executes the frame-by-frame gameplay for all 10 frames
  * 
@@ -36,7 +27,9 @@
  *       * Bonus balls for strikes/spares
  * 
  * @fn ball()
- *     Generates realistic random pin counts with weighted probabilities:
+ *     Generates realistic random pin counts with weighted probabilities,
+ *     sampled from the roll model (roll_model.c) for the number of pins
+ *     standing. The default model gives:
  *     For first ball (10 pins):
  *     - 20% chance for strike
  *     - 15% chance for 9 pins
@@ -45,95 +38,167 @@
  *     
  *     For remaining pins:
  *     - 30% chance for all remaining pins (spare)
- *     - 20% chance for all but 1-2 pins
- *     - 50% distributed normally
+ *     - 20% chance for all but 1 pin, 30% for all but 2 pins
+ *     - 20% distributed normally
  * 
  * @fn init_game_results()
  *     Initializes the game state with undefined frames and zero scores
  * 
+ * @fn frames_from_rolls()
+ *     Fills the frames from a recorded sequence of rolls, using the same
+ *     frame rules as throw_frame()
+ * 
+ * @fn rolls_from_frames()
+ *     Lists the balls of a played game in the order they were rolled
+ * 
+ * With a pin deck set on the roll model (pin_deck.c), throw_frame_r()
+ * plays each rack as the pins left standing instead of a count.
+ * 
+ * Reentrant Versions:
+ * play_game_r(), throw_frame_r() and ball_r() take the roll model and the
+ * generator to draw from as parameters, so several threads can play games
+ * at once. The plain versions draw from the calling thread's own generator,
+ * seeded with seed_game(), and the model that thread set with
+ * use_roll_model() (the default model if none is), so they are safe to
+ * call from several threads too. A thread that never calls seed_game()
+ * gets its own stream of the last seed given to seed_game() on any thread
+ * (GAME_DEFAULT_SEED if none was), numbered in the order threads first
+ * play.
+ * 
  * Dependencies:
  * - bowling_game.h: Game structures and constants
- * - frame_validator.h: Frame validation functionality
- * - score_calculator.h: Score calculation logic
- * - game_display.h: Score display formatting
+ * - bowling_rng.h: Seeded random number generator
+ * - roll_model.h: Roll probability tables
+ * - pin_deck.h: Pin-level rack model
  * 
  * Note: The game uses a seeded random number generator to ensure
  * different results for each game while maintaining realistic
  * bowling score distributions.
  */
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "bowling_game.h"
-#include "frame_validator.h"
-#include "score_calculator.h"
-#include "game_display.h"
+#include "roll_model.h"
+#include "pin_deck.h"
 
-int main()
-{
-    struct frame_results frames[MAX_FRAMES];
-    
-    // seed random number generator
-    srand(time(NULL));
+#define GAME_DEFAULT_SEED 1     // seed of threads that play before any seed_game(), as srand() defaults to 1
 
-    // Initiate game results
-    init_game_results(frames);
+// generator and roll model of each thread's single game functions
+static _Thread_local struct bowling_rng game_rng;
+static _Thread_local int game_rng_seeded;
+static _Thread_local const struct roll_model *game_model;
+
+// what threads that never call seed_game() seed their generator from
+static atomic_uint_fast64_t process_seed = GAME_DEFAULT_SEED;
+static atomic_uint_fast64_t thread_streams;     // streams handed out so far, stream 0 is seed_game()'s
+
+// built once and only read after, shared by every thread
+static struct roll_model default_model;
+static pthread_once_t default_model_once = PTHREAD_ONCE_INIT;
 
-    play_game(frames);
+static void build_default_model(void)
+{
+    roll_model_default(&default_model);
+}
 
-    // Validate game results
-    enum bowling_error error = validate_game(frames);
-    if (error != NO_ERROR)
+/// @brief The calling thread's model, the shared default model until use_roll_model() sets one
+static const struct roll_model *thread_model(void)
+{
+    if (!game_model)
     {
-        printf("Error: %d\n", error);
-        return 0;
+        pthread_once(&default_model_once, build_default_model);
+        game_model = &default_model;
     }
+    return game_model;
+}
 
-    calculate_game_scores(frames);
-    
-    report_game_scores(frames);
+/// @brief The calling thread's generator, given its own stream of the process seed on first use
+static struct bowling_rng *thread_rng(void)
+{
+    if (!game_rng_seeded)
+    {
+        uint64_t stream = atomic_fetch_add(&thread_streams, 1) + 1;
+        bowling_rng_seed_stream(&game_rng, atomic_load(&process_seed), stream);
+        game_rng_seeded = 1;
+    }
+    return &game_rng;
+}
 
-    return 1;
+/// @brief Seed the calling thread's generator used by play_game(), throw_frame() and ball()
+/// @param seed also what threads that haven't called seed_game() seed from
+void seed_game(uint64_t seed)
+{
+    bowling_rng_seed(&game_rng, seed);
+    game_rng_seeded = 1;
+    atomic_store(&process_seed, seed);
+}
+
+/// @brief Set the roll model the calling thread's play_game(), throw_frame() and ball() use
+/// @param model must stay valid while games are played, NULL for the default model
+void use_roll_model(const struct roll_model *model)
+{
+    game_model = model;
 }
 
 void play_game(struct frame_results frames[MAX_FRAMES])
+{
+    play_game_r(frames, thread_model(), thread_rng());
+}
+
+void play_game_r(struct frame_results frames[MAX_FRAMES], const struct roll_model *model, struct bowling_rng *rng)
 {
     for (int i = 0; i < 10; i++)
-        throw_frame(frames, i);
+        throw_frame_r(frames, i, model, rng);
+}
+
+void throw_frame(struct frame_results frames[MAX_FRAMES], int frame)
+{
+    throw_frame_r(frames, frame, thread_model(), thread_rng());
 }
 
 // return 1 if good or 0 if bad
 // the results of a thrown frame go in the frame_results
-void throw_frame(struct frame_results frames[MAX_FRAMES], int frame)
+void throw_frame_r(struct frame_results frames[MAX_FRAMES], int frame,
+                   const struct roll_model *model, struct bowling_rng *rng)
 {
+    // a model with a pin deck plays which pins stand, see pin_deck.c
+    if (model->deck)
+    {
+        pin_deck_throw_frame(frames, frame, model->deck, rng, NULL);
+        return;
+    }
+
     if (frames[frame].type == UNDEFINED)
     {
         // if 10th frame, it has 3 balls
-        if (frame == 9)
+        if (frame == MAX_FRAMES - 1)
         {
             frames[frame].type = LAST_FRAME;
 
-            frames[frame].first_ball = ball(MAX_PINS);    // first ball
+            frames[frame].first_ball = ball_r(MAX_PINS, model, rng);    // first ball
             if (frames[frame].first_ball == STRIKE_SCORE)     // strike
             {
-                frames[frame].second_ball = ball(MAX_PINS);   // second ball
+                frames[frame].second_ball = ball_r(MAX_PINS, model, rng);   // second ball
                 if (frames[frame].second_ball == STRIKE_SCORE)    // second strike
-                    frames[frame].third_ball = ball(MAX_PINS);    // third ball
+                    frames[frame].third_ball = ball_r(MAX_PINS, model, rng);    // third ball
                 else
-                    frames[frame].third_ball = ball(MAX_PINS - frames[frame].second_ball);
+                    frames[frame].third_ball = ball_r(MAX_PINS - frames[frame].second_ball, model, rng);
             }
             else
             {
                 // first ball is not a strike
-                frames[frame].second_ball = ball(MAX_PINS - frames[frame].first_ball);    // second ball
-                frames[frame].third_ball = 0;
+                frames[frame].second_ball = ball_r(MAX_PINS - frames[frame].first_ball, model, rng);    // second ball
+                if (frames[frame].first_ball + frames[frame].second_ball == MAX_PINS)
+                    frames[frame].third_ball = ball_r(MAX_PINS, model, rng);    // spare earns a fresh rack
+                else
+                    frames[frame].third_ball = 0;
             }
         } 
         else
         {
             // frames 1-9
-            frames[frame].first_ball = ball(MAX_PINS);    // first ball
+            frames[frame].first_ball = ball_r(MAX_PINS, model, rng);    // first ball
             if (frames[frame].first_ball == STRIKE_SCORE)
             {
                 frames[frame].second_ball = 0;
@@ -142,7 +207,7 @@ void throw_frame(struct frame_results frames[MAX_FRAMES], int frame)
             else
             {
                 // Second ball
-                frames[frame].second_ball = ball(MAX_PINS - frames[frame].first_ball);
+                frames[frame].second_ball = ball_r(MAX_PINS - frames[frame].first_ball, model, rng);
                 if (frames[frame].second_ball == MAX_PINS - frames[frame].first_ball)
                     frames[frame].type = SPARE;
                 else
@@ -152,29 +217,16 @@ void throw_frame(struct frame_results frames[MAX_FRAMES], int frame)
     }
 }
 
- // return a random number between 0 and 'pins'
-int ball( int pins ) 
+int ball( int pins )
 {
-    int r = rand() % 100;  // Get number between 0-99
+    return ball_r(pins, thread_model(), thread_rng());
+}
 
-    if (0)
-        return 10;
-    
-    // Adjust these thresholds to change the distribution
-    if (pins == MAX_PINS)
-    {
-        if (r < 20)      return pins;        // 20% chance for strike
-        else if (r < 35) return pins - 1;    // 15% chance for 9
-        else if (r < 50) return pins - 2;    // 15% chance for 8
-        else             return rand() % (pins+1); // Remaining distributed normally
-    }
-    else
-    {
-        if (r < 30)      return pins;        // 30% chance for spare
-        else if (r < 50) return pins>=1 ? pins-1 : 0;    // 15% chance for 9
-        else if (r < 80) return pins>=2 ? pins-2 : 0;    // 15% chance for 8
-        else             return rand() % (pins+1); // Remaining distributed normally
-    }
+ // return a random number between 0 and 'pins'
+int ball_r( int pins, const struct roll_model *model, struct bowling_rng *rng ) 
+{
+    // Adjust the distribution with a roll model file, see roll_model.c
+    return roll_model_sample(model, pins, rng);
 }
 
 /// @brief All frames are undefined and zero scores
@@ -190,3 +242,99 @@ void init_game_results(struct frame_results frames[MAX_FRAMES])
         frames[i].score = 0;
     }
 }
+
+/**
+ * Fills the frames of a game from the sequence of balls rolled, as a
+ * bowling center records them.
+ * 
+ * @param rolls pins knocked down by each ball, in order
+ * @param count number of rolls
+ * @param frames receives the game; frames that aren't reached stay UNDEFINED
+ * 
+ * @return NO_ERROR, INCOMPLETE_GAME if the rolls run out before the game is
+ *         over, or TOO_MANY_ROLLS if some are left over
+ * 
+ * Frames are split the way throw_frame() plays them: a 10 on the first ball
+ * of frames 1-9 is a strike, otherwise the frame takes two balls, and the
+ * 10th frame takes a third ball after a strike or spare. Pin counts aren't
+ * checked here; validate_game() does that.
+ */
+enum bowling_error frames_from_rolls(const uint8_t rolls[], int count, struct frame_results frames[MAX_FRAMES])
+{
+    int r = 0;
+
+    init_game_results(frames);
+    for (int frame = 0; frame < MAX_FRAMES - 1; frame++)
+    {
+        if (r >= count)
+            return INCOMPLETE_GAME;
+
+        frames[frame].first_ball = rolls[r++];
+        if (frames[frame].first_ball == STRIKE_SCORE)
+        {
+            frames[frame].type = STRIKE;
+            continue;
+        }
+
+        if (r >= count)
+            return INCOMPLETE_GAME;
+        frames[frame].second_ball = rolls[r++];
+        if (frames[frame].first_ball + frames[frame].second_ball == MAX_PINS)
+            frames[frame].type = SPARE;
+        else
+            frames[frame].type = OPEN;
+    }
+
+    // 10th frame
+    if (r + 2 > count)
+        return INCOMPLETE_GAME;
+    frames[MAX_FRAMES - 1].first_ball = rolls[r++];
+    frames[MAX_FRAMES - 1].second_ball = rolls[r++];
+    if (frames[MAX_FRAMES - 1].first_ball == STRIKE_SCORE ||
+        frames[MAX_FRAMES - 1].first_ball + frames[MAX_FRAMES - 1].second_ball == MAX_PINS)
+    {
+        if (r >= count)
+            return INCOMPLETE_GAME;
+        frames[MAX_FRAMES - 1].third_ball = rolls[r++];
+    }
+    frames[MAX_FRAMES - 1].type = LAST_FRAME;
+
+    return r == count ? NO_ERROR : TOO_MANY_ROLLS;
+}
+
+/**
+ * Lists the balls of a played game in the order they were rolled, the
+ * reverse of frames_from_rolls().
+ * 
+ * @param frames a complete game
+ * @param rolls receives the pins knocked down by each ball
+ * @return the number of rolls
+ */
+int rolls_from_frames(const struct frame_results frames[MAX_FRAMES], uint8_t rolls[MAX_ROLLS])
+{
+    int count = 0;
+
+    for (int frame = 0; frame < MAX_FRAMES - 1; frame++)
+    {
+        rolls[count++] = (uint8_t)frames[frame].first_ball;
+        if (frames[frame].type != STRIKE)
+            rolls[count++] = (uint8_t)frames[frame].second_ball;
+    }
+
+    // 10th frame
+    const struct frame_results *last = &frames[MAX_FRAMES - 1];
+    rolls[count++] = (uint8_t)last->first_ball;
+    rolls[count++] = (uint8_t)last->second_ball;
+    if (last->first_ball == STRIKE_SCORE || last->first_ball + last->second_ball == MAX_PINS)
+        rolls[count++] = (uint8_t)last->third_ball;
+
+    return count;
+}
+
+/// @brief What an error means, for messages
+const char *bowling_error_name(enum bowling_error error)
+{
+    static const char *const names[] = { "no error", "incomplete game", "invalid pins", "invalid frame type",
+                                         "too many rolls" };
+    return (unsigned)error < sizeof(names) / sizeof(names[0]) ? names[error] : "unknown error";
+}
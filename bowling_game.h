@@ -2,17 +2,26 @@
 #ifndef BOWLING_GAME_H
 #define BOWLING_GAME_H
 
+#include "bowling_rng.h"
+
+struct roll_model;
+
 #define MAX_FRAMES 10
 #define MAX_PINS 10
 #define STRIKE_SCORE 10
+#define MAX_SCORE 300
 
 enum bowling_error {
     NO_ERROR,
     INCOMPLETE_GAME,
     INVALID_PINS,
-    INVALID_FRAME_TYPE
+    INVALID_FRAME_TYPE,
+    TOO_MANY_ROLLS      // rolls left over after the 10th frame
 };
 
+// Most balls a game can have: two per frame plus a bonus ball in the 10th
+#define MAX_ROLLS (2 * MAX_FRAMES + 1)
+
 enum frame_type
 {
     STRIKE,     // 10 points plus value of next two balls
@@ -35,5 +44,16 @@ void throw_frame(struct frame_results frames[MAX_FRAMES], int frame_number);
 int ball(int pins);
 void play_game(struct frame_results frames[MAX_FRAMES]);
 void init_game_results(struct frame_results frames[MAX_FRAMES]);
+void seed_game(uint64_t seed);
+void use_roll_model(const struct roll_model *model);
+enum bowling_error frames_from_rolls(const uint8_t rolls[], int count, struct frame_results frames[MAX_FRAMES]);
+int rolls_from_frames(const struct frame_results frames[MAX_FRAMES], uint8_t rolls[MAX_ROLLS]);
+const char *bowling_error_name(enum bowling_error error);
+
+// reentrant versions that draw from a caller-owned generator and roll model
+void throw_frame_r(struct frame_results frames[MAX_FRAMES], int frame_number,
+                   const struct roll_model *model, struct bowling_rng *rng);
+int ball_r(int pins, const struct roll_model *model, struct bowling_rng *rng);
+void play_game_r(struct frame_results frames[MAX_FRAMES], const struct roll_model *model, struct bowling_rng *rng);
 
 #endif /* BOWLING_GAME_H */
\ No newline at end of file
@@ -0,0 +1,238 @@
+/**
+ * @file bowling_rng.c
+ * @brief Explicitly seeded random number generators for game play
+ *
+ * rand() keeps one hidden generator for the whole process, so two threads
+ * playing games at the same time would share (and race on) its state.
+ * Every caller that rolls balls now owns a struct bowling_rng instead, which
+ * makes game play reentrant and reproducible from a seed.
+ *
+ * Generators (enum rng_kind):
+ * - RNG_XOSHIRO256: xoshiro256**, 256 bits of state, the default
+ * - RNG_PCG32:      PCG XSH-RR, 64 bits of state and a stream increment,
+ *                   two outputs per 64-bit draw
+ * - RNG_SPLITMIX64: SplitMix64, 64 bits of state
+ * - RNG_PHILOX:     Philox4x32-10 (Salmon et al., "Parallel random numbers:
+ *                   as easy as 1, 2, 3"), counter-based: draw n of stream k
+ *                   is a keyed hash of (k, n), with the seed as the key
+ *
+ * The generator is picked when it is initialized; the switch in
+ * bowling_rng_next() always goes the same way and costs next to nothing.
+ * Streams for worker threads are derived from the run seed and a stream
+ * number, so each thread draws from an unrelated sequence.
+ *
+ * Counter-based streams:
+ * A Philox stream holds no state beyond where it is, so stream k can be
+ * started without generating streams 0..k-1. The simulation and the lane
+ * server use one stream per game, numbered by game, when RNG_PHILOX is
+ * picked, which makes every game a function of (seed, game number) only:
+ * the same whatever the thread count or scheduling, and any one of them
+ * can be played again on its own (--replay K).
+ *
+ * Philox state: s[0] is the key (the seed), s[1] the stream, s[2] the
+ * number of 64-bit draws so far and s[3] the unused half of the last
+ * 128-bit block. Block b of stream k is Philox4x32-10 of the counter
+ * (b, k) as four 32-bit words, low word first.
+ */
+#include <string.h>
+
+#include "bowling_rng.h"
+
+#define GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL
+#define PCG_MULTIPLIER 6364136223846793005ULL
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+static uint64_t mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    *state += GOLDEN_GAMMA;
+    return mix64(*state);
+}
+
+static uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t xoshiro256(uint64_t s[4])
+{
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+// s[0] is the state, s[1] the (odd) stream increment
+static uint32_t pcg32(uint64_t s[4])
+{
+    uint64_t old = s[0];
+    s[0] = old * PCG_MULTIPLIER + s[1];
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+/// @brief Philox4x32-10 of one counter block under a 64-bit key
+static void philox4x32(uint32_t counter[4], uint64_t key)
+{
+    uint32_t k0 = (uint32_t)key;
+    uint32_t k1 = (uint32_t)(key >> 32);
+
+    for (int round = 0; round < PHILOX_ROUNDS; round++)
+    {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * counter[0];
+        uint64_t p1 = (uint64_t)PHILOX_M1 * counter[2];
+        uint32_t c1 = counter[1];
+        uint32_t c3 = counter[3];
+
+        counter[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        counter[1] = (uint32_t)p1;
+        counter[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        counter[3] = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// s[0] key, s[1] stream, s[2] draws so far, s[3] the second half of the current block
+static uint64_t philox(uint64_t s[4])
+{
+    uint64_t draw = s[2]++;
+    if (draw & 1)
+        return s[3];
+
+    uint64_t block = draw >> 1;
+    uint32_t counter[4] = { (uint32_t)block, (uint32_t)(block >> 32), (uint32_t)s[1], (uint32_t)(s[1] >> 32) };
+    philox4x32(counter, s[0]);
+    s[3] = ((uint64_t)counter[3] << 32) | counter[2];
+    return ((uint64_t)counter[1] << 32) | counter[0];
+}
+
+/// @brief Initialize a generator
+/// @param rng generator to initialize
+/// @param kind which algorithm to use
+/// @param seed any value, equal seeds give equal sequences
+/// @param stream stream number, e.g. worker thread index, for unrelated sequences from one seed
+void bowling_rng_init(struct bowling_rng *rng, enum rng_kind kind, uint64_t seed, uint64_t stream)
+{
+    uint64_t sm = seed ^ mix64((stream + 1) * GOLDEN_GAMMA);
+
+    memset(rng, 0, sizeof(*rng));
+    rng->kind = kind;
+    switch (kind)
+    {
+    case RNG_PCG32:
+        rng->s[1] = (stream << 1) | 1;
+        rng->s[0] = splitmix64(&sm) + rng->s[1];
+        pcg32(rng->s);
+        break;
+    case RNG_SPLITMIX64:
+        rng->s[0] = sm;
+        break;
+    case RNG_PHILOX:
+        // the key is the seed itself, so a stream depends on nothing but (seed, stream)
+        rng->s[0] = seed;
+        rng->s[1] = stream;
+        break;
+    default:
+        rng->kind = RNG_XOSHIRO256;
+        // xoshiro must not start from all zeros, splitmix64 output never is
+        for (int i = 0; i < 4; i++)
+            rng->s[i] = splitmix64(&sm);
+        break;
+    }
+}
+
+/// @brief Seed the default generator
+void bowling_rng_seed(struct bowling_rng *rng, uint64_t seed)
+{
+    bowling_rng_init(rng, RNG_XOSHIRO256, seed, 0);
+}
+
+/// @brief Seed one of several independent default generator streams from a shared seed
+void bowling_rng_seed_stream(struct bowling_rng *rng, uint64_t seed, uint64_t stream)
+{
+    bowling_rng_init(rng, RNG_XOSHIRO256, seed, stream);
+}
+
+/// @brief Start a counter-based generator at the beginning of another stream, in O(1)
+/// @param stream for the simulation and the lane server, the game number
+/// Only RNG_PHILOX can seek; other generators are left as they are.
+void bowling_rng_seek(struct bowling_rng *rng, uint64_t stream)
+{
+    if (rng->kind == RNG_PHILOX)
+    {
+        rng->s[1] = stream;
+        rng->s[2] = 0;
+    }
+}
+
+/// @brief Next 64 random bits
+uint64_t bowling_rng_next(struct bowling_rng *rng)
+{
+    switch (rng->kind)
+    {
+    case RNG_PCG32:
+    {
+        uint64_t high = pcg32(rng->s);
+        return (high << 32) | pcg32(rng->s);
+    }
+    case RNG_SPLITMIX64:
+        return splitmix64(&rng->s[0]);
+    case RNG_PHILOX:
+        return philox(rng->s);
+    default:
+        return xoshiro256(rng->s);
+    }
+}
+
+/// @brief Random number between 0 and bound-1
+int bowling_rng_below(struct bowling_rng *rng, int bound)
+{
+    // multiply-shift keeps the top bits, avoiding the bias of a plain modulo
+    return (int)(((bowling_rng_next(rng) >> 32) * (uint64_t)bound) >> 32);
+}
+
+const char *rng_kind_name(enum rng_kind kind)
+{
+    switch (kind)
+    {
+    case RNG_XOSHIRO256: return "xoshiro";
+    case RNG_PCG32:      return "pcg";
+    case RNG_SPLITMIX64: return "splitmix";
+    case RNG_PHILOX:     return "philox";
+    default:             return "unknown";
+    }
+}
+
+/// @brief Look up a generator by the name rng_kind_name() gives it
+/// @return 1 if good or 0 if the name is unknown
+int rng_kind_from_name(const char *name, enum rng_kind *kind)
+{
+    for (int k = 0; k < RNG_KIND_COUNT; k++)
+    {
+        if (strcmp(name, rng_kind_name((enum rng_kind)k)) == 0)
+        {
+            *kind = (enum rng_kind)k;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,31 @@
+// bowling_rng.h
+#ifndef BOWLING_RNG_H
+#define BOWLING_RNG_H
+
+#include <stdint.h>
+
+enum rng_kind
+{
+    RNG_XOSHIRO256,     // xoshiro256**, the default
+    RNG_PCG32,          // PCG XSH-RR 64/32
+    RNG_SPLITMIX64,     // SplitMix64
+    RNG_PHILOX,         // Philox4x32-10, counter-based: each stream can be started anywhere in O(1)
+    RNG_KIND_COUNT
+};
+
+struct bowling_rng
+{
+    enum rng_kind kind;
+    uint64_t s[4];      // generator state, how much is used depends on kind
+};
+
+void bowling_rng_init(struct bowling_rng *rng, enum rng_kind kind, uint64_t seed, uint64_t stream);
+void bowling_rng_seed(struct bowling_rng *rng, uint64_t seed);
+void bowling_rng_seed_stream(struct bowling_rng *rng, uint64_t seed, uint64_t stream);
+void bowling_rng_seek(struct bowling_rng *rng, uint64_t stream);
+uint64_t bowling_rng_next(struct bowling_rng *rng);
+int bowling_rng_below(struct bowling_rng *rng, int bound);
+const char *rng_kind_name(enum rng_kind kind);
+int rng_kind_from_name(const char *name, enum rng_kind *kind);
+
+#endif // BOWLING_RNG_H
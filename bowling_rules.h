@@ -0,0 +1,150 @@
+/**
+ * @file bowling_rules.h
+ * @brief Rules engine template, included once per bowling variant
+ *
+ * There is no include guard: define the rules, then include this file,
+ * and it defines static inline functions for that variant and undefines
+ * the rules again, ready for the next variant. bowling_variants.h does
+ * this for the variants we run.
+ * @code
+ * #define RULES_NAME tenpin           // prefix of the generated functions
+ * #define RULES_FRAMES 10             // frames in a game
+ * #define RULES_PINS 10               // pins (or pin points) in a full rack
+ * #define RULES_BALLS 2               // balls to clear the rack in frames before the last
+ * #define RULES_STRIKE_BONUS 2        // bonus balls for clearing the rack with the first ball
+ * #define RULES_SPARE_BONUS 1         // bonus balls for clearing it with the second
+ * #include "bowling_rules.h"
+ * @endcode
+ *
+ * A game is given as the pins knocked down by each ball, in order, the
+ * way frames_from_rolls() takes it. Each frame:
+ * - balls are rolled until the rack is cleared or RULES_BALLS are used
+ * - clearing it with the first ball earns RULES_STRIKE_BONUS bonus balls,
+ *   with the second RULES_SPARE_BONUS, later (a candlepin or duckpin
+ *   "ten") none; a frame scores its pins plus its bonus balls' pins
+ * - in the last frame the bonus balls are rolled as fill balls: they
+ *   continue on the pins left standing and a cleared rack is set again
+ *
+ * Because every rule is a compile-time constant, the frame and ball loops
+ * have constant bounds and the compiler unrolls them and folds the rule
+ * checks away; nothing is checked at run time that the variant can't
+ * need.
+ *
+ * Generated functions, for RULES_NAME x:
+ * - x_max_rolls(), x_max_score(): size limits of a game
+ * - x_score_rolls(): validate and score a game in one pass
+ */
+
+#if !defined(RULES_NAME) || !defined(RULES_FRAMES) || !defined(RULES_PINS) || !defined(RULES_BALLS) || \
+    !defined(RULES_STRIKE_BONUS) || !defined(RULES_SPARE_BONUS)
+#error "define RULES_NAME, RULES_FRAMES, RULES_PINS, RULES_BALLS, RULES_STRIKE_BONUS and RULES_SPARE_BONUS first"
+#endif
+
+#include <stdint.h>
+
+#include "bowling_game.h"
+
+#define RULES_PASTE(name, function) name##_##function
+#define RULES_EXPAND(name, function) RULES_PASTE(name, function)
+#define RULES_FN(function) RULES_EXPAND(RULES_NAME, function)
+
+// balls the last frame can take: a full frame, or a clear plus its fill balls
+#define RULES_LAST_BALLS_1 (RULES_BALLS > 1 + RULES_STRIKE_BONUS ? RULES_BALLS : 1 + RULES_STRIKE_BONUS)
+#define RULES_LAST_BALLS (RULES_LAST_BALLS_1 > 2 + RULES_SPARE_BONUS ? RULES_LAST_BALLS_1 : 2 + RULES_SPARE_BONUS)
+
+/// @brief Most balls a game can take
+static inline int RULES_FN(max_rolls)(void)
+{
+    return (RULES_FRAMES - 1) * RULES_BALLS + RULES_LAST_BALLS;
+}
+
+/// @brief Highest possible score, every ball a strike
+static inline int RULES_FN(max_score)(void)
+{
+    return RULES_FRAMES * RULES_PINS * (1 + RULES_STRIKE_BONUS);
+}
+
+/**
+ * Validates and scores a game in one pass.
+ *
+ * @param rolls pins knocked down by each ball, in order
+ * @param count number of rolls
+ * @param frame_scores receives the score of each frame, bonuses included
+ * @param total receives the final score
+ *
+ * @return NO_ERROR, INVALID_PINS if a ball knocks down more pins than are
+ *         standing, INCOMPLETE_GAME if the rolls run out, or TOO_MANY_ROLLS
+ *         if some are left over
+ */
+static inline enum bowling_error RULES_FN(score_rolls)(const uint8_t rolls[], int count,
+                                                       int frame_scores[RULES_FRAMES], int *total)
+{
+    int ball = 0;
+    int sum = 0;
+
+    for (int frame = 0; frame < RULES_FRAMES; frame++)
+    {
+        int standing = RULES_PINS;
+        int bonus = 0;
+
+        for (int b = 0; b < RULES_BALLS; b++)
+        {
+            if (ball >= count)
+                return INCOMPLETE_GAME;
+            if (rolls[ball] > standing)
+                return INVALID_PINS;
+            standing -= rolls[ball++];
+            if (standing == 0)
+            {
+                bonus = b == 0 ? RULES_STRIKE_BONUS : b == 1 ? RULES_SPARE_BONUS : 0;
+                break;
+            }
+        }
+
+        int score = RULES_PINS - standing;
+        if (frame < RULES_FRAMES - 1)
+        {
+            // bonus balls belong to later frames, which check them
+            if (ball + bonus > count)
+                return INCOMPLETE_GAME;
+            for (int b = 0; b < bonus; b++)
+                score += rolls[ball + b];
+        }
+        else
+        {
+            // fill balls, on a fresh rack whenever the last one was cleared
+            standing = RULES_PINS;
+            for (int b = 0; b < bonus; b++)
+            {
+                if (ball >= count)
+                    return INCOMPLETE_GAME;
+                if (rolls[ball] > standing)
+                    return INVALID_PINS;
+                score += rolls[ball];
+                standing -= rolls[ball++];
+                if (standing == 0)
+                    standing = RULES_PINS;
+            }
+        }
+
+        frame_scores[frame] = score;
+        sum += score;
+    }
+
+    if (ball != count)
+        return TOO_MANY_ROLLS;
+    *total = sum;
+    return NO_ERROR;
+}
+
+#undef RULES_PASTE
+#undef RULES_EXPAND
+#undef RULES_FN
+#undef RULES_LAST_BALLS_1
+#undef RULES_LAST_BALLS
+#undef RULES_NAME
+#undef RULES_FRAMES
+#undef RULES_PINS
+#undef RULES_BALLS
+#undef RULES_STRIKE_BONUS
+#undef RULES_SPARE_BONUS
@@ -0,0 +1,291 @@
+/**
+ * @file bowling_stats.c
+ * @brief Hot-path counters and per-stage latency histograms
+ *
+ * Built with -DBOWLING_STATS (make STATS=1), the pipelines time each of
+ * their stages and count the errors they find:
+ * - STATS_START() and STATS_STOP() read the cycle counter around a stage
+ *   and record one call of it, covering 'items' games or rolls; the
+ *   batch pipelines time a whole batch at a time, so the cost is a few
+ *   clock reads per 4096 games
+ * - the time of each call goes into a histogram of power-of-two buckets,
+ *   so the report gives the median and tail as well as the mean
+ * - STATS_ERROR() counts each enum bowling_error found
+ *
+ * Without BOWLING_STATS the macros expand to nothing and only the report
+ * functions remain, to say the counters aren't built in.
+ *
+ * Threads:
+ * - every thread records into its own block of counters, allocated on
+ *   first use and added to a lock-free list; blocks outlive their thread
+ *   so the report covers threads that have finished
+ * - only the owning thread writes a block; the counters are relaxed
+ *   atomics so a report taken while the threads run reads whole values
+ *
+ * stats_watch_signal() makes SIGUSR1 request a report. The handler only
+ * sets a flag: the next thread to call STATS_POLL(), which the pipelines
+ * do between batches, writes the report to stderr.
+ *
+ * The clock is the time stamp counter on x86 (cycles at the nominal
+ * frequency) and the monotonic clock in nanoseconds elsewhere.
+ *
+ * Example report (--simulate 3000000 --seed 1 --stats, one core):
+ * Stage          Calls        Items  cycles/item  Share   P50 call   P99 call
+ * generate         733      3000000        795.1   91.0%    4194304    8388608
+ * validate         733      3000000         73.1    8.4%     262144    1048576
+ * score            733      3000000          5.5    0.6%      32768      65536
+ * output             0            0          0.0    0.0%          0          0
+ *
+ * Thread      generate     validate        score       output
+ * 0            3000000      3000000      3000000            0
+ *
+ * Errors:          0
+ */
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bowling_stats.h"
+
+#ifdef BOWLING_STATS
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <x86intrin.h>
+#define STATS_CLOCK_UNIT "cycles"
+#else
+#define STATS_CLOCK_UNIT "ns"
+#endif
+
+#define STATS_BUCKETS 48        // call times up to 2^48 clock ticks
+#define ERROR_KINDS (TOO_MANY_ROLLS + 1)
+
+struct stage_stats
+{
+    atomic_ullong calls;
+    atomic_ullong items;
+    atomic_ullong ticks;
+    atomic_ullong histogram[STATS_BUCKETS];     // calls taking under 2^(b+1) ticks
+};
+
+struct thread_stats
+{
+    struct stage_stats stage[STAGE_COUNT];
+    atomic_ullong errors[ERROR_KINDS];
+    int index;                          // order the thread first recorded in
+    struct thread_stats *next;
+};
+
+static _Atomic(struct thread_stats *) all_threads;
+static atomic_int thread_count;
+static atomic_int report_requested;
+static _Thread_local struct thread_stats *local;
+
+static const char *const stage_names[STAGE_COUNT] = { "generate", "validate", "score", "output" };
+static const char *const error_names[ERROR_KINDS] = {
+    "none", "incomplete game", "invalid pins", "invalid frame type", "too many rolls"
+};
+
+uint64_t stats_clock(void)
+{
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/// @brief This thread's counters, allocated and listed the first time it records
+static struct thread_stats *thread_stats(void)
+{
+    if (local)
+        return local;
+
+    local = calloc(1, sizeof(*local));
+    if (!local)
+        return NULL;
+    local->index = atomic_fetch_add_explicit(&thread_count, 1, memory_order_relaxed);
+
+    struct thread_stats *head = atomic_load_explicit(&all_threads, memory_order_relaxed);
+    do
+        local->next = head;
+    while (!atomic_compare_exchange_weak_explicit(&all_threads, &head, local, memory_order_release,
+                                                  memory_order_relaxed));
+    return local;
+}
+
+// only the owning thread writes a counter, so no read-modify-write is needed
+static inline void add(atomic_ullong *counter, unsigned long long amount)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+static inline unsigned long long get(atomic_ullong *counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+/// @brief Record one call of a stage, started at 'start' by stats_clock(), that handled 'items' games or rolls
+void stats_record(enum stats_stage stage, uint64_t start, unsigned long long items)
+{
+    uint64_t ticks = stats_clock() - start;
+    struct thread_stats *stats = thread_stats();
+    if (!stats)
+        return;
+
+    struct stage_stats *s = &stats->stage[stage];
+    int bucket = ticks > 1 ? 63 - __builtin_clzll(ticks) : 0;
+    add(&s->calls, 1);
+    add(&s->items, items);
+    add(&s->ticks, ticks);
+    add(&s->histogram[bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1], 1);
+}
+
+void stats_count_error(enum bowling_error error)
+{
+    struct thread_stats *stats = thread_stats();
+    if (stats && (unsigned)error < ERROR_KINDS)
+        add(&stats->errors[error], 1);
+}
+
+/// @brief Write the report to stderr if SIGUSR1 asked for one since the last poll
+void stats_poll(void)
+{
+    if (atomic_load_explicit(&report_requested, memory_order_relaxed) &&
+        atomic_exchange_explicit(&report_requested, 0, memory_order_relaxed))
+    {
+        stats_report(stderr);
+        fflush(stderr);
+    }
+}
+
+static void request_report(int signal_number)
+{
+    (void)signal_number;
+    atomic_store_explicit(&report_requested, 1, memory_order_relaxed);
+}
+
+int stats_enabled(void)
+{
+    return 1;
+}
+
+/// @brief Make SIGUSR1 ask the running pipeline for a report
+void stats_watch_signal(void)
+{
+    struct sigaction action = { 0 };
+    action.sa_handler = request_report;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+}
+
+/// @brief Upper bound, in ticks, of the call time 'percent' percent of calls stayed under
+static unsigned long long stage_percentile(const unsigned long long histogram[STATS_BUCKETS],
+                                           unsigned long long calls, double percent)
+{
+    double needed = calls * percent / 100.0;
+    unsigned long long seen = 0;
+
+    if (calls == 0)
+        return 0;
+    for (int b = 0; b < STATS_BUCKETS; b++)
+    {
+        seen += histogram[b];
+        if (seen > 0 && seen >= needed)
+            return 2ull << b;
+    }
+    return 2ull << (STATS_BUCKETS - 1);
+}
+
+/**
+ * Prints the counters of every thread that has recorded so far.
+ *
+ * @param out where the report is written
+ *
+ * For each stage: the calls and items recorded, the mean time per item,
+ * the stage's share of the time in all stages, and the median and 99th
+ * percentile time of a call (as the power of two it stayed under). Then
+ * the items each thread handled in each stage, and the errors found by
+ * kind.
+ */
+void stats_report(FILE *out)
+{
+    unsigned long long calls[STAGE_COUNT] = { 0 };
+    unsigned long long items[STAGE_COUNT] = { 0 };
+    unsigned long long ticks[STAGE_COUNT] = { 0 };
+    unsigned long long histogram[STAGE_COUNT][STATS_BUCKETS] = { { 0 } };
+    unsigned long long errors[ERROR_KINDS] = { 0 };
+    unsigned long long all_ticks = 0;
+    struct thread_stats *head = atomic_load_explicit(&all_threads, memory_order_acquire);
+
+    for (struct thread_stats *t = head; t; t = t->next)
+    {
+        for (int s = 0; s < STAGE_COUNT; s++)
+        {
+            calls[s] += get(&t->stage[s].calls);
+            items[s] += get(&t->stage[s].items);
+            ticks[s] += get(&t->stage[s].ticks);
+            for (int b = 0; b < STATS_BUCKETS; b++)
+                histogram[s][b] += get(&t->stage[s].histogram[b]);
+        }
+        for (int e = 0; e < ERROR_KINDS; e++)
+            errors[e] += get(&t->errors[e]);
+    }
+    for (int s = 0; s < STAGE_COUNT; s++)
+        all_ticks += ticks[s];
+
+    fprintf(out, "Stage          Calls        Items  %6s/item  Share   P50 call   P99 call\n", STATS_CLOCK_UNIT);
+    for (int s = 0; s < STAGE_COUNT; s++)
+        fprintf(out, "%-8s %11llu %12llu %12.1f %6.1f%% %10llu %10llu\n", stage_names[s], calls[s], items[s],
+                items[s] ? (double)ticks[s] / items[s] : 0.0, all_ticks ? 100.0 * ticks[s] / all_ticks : 0.0,
+                stage_percentile(histogram[s], calls[s], 50.0), stage_percentile(histogram[s], calls[s], 99.0));
+
+    // the list is newest first; print the threads in the order they started recording
+    fprintf(out, "\nThread ");
+    for (int s = 0; s < STAGE_COUNT; s++)
+        fprintf(out, " %12s", stage_names[s]);
+    fprintf(out, "\n");
+    int threads = atomic_load_explicit(&thread_count, memory_order_relaxed);
+    for (int index = 0; index < threads; index++)
+    {
+        for (struct thread_stats *t = head; t; t = t->next)
+        {
+            if (t->index != index)
+                continue;
+            fprintf(out, "%-6d ", index);
+            for (int s = 0; s < STAGE_COUNT; s++)
+                fprintf(out, " %12llu", get(&t->stage[s].items));
+            fprintf(out, "\n");
+        }
+    }
+
+    unsigned long long error_total = 0;
+    for (int e = 1; e < ERROR_KINDS; e++)
+        error_total += errors[e];
+    fprintf(out, "\nErrors: %10llu\n", error_total);
+    for (int e = 1; e < ERROR_KINDS; e++)
+        if (errors[e] != 0)
+            fprintf(out, "  %-18s %10llu\n", error_names[e], errors[e]);
+}
+
+#else
+
+int stats_enabled(void)
+{
+    return 0;
+}
+
+void stats_watch_signal(void)
+{
+}
+
+void stats_report(FILE *out)
+{
+    fprintf(out, "Stats: not built in, rebuild with make clean && make STATS=1\n");
+}
+
+#endif // BOWLING_STATS
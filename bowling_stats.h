@@ -0,0 +1,47 @@
+// bowling_stats.h
+#ifndef BOWLING_STATS_H
+#define BOWLING_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+
+// pipeline stages that are timed, see bowling_stats.c
+enum stats_stage
+{
+    STAGE_GENERATE,     // playing games, play_game_r() and throw_frame_r()
+    STAGE_VALIDATE,     // validate_game() and friends
+    STAGE_SCORE,        // calculate_game_scores() and friends, push_roll()
+    STAGE_OUTPUT,       // rendering and writing the games or results
+    STAGE_COUNT
+};
+
+#ifdef BOWLING_STATS
+
+uint64_t stats_clock(void);
+void stats_record(enum stats_stage stage, uint64_t start, unsigned long long items);
+void stats_count_error(enum bowling_error error);
+void stats_poll(void);
+
+// STATS_START(t); ...stage...; STATS_STOP(STAGE_X, t, items);
+#define STATS_START(timer) uint64_t timer = stats_clock()
+#define STATS_STOP(stage, timer, items) stats_record((stage), (timer), (items))
+#define STATS_ERROR(error) stats_count_error(error)
+#define STATS_POLL() stats_poll()
+
+#else
+
+// compiled out: no clock reads, no counters, no calls
+#define STATS_START(timer) ((void)0)
+#define STATS_STOP(stage, timer, items) ((void)0)
+#define STATS_ERROR(error) ((void)0)
+#define STATS_POLL() ((void)0)
+
+#endif // BOWLING_STATS
+
+int stats_enabled(void);
+void stats_watch_signal(void);
+void stats_report(FILE *out);
+
+#endif // BOWLING_STATS_H
@@ -0,0 +1,105 @@
+/**
+ * @file bowling_variants.h
+ * @brief The bowling variants we score, each an instance of bowling_rules.h
+ *
+ * - tenpin: the game the rest of the program plays
+ * - candlepin, duckpin: three balls a frame; clearing the rack with the
+ *   third ball (a "ten") earns no bonus
+ * - fivepin: Canadian five-pin; the pins are worth 2, 3, 5, 3 and 2
+ *   points and a ball's "pins" are the points it knocks down, so a full
+ *   rack is 15 and a perfect game 450. Which point totals a single ball
+ *   can make isn't checked.
+ *
+ * variant_score_rolls() picks the variant at run time, once per game; the
+ * scoring itself is the variant's own specialized code.
+ */
+#ifndef BOWLING_VARIANTS_H
+#define BOWLING_VARIANTS_H
+
+#include <string.h>
+
+#include "bowling_game.h"
+
+// more than the balls any variant's game can take
+#define VARIANT_MAX_ROLLS 32
+
+enum bowling_variant
+{
+    VARIANT_TENPIN,
+    VARIANT_CANDLEPIN,
+    VARIANT_DUCKPIN,
+    VARIANT_FIVEPIN,
+    VARIANT_COUNT
+};
+
+#define RULES_NAME tenpin
+#define RULES_FRAMES MAX_FRAMES
+#define RULES_PINS MAX_PINS
+#define RULES_BALLS 2
+#define RULES_STRIKE_BONUS 2
+#define RULES_SPARE_BONUS 1
+#include "bowling_rules.h"
+
+#define RULES_NAME candlepin
+#define RULES_FRAMES 10
+#define RULES_PINS 10
+#define RULES_BALLS 3
+#define RULES_STRIKE_BONUS 2
+#define RULES_SPARE_BONUS 1
+#include "bowling_rules.h"
+
+#define RULES_NAME duckpin
+#define RULES_FRAMES 10
+#define RULES_PINS 10
+#define RULES_BALLS 3
+#define RULES_STRIKE_BONUS 2
+#define RULES_SPARE_BONUS 1
+#include "bowling_rules.h"
+
+#define RULES_NAME fivepin
+#define RULES_FRAMES 10
+#define RULES_PINS 15
+#define RULES_BALLS 3
+#define RULES_STRIKE_BONUS 2
+#define RULES_SPARE_BONUS 1
+#include "bowling_rules.h"
+
+/// @brief Validate and score a game of any variant, see bowling_rules.h
+static inline enum bowling_error variant_score_rolls(enum bowling_variant variant, const uint8_t rolls[], int count,
+                                                     int frame_scores[MAX_FRAMES], int *total)
+{
+    switch (variant)
+    {
+    case VARIANT_CANDLEPIN:
+        return candlepin_score_rolls(rolls, count, frame_scores, total);
+    case VARIANT_DUCKPIN:
+        return duckpin_score_rolls(rolls, count, frame_scores, total);
+    case VARIANT_FIVEPIN:
+        return fivepin_score_rolls(rolls, count, frame_scores, total);
+    default:
+        return tenpin_score_rolls(rolls, count, frame_scores, total);
+    }
+}
+
+static inline const char *variant_name(enum bowling_variant variant)
+{
+    static const char *const names[VARIANT_COUNT] = { "tenpin", "candlepin", "duckpin", "fivepin" };
+    return variant < VARIANT_COUNT ? names[variant] : "unknown";
+}
+
+/// @brief Look up a variant by name
+/// @return 1 if found or 0 if the name isn't known
+static inline int variant_from_name(const char *name, enum bowling_variant *variant)
+{
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (strcmp(name, variant_name((enum bowling_variant)v)) == 0)
+        {
+            *variant = (enum bowling_variant)v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif // BOWLING_VARIANTS_H
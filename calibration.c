@@ -0,0 +1,552 @@
+/**
+ * @file calibration.c
+ * @brief Fitting roll models to recorded games
+ *
+ * Reads a corpus of recorded games and writes the roll model they imply,
+ * in the format roll_model_load() reads, so --model FILE can simulate the
+ * bowlers that were recorded instead of the default guesses.
+ *
+ * A game's rolls are fixed by its frame codes (frame_codes.c), so a
+ * corpus is first reduced to how often each code was seen, one increment
+ * per frame, and only the 66 + 241 code counts are turned into roll
+ * counts, [pins standing][pins knocked down], at the end:
+ * - a regular frame is a roll with 10 standing, and unless it is a
+ *   strike a roll with the pins left
+ * - the 10th frame's fill balls are rolled at a fresh rack after a strike
+ *   or spare, and at the pins left after a strike and a non-strike
+ *
+ * Corpora, told apart by calibration_corpus_kind():
+ * - a binary game file (game_file.c), mapped and split evenly across the
+ *   threads, each counting codes into its own table; the tables are
+ *   summed once all have finished. Games with a code out of range are
+ *   skipped and counted
+ * - recorded games, the --ingest format (game_ingest.c), read and
+ *   validated by ingest_each_game() on one thread; invalid games are
+ *   skipped and counted
+ * - a league file (league_store.c), loaded into a league store, whose
+ *   players are split across the threads. With CALIBRATE_BY_LANE each
+ *   thread counts every lane into its own tables, summed at the end; with
+ *   CALIBRATE_BY_PLAYER a first pass counts the whole corpus and a second
+ *   fits and writes each player's model on the thread that counted them
+ *
+ * Fitting: a model's row for each number of pins standing is the rolls
+ * seen with that many standing, normalized. A player's or lane's row adds
+ * the whole corpus's row with the weight of CALIBRATION_PRIOR_ROLLS rolls,
+ * so a bowler with few games gets a model near the league's instead of
+ * one with holes where they never happened to knock down 3 of 7; a row
+ * with no rolls at all keeps the default.
+ *
+ * Example (a 100 million game file of default model games, 1.83 billion
+ * rolls, on one core: 1.7 s):
+ * Games:          100000000
+ * Invalid:                0
+ * Rolls:         1830169100
+ * Strikes:           24.56%
+ * Spares:            36.00%
+ */
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calibration.h"
+#include "game_file.h"
+#include "game_ingest.h"
+#include "worker_threads.h"
+
+struct calibration_worker
+{
+    int index;
+    int threads;
+    int failed;                             // set if memory could not be allocated or a model written
+    // game file
+    const uint8_t *records;
+    uint64_t count;
+    // league
+    const struct league_store *store;
+    enum calibration_group by;
+    const char *directory;
+    const struct roll_counts *prior;        // the whole corpus, for the per player models
+    struct frame_code_counts *lanes;        // [lane], with CALIBRATE_BY_LANE
+    // tallies
+    uint64_t games;
+    uint64_t invalid_games;
+    uint64_t models;
+    uint64_t skipped;
+    struct frame_code_counts codes;
+};
+
+static inline void count_codes(const uint8_t codes[MAX_FRAMES], struct frame_code_counts *counts)
+{
+    for (int i = 0; i < MAX_FRAMES - 1; i++)
+        counts->regular[codes[i]]++;
+    counts->last[codes[MAX_FRAMES - 1]]++;
+}
+
+static void add_code_counts(struct frame_code_counts *sum, const struct frame_code_counts *add)
+{
+    for (int c = 0; c < REGULAR_FRAME_CODES; c++)
+        sum->regular[c] += add->regular[c];
+    for (int c = 0; c < LAST_FRAME_CODES; c++)
+        sum->last[c] += add->last[c];
+}
+
+/**
+ * Turns frame code counts into roll counts.
+ *
+ * @param codes how often each frame outcome was seen
+ * @param counts receives the rolls those frames hold
+ */
+void roll_counts_from_codes(const struct frame_code_counts *codes, struct roll_counts *counts)
+{
+    memset(counts, 0, sizeof(*counts));
+
+    for (int c = 0; c < REGULAR_FRAME_CODES; c++)
+    {
+        const struct frame_code *frame = &regular_frame_codes[c];
+        uint64_t n = codes->regular[c];
+        counts->rolls[MAX_PINS][frame->first_ball] += n;
+        if (frame->first_ball != MAX_PINS)
+            counts->rolls[MAX_PINS - frame->first_ball][frame->second_ball] += n;
+    }
+
+    for (int c = 0; c < LAST_FRAME_CODES; c++)
+    {
+        const struct frame_code *frame = &last_frame_codes[c];
+        uint64_t n = codes->last[c];
+        int first = frame->first_ball;
+        int second = frame->second_ball;
+
+        counts->rolls[MAX_PINS][first] += n;
+        counts->rolls[first == MAX_PINS ? MAX_PINS : MAX_PINS - first][second] += n;
+        if (first == MAX_PINS)
+            counts->rolls[second == MAX_PINS ? MAX_PINS : MAX_PINS - second][frame->third_ball] += n;
+        else if (first + second == MAX_PINS)
+            counts->rolls[MAX_PINS][frame->third_ball] += n;
+    }
+}
+
+/// @brief Run 'body' on 'threads' workers (run_worker_threads())
+/// @return 1 if good or 0 if a worker failed
+static int run_workers(struct calibration_worker *workers, int threads, void *(*body)(void *))
+{
+    int good = 1;
+
+    run_worker_threads(workers, sizeof(*workers), threads, body);
+    for (int t = 0; t < threads; t++)
+    {
+        if (workers[t].failed)
+            good = 0;
+    }
+    return good;
+}
+
+/// @brief Count the codes of one worker's share of a game file
+/// @param arg struct calibration_worker for this thread
+static void *game_file_thread(void *arg)
+{
+    struct calibration_worker *worker = arg;
+
+    for (uint64_t g = 0; g < worker->count; g++)
+    {
+        const uint8_t *codes = worker->records + g * GAME_FILE_RECORD_SIZE;
+        int good = codes[MAX_FRAMES - 1] < LAST_FRAME_CODES;
+        for (int i = 0; i < MAX_FRAMES - 1; i++)
+            good &= codes[i] < REGULAR_FRAME_CODES;
+        if (!good)
+        {
+            worker->invalid_games++;
+            continue;
+        }
+        count_codes(codes, &worker->codes);
+    }
+    worker->games = worker->count;
+    return NULL;
+}
+
+/**
+ * Counts the rolls of every game in a binary game file.
+ *
+ * @param path the game file
+ * @param threads worker threads, 0 for one per core
+ * @param results receives the games and their rolls
+ * @return 1 if good or 0 if the file can't be read as a game file or
+ *         memory could not be allocated
+ */
+int calibrate_game_file(const char *path, int threads, struct calibration_results *results)
+{
+    struct game_file file;
+    struct frame_code_counts codes;
+
+    memset(results, 0, sizeof(*results));
+    if (!game_file_open(&file, path))
+        return 0;
+
+    threads = worker_thread_count(threads);
+    if ((uint64_t)threads > file.count)
+        threads = file.count > 0 ? (int)file.count : 1;
+    struct calibration_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    if (!workers)
+    {
+        game_file_close(&file);
+        return 0;
+    }
+
+    uint64_t first = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t].index = t;
+        workers[t].count = file.count / threads + ((uint64_t)t < file.count % threads);
+        workers[t].records = file.data + GAME_FILE_HEADER_SIZE + first * GAME_FILE_RECORD_SIZE;
+        first += workers[t].count;
+    }
+    run_workers(workers, threads, game_file_thread);
+
+    memset(&codes, 0, sizeof(codes));
+    for (int t = 0; t < threads; t++)
+    {
+        add_code_counts(&codes, &workers[t].codes);
+        results->games += workers[t].games;
+        results->invalid_games += workers[t].invalid_games;
+    }
+    roll_counts_from_codes(&codes, &results->counts);
+
+    free(workers);
+    game_file_close(&file);
+    return 1;
+}
+
+/**
+ * Tells what kind of corpus a file is: a game file by its header,
+ * recorded games if the first game line starts with a pin count, and a
+ * league file if it starts with a name. "-" (stdin) is read as a league
+ * file.
+ *
+ * @param kind receives the kind
+ * @return 1 if good or 0 if the file can't be read
+ */
+int calibration_corpus_kind(const char *path, enum calibration_corpus *kind)
+{
+    struct game_file file;
+    char line[256];
+
+    *kind = CORPUS_LEAGUE;
+    if (strcmp(path, "-") == 0)
+        return 1;
+    if (game_file_open(&file, path))
+    {
+        game_file_close(&file);
+        *kind = CORPUS_GAME_FILE;
+        return 1;
+    }
+
+    FILE *in = fopen(path, "r");
+    if (!in)
+        return 0;
+    while (fgets(line, sizeof(line), in))
+    {
+        const char *p = line;
+        while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')
+            p++;
+        if (*p == '\0' || *p == '\n' || *p == '#')
+            continue;
+        if (isdigit((unsigned char)*p))
+            *kind = CORPUS_RECORDED_GAMES;
+        break;
+    }
+    fclose(in);
+    return 1;
+}
+
+/// @brief ingest_game_fn that counts the codes of each valid game
+static void count_recorded_game(void *context, unsigned long long line, const struct frame_results frames[MAX_FRAMES],
+                                enum bowling_error error)
+{
+    struct calibration_worker *worker = context;
+    uint8_t codes[MAX_FRAMES];
+
+    (void)line;
+    worker->games++;
+    if (error != NO_ERROR || encode_game(frames, codes) != NO_ERROR)
+    {
+        worker->invalid_games++;
+        return;
+    }
+    count_codes(codes, &worker->codes);
+}
+
+/**
+ * Counts the rolls of every valid game in a file of recorded games.
+ *
+ * @param path the recorded games, "-" for stdin
+ * @param results receives the games and their rolls
+ * @return 1 if good or 0 if the file can't be read or memory could not
+ *         be allocated
+ */
+int calibrate_recorded_games(const char *path, struct calibration_results *results)
+{
+    struct ingest_results ingested;
+
+    memset(results, 0, sizeof(*results));
+    struct calibration_worker *worker = calloc(1, sizeof(*worker));
+    if (!worker)
+        return 0;
+    int good = ingest_each_game(path, count_recorded_game, worker, &ingested);
+    if (good)
+    {
+        results->games = worker->games;
+        results->invalid_games = worker->invalid_games;
+        roll_counts_from_codes(&worker->codes, &results->counts);
+    }
+    free(worker);
+    return good;
+}
+
+/// @brief Count the codes of every game of a player, into one table or per lane
+static void count_player(const struct league_player *player, struct frame_code_counts *codes,
+                         struct frame_code_counts *lanes)
+{
+    for (const struct league_game_block *block = player->first_games; block; block = block->next)
+        for (int i = 0; i < block->count; i++)
+        {
+            const struct league_game *game = &block->games[i];
+            count_codes(game->codes, lanes ? &lanes[game->lane] : codes);
+        }
+}
+
+/// @brief First pass over one worker's share of the players: the corpus, or every lane
+/// @param arg struct calibration_worker for this thread
+static void *league_count_thread(void *arg)
+{
+    struct calibration_worker *worker = arg;
+    const struct league_store *store = worker->store;
+
+    for (uint32_t id = (uint32_t)worker->index; id < store->player_count; id += (uint32_t)worker->threads)
+    {
+        count_player(store->players[id], &worker->codes, worker->by == CALIBRATE_BY_LANE ? worker->lanes : NULL);
+        worker->games += store->players[id]->games;
+    }
+    return NULL;
+}
+
+/// @brief A name that stays within the directory as a file name
+static int safe_file_name(const char *name)
+{
+    return name[0] != '\0' && name[0] != '.' && !strchr(name, '/');
+}
+
+/// @brief Second pass with CALIBRATE_BY_PLAYER: fit and write one worker's share of the players' models
+/// @param arg struct calibration_worker for this thread
+static void *player_model_thread(void *arg)
+{
+    struct calibration_worker *worker = arg;
+    const struct league_store *store = worker->store;
+    struct frame_code_counts codes;
+    struct roll_counts counts;
+    struct roll_model model;
+    char path[PATH_MAX];
+
+    for (uint32_t id = (uint32_t)worker->index; id < store->player_count; id += (uint32_t)worker->threads)
+    {
+        const struct league_player *player = store->players[id];
+        if (!safe_file_name(player->name) ||
+            snprintf(path, sizeof(path), "%s/%s.model", worker->directory, player->name) >= (int)sizeof(path))
+        {
+            worker->skipped++;
+            continue;
+        }
+
+        memset(&codes, 0, sizeof(codes));
+        count_player(player, &codes, NULL);
+        roll_counts_from_codes(&codes, &counts);
+        calibration_fit(&counts, worker->prior, CALIBRATION_PRIOR_ROLLS, &model);
+        if (!calibration_save(&model, &counts, path))
+        {
+            worker->failed = 1;
+            return NULL;
+        }
+        worker->models++;
+    }
+    return NULL;
+}
+
+/**
+ * Counts the rolls of every game in a league store and, with a group,
+ * writes a model for each player or lane.
+ *
+ * @param store the league's games
+ * @param by CALIBRATE_ALL to only count, or the models to write
+ * @param threads worker threads, 0 for one per core
+ * @param directory where the models go, as NAME.model for a player or
+ *        laneN.model for lane N
+ * @param results receives the games, their rolls and the models written
+ * @return 1 if good or 0 if memory could not be allocated or a model
+ *         could not be written
+ */
+int calibrate_league(const struct league_store *store, enum calibration_group by, int threads, const char *directory,
+                     struct calibration_results *results)
+{
+    struct frame_code_counts codes;
+    struct roll_counts counts;
+    struct roll_model model;
+    char path[PATH_MAX];
+    int lanes = store->lane_count > 0 ? store->lane_count : 1;
+    int good = 1;
+
+    memset(results, 0, sizeof(*results));
+    threads = worker_thread_count(threads);
+    struct calibration_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    if (!workers)
+        return 0;
+    for (int t = 0; t < threads && good; t++)
+    {
+        workers[t].index = t;
+        workers[t].threads = threads;
+        workers[t].store = store;
+        workers[t].by = by;
+        workers[t].directory = directory;
+        workers[t].prior = &results->counts;
+        if (by == CALIBRATE_BY_LANE && !(workers[t].lanes = calloc((size_t)lanes, sizeof(*workers[t].lanes))))
+            good = 0;
+    }
+
+    good = good && run_workers(workers, threads, league_count_thread);
+    if (good)
+    {
+        memset(&codes, 0, sizeof(codes));
+        for (int t = 0; t < threads; t++)
+        {
+            results->games += workers[t].games;
+            add_code_counts(&codes, &workers[t].codes);
+            // each thread's lanes are summed into the first thread's
+            for (int lane = 0; lane < lanes && by == CALIBRATE_BY_LANE; lane++)
+            {
+                if (t > 0)
+                    add_code_counts(&workers[0].lanes[lane], &workers[t].lanes[lane]);
+                if (t == threads - 1)
+                    add_code_counts(&codes, &workers[0].lanes[lane]);
+            }
+        }
+        roll_counts_from_codes(&codes, &results->counts);
+    }
+
+    if (good && by == CALIBRATE_BY_PLAYER)
+    {
+        good = run_workers(workers, threads, player_model_thread);
+        for (int t = 0; t < threads; t++)
+        {
+            results->models += workers[t].models;
+            results->skipped += workers[t].skipped;
+        }
+    }
+
+    for (int lane = 0; good && by == CALIBRATE_BY_LANE && lane < store->lane_count; lane++)
+    {
+        if (store->lanes[lane].games == 0)
+            continue;
+        roll_counts_from_codes(&workers[0].lanes[lane], &counts);
+        calibration_fit(&counts, &results->counts, CALIBRATION_PRIOR_ROLLS, &model);
+        snprintf(path, sizeof(path), "%s/lane%d.model", directory, lane);
+        good = calibration_save(&model, &counts, path);
+        results->models += (uint64_t)good;
+    }
+
+    for (int t = 0; t < threads; t++)
+        free(workers[t].lanes);
+    free(workers);
+    return good;
+}
+
+/**
+ * Fits a roll model to counted rolls.
+ *
+ * @param counts the rolls seen
+ * @param prior rolls whose distribution is added to each row, may be NULL
+ * @param prior_rolls how many rolls the prior's row counts as
+ * @param model receives the model; rows with no rolls and no prior keep
+ *        the default
+ */
+void calibration_fit(const struct roll_counts *counts, const struct roll_counts *prior, double prior_rolls,
+                     struct roll_model *model)
+{
+    roll_model_default(model);
+    for (int pins = 1; pins <= MAX_PINS; pins++)
+    {
+        double weights[MAX_PINS + 1];
+        uint64_t prior_total = 0;
+
+        for (int i = 0; prior && i <= pins; i++)
+            prior_total += prior->rolls[pins][i];
+        for (int i = 0; i <= pins; i++)
+        {
+            weights[i] = (double)counts->rolls[pins][i];
+            if (prior_total > 0)
+                weights[i] += prior_rolls * (double)prior->rolls[pins][i] / (double)prior_total;
+        }
+        roll_model_set(model, pins, weights);
+    }
+}
+
+/**
+ * Writes a fitted model, with the number of rolls behind each row.
+ *
+ * @param model the model
+ * @param counts the rolls it was fitted to
+ * @param path file to write, NULL for stdout
+ * @return 1 if good or 0 if the file could not be written
+ */
+int calibration_save(const struct roll_model *model, const struct roll_counts *counts, const char *path)
+{
+    FILE *file = path ? fopen(path, "w") : stdout;
+    if (!file)
+        return 0;
+
+    fprintf(file, "# rolls seen with 10, 9, ..., 1 pins standing:");
+    for (int pins = MAX_PINS; pins >= 1; pins--)
+    {
+        uint64_t rolls = 0;
+        for (int i = 0; i <= pins; i++)
+            rolls += counts->rolls[pins][i];
+        fprintf(file, " %llu", (unsigned long long)rolls);
+    }
+    fprintf(file, "\n");
+    roll_model_save(model, file);
+
+    int good = !ferror(file);
+    if (path)
+        good = fclose(file) == 0 && good;
+    else
+        good = fflush(file) == 0 && good;
+    return good;
+}
+
+/// @brief Print the games and rolls counted, and the strike and spare rates they show
+void report_calibration(const struct calibration_results *results, FILE *out)
+{
+    uint64_t rolls = 0;
+    uint64_t racks = 0;
+    uint64_t spare_chances = 0;
+    uint64_t spares = 0;
+
+    for (int pins = 1; pins <= MAX_PINS; pins++)
+        for (int i = 0; i <= pins; i++)
+            rolls += results->counts.rolls[pins][i];
+    for (int i = 0; i <= MAX_PINS; i++)
+        racks += results->counts.rolls[MAX_PINS][i];
+    for (int pins = 1; pins < MAX_PINS; pins++)
+    {
+        spares += results->counts.rolls[pins][pins];
+        for (int i = 0; i <= pins; i++)
+            spare_chances += results->counts.rolls[pins][i];
+    }
+
+    fprintf(out, "Games:    %15llu\n", (unsigned long long)results->games);
+    fprintf(out, "Invalid:  %15llu\n", (unsigned long long)results->invalid_games);
+    fprintf(out, "Rolls:    %15llu\n", (unsigned long long)rolls);
+    fprintf(out, "Strikes:  %14.2f%%\n", racks ? 100.0 * results->counts.rolls[MAX_PINS][MAX_PINS] / racks : 0.0);
+    fprintf(out, "Spares:   %14.2f%%\n", spare_chances ? 100.0 * spares / spare_chances : 0.0);
+    if (results->models > 0 || results->skipped > 0)
+        fprintf(out, "Models:   %15llu\n", (unsigned long long)results->models);
+    if (results->skipped > 0)
+        fprintf(out, "Skipped:  %15llu\n", (unsigned long long)results->skipped);
+}
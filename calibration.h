@@ -0,0 +1,66 @@
+// calibration.h
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "frame_codes.h"
+#include "league_store.h"
+#include "roll_model.h"
+
+// a corpus with fewer valid games than this share of the games read isn't fitted
+#define CALIBRATION_MIN_VALID 0.5
+
+// weight of the whole corpus in a player's or lane's model, in rolls
+#define CALIBRATION_PRIOR_ROLLS 50.0
+
+// how often each frame outcome was seen, what a corpus is reduced to
+struct frame_code_counts
+{
+    uint64_t regular[REGULAR_FRAME_CODES];  // frames 1-9
+    uint64_t last[LAST_FRAME_CODES];        // 10th frame
+};
+
+// rolls seen, [pins standing][pins knocked down]
+struct roll_counts
+{
+    uint64_t rolls[MAX_PINS + 1][MAX_PINS + 1];
+};
+
+enum calibration_group
+{
+    CALIBRATE_ALL,          // one model for the whole corpus
+    CALIBRATE_BY_PLAYER,    // a model per player of a league file
+    CALIBRATE_BY_LANE,      // a model per lane of a league file
+};
+
+enum calibration_corpus
+{
+    CORPUS_GAME_FILE,       // a binary game file, game_file.c
+    CORPUS_RECORDED_GAMES,  // recorded games, one line of rolls each, game_ingest.c
+    CORPUS_LEAGUE,          // a league file, league_store.c
+};
+
+struct calibration_results
+{
+    uint64_t games;             // games read
+    uint64_t invalid_games;     // games skipped, not a valid game
+    uint64_t models;            // per player or lane models written
+    uint64_t skipped;           // players whose name can't be a file name
+    struct roll_counts counts;  // rolls of every valid game
+};
+
+void roll_counts_from_codes(const struct frame_code_counts *codes, struct roll_counts *counts);
+int calibration_corpus_kind(const char *path, enum calibration_corpus *kind);
+int calibrate_game_file(const char *path, int threads, struct calibration_results *results);
+int calibrate_recorded_games(const char *path, struct calibration_results *results);
+int calibrate_league(const struct league_store *store, enum calibration_group by, int threads, const char *directory,
+                     struct calibration_results *results);
+void calibration_fit(const struct roll_counts *counts, const struct roll_counts *prior, double prior_rolls,
+                     struct roll_model *model);
+int calibration_save(const struct roll_model *model, const struct roll_counts *counts, const char *path);
+void report_calibration(const struct calibration_results *results, FILE *out);
+
+#endif // CALIBRATION_H
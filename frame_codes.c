@@ -0,0 +1,239 @@
+/**
+ * @file frame_codes.c
+ * @brief Dictionary encoding of frame outcomes as single-byte codes
+ *
+ * A frame in frames 1-9 has only 66 legal outcomes and the 10th frame
+ * 241, so every frame fits in one byte and a whole game in MAX_FRAMES
+ * bytes, instead of the 200 bytes of struct frame_results[MAX_FRAMES].
+ *
+ * Frames 1-9 (regular_frame_codes):
+ * - 0:      strike
+ * - 1-10:   spare, first ball 0-9
+ * - 11-65:  open, first ball a and second ball b with a + b <= 9,
+ *           in order of a then b
+ *
+ * 10th frame (last_frame_codes):
+ * Every legal (first, second, third) ball triple in ascending order:
+ * - a strike is followed by two balls; the third has a fresh rack only
+ *   if the second was also a strike
+ * - a spare is followed by one ball on a fresh rack
+ * - an open frame has no third ball (0)
+ *
+ * The code tables are constant, so encoding and decoding need no setup
+ * and are safe to use from any number of threads.
+ */
+#include "frame_codes.h"
+
+// first code of the open frames with each first ball
+#define FIRST_OPEN_CODE 11
+
+const struct frame_code regular_frame_codes[REGULAR_FRAME_CODES] = {
+    { STRIKE, 10,  0,  0 }, { SPARE,  0, 10,  0 }, { SPARE,  1,  9,  0 }, { SPARE,  2,  8,  0 },
+    { SPARE,  3,  7,  0 }, { SPARE,  4,  6,  0 }, { SPARE,  5,  5,  0 }, { SPARE,  6,  4,  0 },
+    { SPARE,  7,  3,  0 }, { SPARE,  8,  2,  0 }, { SPARE,  9,  1,  0 }, { OPEN,   0,  0,  0 },
+    { OPEN,   0,  1,  0 }, { OPEN,   0,  2,  0 }, { OPEN,   0,  3,  0 }, { OPEN,   0,  4,  0 },
+    { OPEN,   0,  5,  0 }, { OPEN,   0,  6,  0 }, { OPEN,   0,  7,  0 }, { OPEN,   0,  8,  0 },
+    { OPEN,   0,  9,  0 }, { OPEN,   1,  0,  0 }, { OPEN,   1,  1,  0 }, { OPEN,   1,  2,  0 },
+    { OPEN,   1,  3,  0 }, { OPEN,   1,  4,  0 }, { OPEN,   1,  5,  0 }, { OPEN,   1,  6,  0 },
+    { OPEN,   1,  7,  0 }, { OPEN,   1,  8,  0 }, { OPEN,   2,  0,  0 }, { OPEN,   2,  1,  0 },
+    { OPEN,   2,  2,  0 }, { OPEN,   2,  3,  0 }, { OPEN,   2,  4,  0 }, { OPEN,   2,  5,  0 },
+    { OPEN,   2,  6,  0 }, { OPEN,   2,  7,  0 }, { OPEN,   3,  0,  0 }, { OPEN,   3,  1,  0 },
+    { OPEN,   3,  2,  0 }, { OPEN,   3,  3,  0 }, { OPEN,   3,  4,  0 }, { OPEN,   3,  5,  0 },
+    { OPEN,   3,  6,  0 }, { OPEN,   4,  0,  0 }, { OPEN,   4,  1,  0 }, { OPEN,   4,  2,  0 },
+    { OPEN,   4,  3,  0 }, { OPEN,   4,  4,  0 }, { OPEN,   4,  5,  0 }, { OPEN,   5,  0,  0 },
+    { OPEN,   5,  1,  0 }, { OPEN,   5,  2,  0 }, { OPEN,   5,  3,  0 }, { OPEN,   5,  4,  0 },
+    { OPEN,   6,  0,  0 }, { OPEN,   6,  1,  0 }, { OPEN,   6,  2,  0 }, { OPEN,   6,  3,  0 },
+    { OPEN,   7,  0,  0 }, { OPEN,   7,  1,  0 }, { OPEN,   7,  2,  0 }, { OPEN,   8,  0,  0 },
+    { OPEN,   8,  1,  0 }, { OPEN,   9,  0,  0 }
+};
+
+const struct frame_code last_frame_codes[LAST_FRAME_CODES] = {
+    { LAST_FRAME,  0,  0,  0 }, { LAST_FRAME,  0,  1,  0 }, { LAST_FRAME,  0,  2,  0 }, { LAST_FRAME,  0,  3,  0 },
+    { LAST_FRAME,  0,  4,  0 }, { LAST_FRAME,  0,  5,  0 }, { LAST_FRAME,  0,  6,  0 }, { LAST_FRAME,  0,  7,  0 },
+    { LAST_FRAME,  0,  8,  0 }, { LAST_FRAME,  0,  9,  0 }, { LAST_FRAME,  0, 10,  0 }, { LAST_FRAME,  0, 10,  1 },
+    { LAST_FRAME,  0, 10,  2 }, { LAST_FRAME,  0, 10,  3 }, { LAST_FRAME,  0, 10,  4 }, { LAST_FRAME,  0, 10,  5 },
+    { LAST_FRAME,  0, 10,  6 }, { LAST_FRAME,  0, 10,  7 }, { LAST_FRAME,  0, 10,  8 }, { LAST_FRAME,  0, 10,  9 },
+    { LAST_FRAME,  0, 10, 10 }, { LAST_FRAME,  1,  0,  0 }, { LAST_FRAME,  1,  1,  0 }, { LAST_FRAME,  1,  2,  0 },
+    { LAST_FRAME,  1,  3,  0 }, { LAST_FRAME,  1,  4,  0 }, { LAST_FRAME,  1,  5,  0 }, { LAST_FRAME,  1,  6,  0 },
+    { LAST_FRAME,  1,  7,  0 }, { LAST_FRAME,  1,  8,  0 }, { LAST_FRAME,  1,  9,  0 }, { LAST_FRAME,  1,  9,  1 },
+    { LAST_FRAME,  1,  9,  2 }, { LAST_FRAME,  1,  9,  3 }, { LAST_FRAME,  1,  9,  4 }, { LAST_FRAME,  1,  9,  5 },
+    { LAST_FRAME,  1,  9,  6 }, { LAST_FRAME,  1,  9,  7 }, { LAST_FRAME,  1,  9,  8 }, { LAST_FRAME,  1,  9,  9 },
+    { LAST_FRAME,  1,  9, 10 }, { LAST_FRAME,  2,  0,  0 }, { LAST_FRAME,  2,  1,  0 }, { LAST_FRAME,  2,  2,  0 },
+    { LAST_FRAME,  2,  3,  0 }, { LAST_FRAME,  2,  4,  0 }, { LAST_FRAME,  2,  5,  0 }, { LAST_FRAME,  2,  6,  0 },
+    { LAST_FRAME,  2,  7,  0 }, { LAST_FRAME,  2,  8,  0 }, { LAST_FRAME,  2,  8,  1 }, { LAST_FRAME,  2,  8,  2 },
+    { LAST_FRAME,  2,  8,  3 }, { LAST_FRAME,  2,  8,  4 }, { LAST_FRAME,  2,  8,  5 }, { LAST_FRAME,  2,  8,  6 },
+    { LAST_FRAME,  2,  8,  7 }, { LAST_FRAME,  2,  8,  8 }, { LAST_FRAME,  2,  8,  9 }, { LAST_FRAME,  2,  8, 10 },
+    { LAST_FRAME,  3,  0,  0 }, { LAST_FRAME,  3,  1,  0 }, { LAST_FRAME,  3,  2,  0 }, { LAST_FRAME,  3,  3,  0 },
+    { LAST_FRAME,  3,  4,  0 }, { LAST_FRAME,  3,  5,  0 }, { LAST_FRAME,  3,  6,  0 }, { LAST_FRAME,  3,  7,  0 },
+    { LAST_FRAME,  3,  7,  1 }, { LAST_FRAME,  3,  7,  2 }, { LAST_FRAME,  3,  7,  3 }, { LAST_FRAME,  3,  7,  4 },
+    { LAST_FRAME,  3,  7,  5 }, { LAST_FRAME,  3,  7,  6 }, { LAST_FRAME,  3,  7,  7 }, { LAST_FRAME,  3,  7,  8 },
+    { LAST_FRAME,  3,  7,  9 }, { LAST_FRAME,  3,  7, 10 }, { LAST_FRAME,  4,  0,  0 }, { LAST_FRAME,  4,  1,  0 },
+    { LAST_FRAME,  4,  2,  0 }, { LAST_FRAME,  4,  3,  0 }, { LAST_FRAME,  4,  4,  0 }, { LAST_FRAME,  4,  5,  0 },
+    { LAST_FRAME,  4,  6,  0 }, { LAST_FRAME,  4,  6,  1 }, { LAST_FRAME,  4,  6,  2 }, { LAST_FRAME,  4,  6,  3 },
+    { LAST_FRAME,  4,  6,  4 }, { LAST_FRAME,  4,  6,  5 }, { LAST_FRAME,  4,  6,  6 }, { LAST_FRAME,  4,  6,  7 },
+    { LAST_FRAME,  4,  6,  8 }, { LAST_FRAME,  4,  6,  9 }, { LAST_FRAME,  4,  6, 10 }, { LAST_FRAME,  5,  0,  0 },
+    { LAST_FRAME,  5,  1,  0 }, { LAST_FRAME,  5,  2,  0 }, { LAST_FRAME,  5,  3,  0 }, { LAST_FRAME,  5,  4,  0 },
+    { LAST_FRAME,  5,  5,  0 }, { LAST_FRAME,  5,  5,  1 }, { LAST_FRAME,  5,  5,  2 }, { LAST_FRAME,  5,  5,  3 },
+    { LAST_FRAME,  5,  5,  4 }, { LAST_FRAME,  5,  5,  5 }, { LAST_FRAME,  5,  5,  6 }, { LAST_FRAME,  5,  5,  7 },
+    { LAST_FRAME,  5,  5,  8 }, { LAST_FRAME,  5,  5,  9 }, { LAST_FRAME,  5,  5, 10 }, { LAST_FRAME,  6,  0,  0 },
+    { LAST_FRAME,  6,  1,  0 }, { LAST_FRAME,  6,  2,  0 }, { LAST_FRAME,  6,  3,  0 }, { LAST_FRAME,  6,  4,  0 },
+    { LAST_FRAME,  6,  4,  1 }, { LAST_FRAME,  6,  4,  2 }, { LAST_FRAME,  6,  4,  3 }, { LAST_FRAME,  6,  4,  4 },
+    { LAST_FRAME,  6,  4,  5 }, { LAST_FRAME,  6,  4,  6 }, { LAST_FRAME,  6,  4,  7 }, { LAST_FRAME,  6,  4,  8 },
+    { LAST_FRAME,  6,  4,  9 }, { LAST_FRAME,  6,  4, 10 }, { LAST_FRAME,  7,  0,  0 }, { LAST_FRAME,  7,  1,  0 },
+    { LAST_FRAME,  7,  2,  0 }, { LAST_FRAME,  7,  3,  0 }, { LAST_FRAME,  7,  3,  1 }, { LAST_FRAME,  7,  3,  2 },
+    { LAST_FRAME,  7,  3,  3 }, { LAST_FRAME,  7,  3,  4 }, { LAST_FRAME,  7,  3,  5 }, { LAST_FRAME,  7,  3,  6 },
+    { LAST_FRAME,  7,  3,  7 }, { LAST_FRAME,  7,  3,  8 }, { LAST_FRAME,  7,  3,  9 }, { LAST_FRAME,  7,  3, 10 },
+    { LAST_FRAME,  8,  0,  0 }, { LAST_FRAME,  8,  1,  0 }, { LAST_FRAME,  8,  2,  0 }, { LAST_FRAME,  8,  2,  1 },
+    { LAST_FRAME,  8,  2,  2 }, { LAST_FRAME,  8,  2,  3 }, { LAST_FRAME,  8,  2,  4 }, { LAST_FRAME,  8,  2,  5 },
+    { LAST_FRAME,  8,  2,  6 }, { LAST_FRAME,  8,  2,  7 }, { LAST_FRAME,  8,  2,  8 }, { LAST_FRAME,  8,  2,  9 },
+    { LAST_FRAME,  8,  2, 10 }, { LAST_FRAME,  9,  0,  0 }, { LAST_FRAME,  9,  1,  0 }, { LAST_FRAME,  9,  1,  1 },
+    { LAST_FRAME,  9,  1,  2 }, { LAST_FRAME,  9,  1,  3 }, { LAST_FRAME,  9,  1,  4 }, { LAST_FRAME,  9,  1,  5 },
+    { LAST_FRAME,  9,  1,  6 }, { LAST_FRAME,  9,  1,  7 }, { LAST_FRAME,  9,  1,  8 }, { LAST_FRAME,  9,  1,  9 },
+    { LAST_FRAME,  9,  1, 10 }, { LAST_FRAME, 10,  0,  0 }, { LAST_FRAME, 10,  0,  1 }, { LAST_FRAME, 10,  0,  2 },
+    { LAST_FRAME, 10,  0,  3 }, { LAST_FRAME, 10,  0,  4 }, { LAST_FRAME, 10,  0,  5 }, { LAST_FRAME, 10,  0,  6 },
+    { LAST_FRAME, 10,  0,  7 }, { LAST_FRAME, 10,  0,  8 }, { LAST_FRAME, 10,  0,  9 }, { LAST_FRAME, 10,  0, 10 },
+    { LAST_FRAME, 10,  1,  0 }, { LAST_FRAME, 10,  1,  1 }, { LAST_FRAME, 10,  1,  2 }, { LAST_FRAME, 10,  1,  3 },
+    { LAST_FRAME, 10,  1,  4 }, { LAST_FRAME, 10,  1,  5 }, { LAST_FRAME, 10,  1,  6 }, { LAST_FRAME, 10,  1,  7 },
+    { LAST_FRAME, 10,  1,  8 }, { LAST_FRAME, 10,  1,  9 }, { LAST_FRAME, 10,  2,  0 }, { LAST_FRAME, 10,  2,  1 },
+    { LAST_FRAME, 10,  2,  2 }, { LAST_FRAME, 10,  2,  3 }, { LAST_FRAME, 10,  2,  4 }, { LAST_FRAME, 10,  2,  5 },
+    { LAST_FRAME, 10,  2,  6 }, { LAST_FRAME, 10,  2,  7 }, { LAST_FRAME, 10,  2,  8 }, { LAST_FRAME, 10,  3,  0 },
+    { LAST_FRAME, 10,  3,  1 }, { LAST_FRAME, 10,  3,  2 }, { LAST_FRAME, 10,  3,  3 }, { LAST_FRAME, 10,  3,  4 },
+    { LAST_FRAME, 10,  3,  5 }, { LAST_FRAME, 10,  3,  6 }, { LAST_FRAME, 10,  3,  7 }, { LAST_FRAME, 10,  4,  0 },
+    { LAST_FRAME, 10,  4,  1 }, { LAST_FRAME, 10,  4,  2 }, { LAST_FRAME, 10,  4,  3 }, { LAST_FRAME, 10,  4,  4 },
+    { LAST_FRAME, 10,  4,  5 }, { LAST_FRAME, 10,  4,  6 }, { LAST_FRAME, 10,  5,  0 }, { LAST_FRAME, 10,  5,  1 },
+    { LAST_FRAME, 10,  5,  2 }, { LAST_FRAME, 10,  5,  3 }, { LAST_FRAME, 10,  5,  4 }, { LAST_FRAME, 10,  5,  5 },
+    { LAST_FRAME, 10,  6,  0 }, { LAST_FRAME, 10,  6,  1 }, { LAST_FRAME, 10,  6,  2 }, { LAST_FRAME, 10,  6,  3 },
+    { LAST_FRAME, 10,  6,  4 }, { LAST_FRAME, 10,  7,  0 }, { LAST_FRAME, 10,  7,  1 }, { LAST_FRAME, 10,  7,  2 },
+    { LAST_FRAME, 10,  7,  3 }, { LAST_FRAME, 10,  8,  0 }, { LAST_FRAME, 10,  8,  1 }, { LAST_FRAME, 10,  8,  2 },
+    { LAST_FRAME, 10,  9,  0 }, { LAST_FRAME, 10,  9,  1 }, { LAST_FRAME, 10, 10,  0 }, { LAST_FRAME, 10, 10,  1 },
+    { LAST_FRAME, 10, 10,  2 }, { LAST_FRAME, 10, 10,  3 }, { LAST_FRAME, 10, 10,  4 }, { LAST_FRAME, 10, 10,  5 },
+    { LAST_FRAME, 10, 10,  6 }, { LAST_FRAME, 10, 10,  7 }, { LAST_FRAME, 10, 10,  8 }, { LAST_FRAME, 10, 10,  9 },
+    { LAST_FRAME, 10, 10, 10 }
+};
+
+/// @brief Position of the 10th frame balls in last_frame_codes, or -1 if not legal
+static int find_last_frame_code(int first_ball, int second_ball, int third_ball)
+{
+    int low = 0, high = LAST_FRAME_CODES - 1;
+    int key = (first_ball * 11 + second_ball) * 11 + third_ball;
+
+    if (first_ball < 0 || first_ball > MAX_PINS || second_ball < 0 || second_ball > MAX_PINS ||
+        third_ball < 0 || third_ball > MAX_PINS)
+        return -1;
+
+    // the table is sorted by ball triple
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        const struct frame_code *c = &last_frame_codes[mid];
+        int mid_key = (c->first_ball * 11 + c->second_ball) * 11 + c->third_ball;
+        if (mid_key == key)
+            return mid;
+        if (mid_key < key)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return -1;
+}
+
+/**
+ * Encodes one frame.
+ *
+ * @param frame The frame to encode
+ * @param frame_number The zero-based index of the frame (0-9)
+ * @param code Receives the frame's code
+ *
+ * @return NO_ERROR, INCOMPLETE_GAME for an UNDEFINED frame, INVALID_PINS if
+ *         the balls aren't a legal outcome, or INVALID_FRAME_TYPE if the
+ *         type doesn't match the balls
+ */
+enum bowling_error encode_frame(const struct frame_results *frame, int frame_number, uint8_t *code)
+{
+    int first_ball = frame->first_ball;
+    int second_ball = frame->second_ball;
+
+    if (frame->type == UNDEFINED)
+        return INCOMPLETE_GAME;
+
+    if (frame_number == MAX_FRAMES - 1)
+    {
+        int found = find_last_frame_code(first_ball, second_ball, frame->third_ball);
+        if (found < 0)
+            return INVALID_PINS;
+        *code = (uint8_t)found;
+        return NO_ERROR;
+    }
+
+    if (first_ball < 0 || first_ball > MAX_PINS || second_ball < 0 || first_ball + second_ball > MAX_PINS)
+        return INVALID_PINS;
+
+    switch (frame->type)
+    {
+    case STRIKE:
+        if (first_ball != MAX_PINS || second_ball != 0)
+            return INVALID_FRAME_TYPE;
+        *code = 0;
+        break;
+    case SPARE:
+        if (first_ball + second_ball != MAX_PINS || first_ball == MAX_PINS)
+            return INVALID_FRAME_TYPE;
+        *code = (uint8_t)(1 + first_ball);
+        break;
+    case OPEN:
+        if (first_ball + second_ball >= MAX_PINS)
+            return INVALID_FRAME_TYPE;
+        // open frames with a smaller first ball come first
+        *code = (uint8_t)(FIRST_OPEN_CODE + first_ball * MAX_PINS - first_ball * (first_ball - 1) / 2 + second_ball);
+        break;
+    default:
+        return INVALID_FRAME_TYPE;
+    }
+    return NO_ERROR;
+}
+
+/// @brief Encode all frames of a game, see encode_frame()
+enum bowling_error encode_game(const struct frame_results frames[MAX_FRAMES], uint8_t codes[MAX_FRAMES])
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        enum bowling_error error = encode_frame(&frames[i], i, &codes[i]);
+        if (error != NO_ERROR)
+            return error;
+    }
+    return NO_ERROR;
+}
+
+/**
+ * Decodes a game.
+ *
+ * @param codes The game's frame codes
+ * @param frames Receives the game, with zero scores
+ * @return NO_ERROR, or INVALID_PINS if a code is out of range
+ */
+enum bowling_error decode_game(const uint8_t codes[MAX_FRAMES], struct frame_results frames[MAX_FRAMES])
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const struct frame_code *c;
+        if (i == MAX_FRAMES - 1)
+        {
+            if (codes[i] >= LAST_FRAME_CODES)
+                return INVALID_PINS;
+            c = &last_frame_codes[codes[i]];
+        }
+        else
+        {
+            if (codes[i] >= REGULAR_FRAME_CODES)
+                return INVALID_PINS;
+            c = &regular_frame_codes[codes[i]];
+        }
+
+        frames[i].type = (enum frame_type)c->type;
+        frames[i].first_ball = c->first_ball;
+        frames[i].second_ball = c->second_ball;
+        frames[i].third_ball = c->third_ball;
+        frames[i].score = 0;
+    }
+    return NO_ERROR;
+}
@@ -0,0 +1,28 @@
+// frame_codes.h
+#ifndef FRAME_CODES_H
+#define FRAME_CODES_H
+
+#include <stdint.h>
+
+#include "bowling_game.h"
+
+#define REGULAR_FRAME_CODES 66  // legal outcomes of frames 1-9
+#define LAST_FRAME_CODES 241    // legal outcomes of the 10th frame
+
+// Balls and type of one frame outcome
+struct frame_code
+{
+    uint8_t type;           // enum frame_type
+    uint8_t first_ball;
+    uint8_t second_ball;
+    uint8_t third_ball;
+};
+
+extern const struct frame_code regular_frame_codes[REGULAR_FRAME_CODES];
+extern const struct frame_code last_frame_codes[LAST_FRAME_CODES];
+
+enum bowling_error encode_frame(const struct frame_results *frame, int frame_number, uint8_t *code);
+enum bowling_error encode_game(const struct frame_results frames[MAX_FRAMES], uint8_t codes[MAX_FRAMES]);
+enum bowling_error decode_game(const uint8_t codes[MAX_FRAMES], struct frame_results frames[MAX_FRAMES]);
+
+#endif // FRAME_CODES_H
@@ -27,6 +27,7 @@
  * - Validates first ball is between 0 and MAX_PINS
  * - If first ball is strike:
  *   - Second and third balls must be between 0 and MAX_PINS
+ *   - If second ball is not a strike, third ball can't exceed remaining pins
  * - If not strike:
  *   - Second ball must be between 0 and remaining pins
  *   - If spare (first + second = MAX_PINS):
@@ -37,76 +38,221 @@
 #include "frame_validator.h"
 #include "bowling_game.h"
 
-enum bowling_error 
-validate_game(struct frame_results frames[MAX_FRAMES])
+/**
+ * Validates a single frame using the rules above.
+ * 
+ * @param frame_number The zero-based index of the frame (0-9)
+ * @param type, first_ball, second_ball, third_ball The frame's results
+ * 
+ * @return NO_ERROR or the first rule the frame breaks
+ */
+enum bowling_error
+validate_frame(int frame_number, enum frame_type type, int first_ball, int second_ball, int third_ball)
 {
-    // Validate each frame
-    for (int i = 0; i < MAX_FRAMES; i++) 
+    // Check if frame was played
+    if (type == UNDEFINED) 
+        return INCOMPLETE_GAME;
+
+    // Regular frames (1-9)
+    if (frame_number < MAX_FRAMES - 1) 
     {
-        // Check if frame was played
-        if (frames[i].type == UNDEFINED) 
-            return INCOMPLETE_GAME;
+        // Validate first ball
+        if (first_ball < 0 || first_ball > MAX_PINS) 
+            return INVALID_PINS;
 
-        // Regular frames (1-9)
-        if (i < 9) 
+        // Validate second ball and frame type
+        switch (type) 
         {
-            // Validate first ball
-            if (frames[i].first_ball < 0 || frames[i].first_ball > MAX_PINS) 
-                return INVALID_PINS;
+            case STRIKE:
+                if (first_ball != MAX_PINS || second_ball != 0) 
+                    return INVALID_FRAME_TYPE;
+                break;
 
-            // Validate second ball and frame type
-            switch (frames[i].type) 
-            {
-                case STRIKE:
-                    if (frames[i].first_ball != MAX_PINS || frames[i].second_ball != 0) 
-                        return INVALID_FRAME_TYPE;
-                    break;
-
-                case SPARE:
-                    if ((frames[i].first_ball + frames[i].second_ball) != MAX_PINS) 
-                        return INVALID_FRAME_TYPE;
-                    break;
-
-                case OPEN:
-                    if ((frames[i].first_ball + frames[i].second_ball) >= MAX_PINS) 
-                        return INVALID_FRAME_TYPE;
-                    break;
-
-                default:
+            case SPARE:
+                if ((first_ball + second_ball) != MAX_PINS) 
                     return INVALID_FRAME_TYPE;
-            }
+                break;
+
+            case OPEN:
+                if ((first_ball + second_ball) >= MAX_PINS) 
+                    return INVALID_FRAME_TYPE;
+                break;
+
+            default:
+                return INVALID_FRAME_TYPE;
+        }
+    }
+    // Last frame (10th)
+    else 
+    {
+        // Validate first ball
+        if (first_ball < 0 || first_ball > MAX_PINS) 
+            return INVALID_PINS;
+
+        // Validate second and third balls based on first ball result
+        if (first_ball == MAX_PINS) 
+        {
+            // Strike on first ball - get two more balls
+            if (second_ball < 0 || second_ball > MAX_PINS ||
+                third_ball < 0 || third_ball > MAX_PINS) 
+                return INVALID_PINS;
+
+            // Third ball only has a fresh rack if the second was a strike
+            if (second_ball != MAX_PINS && third_ball > (MAX_PINS - second_ball))
+                return INVALID_PINS;
         }
-        // Last frame (10th)
         else 
         {
-            // Validate first ball
-            if (frames[i].first_ball < 0 || frames[i].first_ball > MAX_PINS) 
+            // Check second ball doesn't exceed remaining pins
+            if (second_ball < 0 || second_ball > (MAX_PINS - first_ball)) 
                 return INVALID_PINS;
 
-            // Validate second and third balls based on first ball result
-            if (frames[i].first_ball == MAX_PINS) 
-                // Strike on first ball - get two more balls
-                if (frames[i].second_ball < 0 || frames[i].second_ball > MAX_PINS ||
-                    frames[i].third_ball < 0 || frames[i].third_ball > MAX_PINS) 
+            // If spare, get one more ball
+            if (first_ball + second_ball == MAX_PINS) 
+            {
+                if (third_ball < 0 || third_ball > MAX_PINS) 
                     return INVALID_PINS;
+            }
             else 
             {
-                // Check second ball doesn't exceed remaining pins
-                if (frames[i].second_ball < 0 || 
-                    frames[i].second_ball > (MAX_PINS - frames[i].first_ball)) 
+                // No spare, no third ball allowed
+                if (third_ball != 0) 
                     return INVALID_PINS;
-
-                // If spare, get one more ball
-                if (frames[i].first_ball + frames[i].second_ball == MAX_PINS) 
-                    if (frames[i].third_ball < 0 || frames[i].third_ball > MAX_PINS) 
-                        return INVALID_PINS;
-                else 
-                    // No spare, no third ball allowed
-                    if (frames[i].third_ball != 0) 
-                        return INVALID_PINS;
             }
         }
     }
 
     return NO_ERROR;
 }
+
+enum bowling_error 
+validate_game(struct frame_results frames[MAX_FRAMES])
+{
+    // Validate each frame
+    for (int i = 0; i < MAX_FRAMES; i++) 
+    {
+        enum bowling_error error = validate_frame(i, frames[i].type, frames[i].first_ball,
+                                                  frames[i].second_ball, frames[i].third_ball);
+        if (error != NO_ERROR)
+            return error;
+    }
+
+    return NO_ERROR;
+}
+
+/**
+ * Validates every game in a batch using the same rules as validate_game().
+ * 
+ * @param batch The games to validate
+ * @param errors Receives the bowling_error of each game, may be NULL
+ * 
+ * @return The number of games that are not valid
+ * 
+ * Frames are checked one column at a time across all games, so each game
+ * reports the error of its first bad frame, exactly as validate_game() would.
+ * The common case of a valid frame is checked without branches by
+ * packed_frame_valid(); validate_frame() only runs to name the error.
+ */
+size_t
+validate_game_batch(const struct game_batch *batch, uint8_t errors[])
+{
+    static const uint8_t zero_balls[1024];
+    uint8_t local_errors[1024];
+    uint8_t valid[1024];
+    size_t invalid = 0;
+
+    // validate in chunks so a caller that only wants the count needs no buffer
+    for (size_t start = 0; start < batch->count; start += 1024)
+    {
+        size_t end = start + 1024 < batch->count ? start + 1024 : batch->count;
+        uint8_t *chunk = errors ? errors + start : local_errors;
+
+        for (size_t g = start; g < end; g++)
+            chunk[g - start] = NO_ERROR;
+
+        for (int i = 0; i < MAX_FRAMES; i++)
+        {
+            const uint8_t *type = batch->type + BATCH_INDEX(batch, i, 0);
+            const uint8_t *first_ball = batch->first_ball + BATCH_INDEX(batch, i, 0);
+            const uint8_t *second_ball = batch->second_ball + BATCH_INDEX(batch, i, 0);
+
+            // only the 10th frame has a third ball, indexed from the start of the chunk
+            const uint8_t *third_ball = i == MAX_FRAMES - 1 ? batch->third_ball + start : zero_balls;
+
+            // check every game without branches, so the loop vectorizes
+            for (size_t g = start; g < end; g++)
+                valid[g - start] = (uint8_t)packed_frame_valid(i, type[g], first_ball[g], second_ball[g],
+                                                               third_ball[g - start]);
+
+            // almost every frame is valid; only work out which rule failed when one isn't
+            for (size_t g = start; g < end; g++)
+                if (!valid[g - start] && chunk[g - start] == NO_ERROR)
+                    chunk[g - start] = validate_frame(i, (enum frame_type)type[g], first_ball[g],
+                                                      second_ball[g], third_ball[g - start]);
+        }
+
+        for (size_t g = start; g < end; g++)
+            invalid += chunk[g - start] != NO_ERROR;
+    }
+
+    return invalid;
+}
+
+/**
+ * Number of pins standing for the next ball of a frame, following the
+ * rules validate_game() checks.
+ * 
+ * @param frame The frame being bowled, with the balls rolled so far
+ * @param frame_number The zero-based index of the frame (0-9)
+ * @param ball_number The ball about to be rolled (0 first, 1 second, 2 third)
+ * 
+ * @return the pins standing, or -1 if the frame doesn't get that ball
+ */
+int pins_standing(const struct frame_results *frame, int frame_number, int ball_number)
+{
+    if (ball_number == 0)
+        return MAX_PINS;
+
+    // Regular frames (1-9)
+    if (frame_number < MAX_FRAMES - 1) 
+    {
+        if (ball_number > 1 || frame->first_ball == MAX_PINS)
+            return -1;
+        return MAX_PINS - frame->first_ball;
+    }
+
+    // Last frame (10th), a strike or spare sets a fresh rack
+    if (ball_number == 1)
+        return frame->first_ball == MAX_PINS ? MAX_PINS : MAX_PINS - frame->first_ball;
+    if (ball_number == 2)
+    {
+        if (frame->first_ball == MAX_PINS)
+            return frame->second_ball == MAX_PINS ? MAX_PINS : MAX_PINS - frame->second_ball;
+        if (frame->first_ball + frame->second_ball == MAX_PINS)
+            return MAX_PINS;
+    }
+    return -1;
+}
+
+/**
+ * Validates a single ball before it is added to a frame.
+ * 
+ * @param frame The frame being bowled, with the balls rolled so far
+ * @param frame_number The zero-based index of the frame (0-9)
+ * @param ball_number The ball being rolled (0 first, 1 second, 2 third)
+ * @param pins Pins knocked down by the ball
+ * 
+ * @return NO_ERROR, INVALID_PINS if more pins than are standing (or fewer
+ *         than 0) were knocked down, or TOO_MANY_ROLLS if the frame doesn't
+ *         get that ball
+ */
+enum bowling_error validate_roll(const struct frame_results *frame, int frame_number, int ball_number, int pins)
+{
+    int standing = pins_standing(frame, frame_number, ball_number);
+
+    if (standing < 0)
+        return TOO_MANY_ROLLS;
+    if (pins < 0 || pins > standing)
+        return INVALID_PINS;
+    return NO_ERROR;
+}
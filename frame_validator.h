@@ -2,8 +2,37 @@
 #ifndef FRAME_VALIDATOR_H
 #define FRAME_VALIDATOR_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "bowling_game.h"
+#include "game_batch.h"
 
 enum bowling_error validate_game(struct frame_results frames[MAX_FRAMES]);
+enum bowling_error validate_frame(int frame_number, enum frame_type type, int first_ball, int second_ball, int third_ball);
+size_t validate_game_batch(const struct game_batch *batch, uint8_t errors[]);
+int pins_standing(const struct frame_results *frame, int frame_number, int ball_number);
+enum bowling_error validate_roll(const struct frame_results *frame, int frame_number, int ball_number, int pins);
+
+/// @brief Branch-free check that a frame from a game_batch passes validate_frame()
+/// @return 1 if validate_frame() would return NO_ERROR, otherwise 0
+/// Balls from a game_batch are never negative, so only the upper bounds are checked.
+static inline int packed_frame_valid(int frame_number, int type, int first_ball, int second_ball, int third_ball)
+{
+    int pins = first_ball + second_ball;
+
+    if (frame_number < MAX_FRAMES - 1)
+        return (first_ball <= MAX_PINS) &
+               (((type == STRIKE) & (first_ball == MAX_PINS) & (second_ball == 0)) |
+                ((type == SPARE) & (pins == MAX_PINS)) |
+                ((type == OPEN) & (pins < MAX_PINS)));
+
+    // 10th frame, a strike or spare sets a fresh rack
+    int strike = first_ball == MAX_PINS;
+    int third_pins = (strike & (second_ball != MAX_PINS)) ? MAX_PINS - second_ball : MAX_PINS;
+    return (type != UNDEFINED) & (first_ball <= MAX_PINS) &
+           ((strike & (second_ball <= MAX_PINS) & (third_ball <= third_pins)) |
+            ((!strike) & (pins <= MAX_PINS) & ((pins == MAX_PINS) ? (third_ball <= MAX_PINS) : (third_ball == 0))));
+}
 
 #endif // FRAME_VALIDATOR_H
@@ -0,0 +1,130 @@
+/**
+ * @file game_batch.c
+ * @brief Columnar (struct-of-arrays) storage for many games
+ *
+ * A struct frame_results array costs 200 bytes per game and mixes the
+ * fields every pass reads with ones it doesn't. A game_batch stores each
+ * field as its own packed column instead:
+ * - balls and frame types as uint8_t
+ * - frame scores and final scores as uint16_t
+ *
+ * Columns are frame-major: all games' first balls for frame 1, then all
+ * games' first balls for frame 2, and so on. BATCH_INDEX() gives the
+ * position of a frame of a game. A pass over one frame of every game,
+ * which is what validate_game_batch() and calculate_game_scores_batch()
+ * do, therefore reads memory sequentially.
+ *
+ * The rolled balls take 31 bytes per game and the scores 22 more, about
+ * a quarter of the struct frame_results layout.
+ *
+ * Usage Example:
+ * @code
+ * struct game_batch batch;
+ * if (game_batch_init(&batch, 4096)) {
+ *     game_batch_add(&batch, frames);       // once per game
+ *     validate_game_batch(&batch, errors);
+ *     calculate_game_scores_batch(&batch);
+ *     game_batch_free(&batch);
+ * }
+ * @endcode
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "game_batch.h"
+
+/// @brief Allocate the columns for a batch of games
+/// @param batch
+/// @param capacity maximum number of games the batch can hold
+/// @return 1 if good or 0 if memory could not be allocated
+int game_batch_init(struct game_batch *batch, size_t capacity)
+{
+    size_t columns = capacity * MAX_FRAMES;
+
+    memset(batch, 0, sizeof(*batch));
+    batch->capacity = capacity;
+    batch->first_ball = malloc(columns);
+    batch->second_ball = malloc(columns);
+    batch->third_ball = malloc(capacity);
+    batch->type = malloc(columns);
+    batch->score = malloc(columns * sizeof(uint16_t));
+    batch->total = malloc(capacity * sizeof(uint16_t));
+
+    if (!batch->first_ball || !batch->second_ball || !batch->third_ball ||
+        !batch->type || !batch->score || !batch->total)
+    {
+        game_batch_free(batch);
+        return 0;
+    }
+    return 1;
+}
+
+/// @brief Release the columns of a batch
+void game_batch_free(struct game_batch *batch)
+{
+    free(batch->first_ball);
+    free(batch->second_ball);
+    free(batch->third_ball);
+    free(batch->type);
+    free(batch->score);
+    free(batch->total);
+    memset(batch, 0, sizeof(*batch));
+}
+
+/// @brief Remove all games, keeping the columns for reuse
+void game_batch_clear(struct game_batch *batch)
+{
+    batch->count = 0;
+}
+
+static int fits_column(int pins)
+{
+    return pins >= 0 && pins <= UINT8_MAX;
+}
+
+/// @brief Append a game to the batch
+/// @param batch
+/// @param frames the game's frames, scores are not copied
+/// @return 1 if good or 0 if the batch is full or a ball can't be stored in a byte
+int game_batch_add(struct game_batch *batch, const struct frame_results frames[MAX_FRAMES])
+{
+    if (batch->count == batch->capacity)
+        return 0;
+
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (!fits_column(frames[i].first_ball) || !fits_column(frames[i].second_ball))
+            return 0;
+    if (!fits_column(frames[MAX_FRAMES - 1].third_ball))
+        return 0;
+
+    size_t game = batch->count++;
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        size_t at = BATCH_INDEX(batch, i, game);
+        batch->first_ball[at] = (uint8_t)frames[i].first_ball;
+        batch->second_ball[at] = (uint8_t)frames[i].second_ball;
+        batch->type[at] = (uint8_t)frames[i].type;
+        batch->score[at] = 0;
+    }
+    batch->third_ball[game] = (uint8_t)frames[MAX_FRAMES - 1].third_ball;
+    batch->total[game] = 0;
+    return 1;
+}
+
+/// @brief Copy a game, including its scores, out of the batch
+/// @param batch
+/// @param game index of the game, less than batch->count
+/// @param frames receives the game's frames
+void game_batch_get(const struct game_batch *batch, size_t game, struct frame_results frames[MAX_FRAMES])
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        size_t at = BATCH_INDEX(batch, i, game);
+        frames[i].type = (enum frame_type)batch->type[at];
+        frames[i].first_ball = batch->first_ball[at];
+        frames[i].second_ball = batch->second_ball[at];
+        frames[i].third_ball = 0;
+        frames[i].score = batch->score[at];
+    }
+    frames[MAX_FRAMES - 1].third_ball = batch->third_ball[game];
+}
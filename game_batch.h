@@ -0,0 +1,31 @@
+// game_batch.h
+#ifndef GAME_BATCH_H
+#define GAME_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bowling_game.h"
+
+// Column index of a frame of a game, columns are frame-major
+#define BATCH_INDEX(batch, frame, game) ((size_t)(frame) * (batch)->capacity + (game))
+
+struct game_batch
+{
+    size_t count;           // games stored
+    size_t capacity;        // games allocated, also the stride between frame columns
+    uint8_t *first_ball;    // pins for first ball, [frame][game]
+    uint8_t *second_ball;   // pins for second ball, [frame][game]
+    uint8_t *third_ball;    // pins for third ball of the 10th frame, [game]
+    uint8_t *type;          // enum frame_type, [frame][game]
+    uint16_t *score;        // calculated points for each frame, [frame][game]
+    uint16_t *total;        // final score, [game]
+};
+
+int game_batch_init(struct game_batch *batch, size_t capacity);
+void game_batch_free(struct game_batch *batch);
+void game_batch_clear(struct game_batch *batch);
+int game_batch_add(struct game_batch *batch, const struct frame_results frames[MAX_FRAMES]);
+void game_batch_get(const struct game_batch *batch, size_t game, struct frame_results frames[MAX_FRAMES]);
+
+#endif // GAME_BATCH_H
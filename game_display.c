@@ -29,6 +29,9 @@
  * - report_game_scores(): Displays scoring for a complete game
  * - print_frame(): Formats and displays a single frame's scoring
  * 
+ * Both write to the stream they are given and keep no state, so threads
+ * can display games to their own streams at once.
+ * 
  * Note: All functions assume input data has been properly validated
  * before display. The file focuses solely on display formatting and
  * does not perform validation of bowling scores or game rules.
@@ -42,6 +45,7 @@
  * 
  * @param frames An array of frame_results structures containing the scoring data
  *              for all 10 frames of a bowling game
+ * @param out The stream to print to
  * 
  * The function prints each frame's details in the following format:
  * - For regular frames (1-9):
@@ -73,13 +77,13 @@
  * Note: This function assumes the frames array contains valid bowling scores
  * that have already been validated and scored correctly.
  */
-void report_game_scores(struct frame_results frames[MAX_FRAMES])
+void report_game_scores(struct frame_results frames[MAX_FRAMES], FILE *out)
 {
     int total = 0;
     for (int i = 0; i < MAX_FRAMES; i++)
     {
         total += frames[i].score;
-        print_frame(frames[i], i, total);
+        print_frame(frames[i], i, total, out);
     }
 }
  
@@ -89,6 +93,7 @@ void report_game_scores(struct frame_results frames[MAX_FRAMES])
  * @param frame The frame_results structure containing the scoring data for a single frame
  * @param frame_number The zero-based index of the frame (0-9)
  * @param subtotal The running total score up to and including this frame
+ * @param out The stream to print to
  * 
  * Output Format:
  * The function formats the output differently based on frame type and position:
@@ -122,27 +127,27 @@ void report_game_scores(struct frame_results frames[MAX_FRAMES])
  * Note: This function assumes the frame_results structure contains valid data
  * that has been previously validated.
  */
-void print_frame(struct frame_results frame, int frame_number, int subtotal)
+void print_frame(struct frame_results frame, int frame_number, int subtotal, FILE *out)
 {
     if (frame_number == MAX_FRAMES - 1) // last frame
     {
-        printf("Frame %2d: %2d %2d %2d = %2d = %3d\n", frame_number+1, frame.first_ball, frame.second_ball, frame.third_ball, frame.score, subtotal);
+        fprintf(out, "Frame %2d: %2d %2d %2d = %2d = %3d\n", frame_number+1, frame.first_ball, frame.second_ball, frame.third_ball, frame.score, subtotal);
         return;
     }
 
     switch (frame.type)
     {
     case STRIKE:
-        printf("Frame %2d: %2d  -  X = %2d = %3d\n", frame_number+1, frame.first_ball, frame.score, subtotal);
+        fprintf(out, "Frame %2d: %2d  -  X = %2d = %3d\n", frame_number+1, frame.first_ball, frame.score, subtotal);
         break;
     case SPARE:
-        printf("Frame %2d: %2d %2d  / = %2d = %3d\n", frame_number+1, frame.first_ball, frame.second_ball, frame.score, subtotal);
+        fprintf(out, "Frame %2d: %2d %2d  / = %2d = %3d\n", frame_number+1, frame.first_ball, frame.second_ball, frame.score, subtotal);
         break;
     case OPEN:
-        printf("Frame %2d: %2d %2d  - = %2d = %3d\n", frame_number+1, frame.first_ball, frame.second_ball, frame.score, subtotal);
+        fprintf(out, "Frame %2d: %2d %2d  - = %2d = %3d\n", frame_number+1, frame.first_ball, frame.second_ball, frame.score, subtotal);
         break;
     default:
-        printf("Error: unknown frame type\n");
+        fprintf(out, "Error: unknown frame type\n");
         break;
     }
 };
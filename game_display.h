@@ -2,9 +2,11 @@
 #ifndef GAME_DISPLAY_H
 #define GAME_DISPLAY_H
 
+#include <stdio.h>
+
 #include "bowling_game.h"
 
-void print_frame(struct frame_results frame, int frame_number, int subtotal);
-void report_game_scores(struct frame_results frames[MAX_FRAMES]);
+void print_frame(struct frame_results frame, int frame_number, int subtotal, FILE *out);
+void report_game_scores(struct frame_results frames[MAX_FRAMES], FILE *out);
 
 #endif // GAME_DISPLAY_H
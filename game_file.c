@@ -0,0 +1,376 @@
+/**
+ * @file game_file.c
+ * @brief Compact binary game files with O(1) access to any game
+ *
+ * Every frame is stored as its one-byte frame code (frame_codes.c), so a
+ * game takes GAME_FILE_RECORD_SIZE (10) bytes instead of the 200 bytes of
+ * struct frame_results[MAX_FRAMES], or about 300 bytes of
+ * report_game_scores() text.
+ *
+ * File layout (integers little-endian):
+ * @code
+ * offset  size  field
+ *      0     8  magic "BOWLGAME"
+ *      8     4  format version (1)
+ *     12     4  record size in bytes (10)
+ *     16     8  number of games
+ *     24     8  reserved (0)
+ *     32        games, one record each
+ * @endcode
+ *
+ * Records are all the same size, so the offset index is arithmetic:
+ * game k starts at GAME_FILE_HEADER_SIZE + k * GAME_FILE_RECORD_SIZE.
+ * The reader memory-maps the file and game_file_codes() returns a pointer
+ * straight into the mapping.
+ *
+ * The writer goes through stdio and fills in the game count when it is
+ * finished, so a file that was never finished reads as empty.
+ *
+ * pack_game_text() and unpack_game_file() convert to and from the text
+ * printed by report_game_scores(); unpack_game_file() can also print the
+ * other game_renderer formats.
+ *
+ * The records are scored straight from their codes with the lookup-table
+ * scorer (score_calculator_codes.c); score_game_file() tallies a whole
+ * file's final scores without decoding a single frame.
+ */
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "game_file.h"
+#include "frame_codes.h"
+#include "score_calculator.h"
+#include "game_render.h"
+
+#define GAME_FILE_MAGIC "BOWLGAME"
+#define GAME_FILE_VERSION 1
+#define SCORE_CHUNK 4096    // games scored together by score_game_file()
+
+static void put_le(uint8_t *p, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        p[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= (uint64_t)p[i] << (8 * i);
+    return value;
+}
+
+/// @brief Fill in a file header for 'count' games, for writers that don't go through game_file_create()
+void game_file_header(uint8_t header[GAME_FILE_HEADER_SIZE], uint64_t count)
+{
+    memset(header, 0, GAME_FILE_HEADER_SIZE);
+    memcpy(header, GAME_FILE_MAGIC, 8);
+    put_le(header + 8, GAME_FILE_VERSION, 4);
+    put_le(header + 12, GAME_FILE_RECORD_SIZE, 4);
+    put_le(header + 16, count, 8);
+}
+
+static int write_header(FILE *file, uint64_t count)
+{
+    uint8_t header[GAME_FILE_HEADER_SIZE];
+
+    game_file_header(header, count);
+    return fwrite(header, sizeof(header), 1, file) == 1;
+}
+
+/// @brief Create a game file, replacing any existing one
+/// @return 1 if good or 0 if the file can't be written
+int game_file_create(struct game_file_writer *writer, const char *path)
+{
+    writer->count = 0;
+    writer->file = fopen(path, "wb");
+    if (!writer->file)
+        return 0;
+    if (!write_header(writer->file, 0))
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Appends a game.
+ *
+ * @return NO_ERROR, the encode_game() error if the game isn't legal (nothing
+ *         is written), or INVALID_PINS if the write fails
+ */
+enum bowling_error game_file_write(struct game_file_writer *writer, const struct frame_results frames[MAX_FRAMES])
+{
+    uint8_t codes[GAME_FILE_RECORD_SIZE];
+
+    enum bowling_error error = encode_game(frames, codes);
+    if (error != NO_ERROR)
+        return error;
+    if (fwrite(codes, sizeof(codes), 1, writer->file) != 1)
+        return INVALID_PINS;
+
+    writer->count++;
+    return NO_ERROR;
+}
+
+/// @brief Record the game count and close the file
+/// @return 1 if good or 0 if the file couldn't be completed
+int game_file_finish(struct game_file_writer *writer)
+{
+    int good = fseek(writer->file, 0, SEEK_SET) == 0 && write_header(writer->file, writer->count);
+    good = fclose(writer->file) == 0 && good;
+    writer->file = NULL;
+    return good;
+}
+
+/// @brief Map a game file for reading
+/// @return 1 if good or 0 if it can't be read or isn't a valid game file
+int game_file_open(struct game_file *file, const char *path)
+{
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    memset(file, 0, sizeof(*file));
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &info) != 0 || info.st_size < GAME_FILE_HEADER_SIZE)
+    {
+        close(fd);
+        return 0;
+    }
+
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return 0;
+
+    file->data = data;
+    file->size = (size_t)info.st_size;
+    file->count = get_le(file->data + 16, 8);
+
+    uint64_t records = (file->size - GAME_FILE_HEADER_SIZE) / GAME_FILE_RECORD_SIZE;
+    if (memcmp(file->data, GAME_FILE_MAGIC, 8) != 0 ||
+        get_le(file->data + 8, 4) != GAME_FILE_VERSION ||
+        get_le(file->data + 12, 4) != GAME_FILE_RECORD_SIZE ||
+        file->count > records)
+    {
+        game_file_close(file);
+        return 0;
+    }
+    return 1;
+}
+
+/// @brief The frame codes of game k, or NULL if there is no such game
+const uint8_t *game_file_codes(const struct game_file *file, uint64_t game)
+{
+    if (game >= file->count)
+        return NULL;
+    return file->data + GAME_FILE_HEADER_SIZE + game * GAME_FILE_RECORD_SIZE;
+}
+
+/**
+ * Reads game k.
+ *
+ * @return NO_ERROR, INCOMPLETE_GAME if there is no such game, or
+ *         INVALID_PINS if the record holds an invalid code
+ */
+enum bowling_error game_file_read(const struct game_file *file, uint64_t game, struct frame_results frames[MAX_FRAMES])
+{
+    const uint8_t *codes = game_file_codes(file, game);
+    if (!codes)
+        return INCOMPLETE_GAME;
+    return decode_game(codes, frames);
+}
+
+void game_file_close(struct game_file *file)
+{
+    if (file->data)
+        munmap((void *)file->data, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+/**
+ * Parses one "Frame N: ..." line printed by print_frame().
+ *
+ * @return the zero-based frame number, or -1 if the line isn't a frame line
+ */
+static int parse_frame_line(const char *line, struct frame_results *frame)
+{
+    char balls[3][8];
+    int frame_number;
+
+    if (sscanf(line, " Frame %d: %7s %7s %7s", &frame_number, balls[0], balls[1], balls[2]) != 4 ||
+        frame_number < 1 || frame_number > MAX_FRAMES)
+        return -1;
+
+    frame->first_ball = atoi(balls[0]);
+    frame->second_ball = atoi(balls[1]);
+    frame->third_ball = 0;
+    frame->score = 0;
+
+    if (frame_number == MAX_FRAMES)
+    {
+        frame->type = LAST_FRAME;
+        frame->third_ball = atoi(balls[2]);
+    }
+    else if (strcmp(balls[2], "X") == 0)
+    {
+        frame->type = STRIKE;
+        frame->second_ball = 0;
+    }
+    else if (strcmp(balls[2], "/") == 0)
+        frame->type = SPARE;
+    else if (strcmp(balls[2], "-") == 0)
+        frame->type = OPEN;
+    else
+        return -1;
+
+    return frame_number - 1;
+}
+
+/**
+ * Converts report_game_scores() text to a game file.
+ *
+ * @param text_path text with one or more games of ten "Frame" lines each;
+ *                  other lines are ignored
+ * @param game_path game file to create
+ * @param games receives the number of games written
+ * @return 1 if good or 0 if a file can't be used or a game is out of order or illegal
+ */
+int pack_game_text(const char *text_path, const char *game_path, uint64_t *games)
+{
+    struct game_file_writer writer;
+    struct frame_results frames[MAX_FRAMES];
+    char line[256];
+    int expected = 0;
+    int good = 1;
+
+    *games = 0;
+    FILE *text = fopen(text_path, "r");
+    if (!text)
+        return 0;
+    if (!game_file_create(&writer, game_path))
+    {
+        fclose(text);
+        return 0;
+    }
+
+    while (good && fgets(line, sizeof(line), text))
+    {
+        struct frame_results frame;
+        int frame_number = parse_frame_line(line, &frame);
+        if (frame_number < 0)
+            continue;
+
+        if (frame_number != expected)
+        {
+            good = 0;
+            break;
+        }
+        frames[frame_number] = frame;
+        expected++;
+
+        if (expected == MAX_FRAMES)
+        {
+            good = game_file_write(&writer, frames) == NO_ERROR;
+            expected = 0;
+        }
+    }
+
+    good = expected == 0 && good;
+    good = game_file_finish(&writer) && good;
+    *games = writer.count;
+    fclose(text);
+    return good;
+}
+
+/**
+ * Prints games from a game file with a game_renderer.
+ *
+ * @param game_path game file to read
+ * @param game index of the one game to print, or -1 for all of them
+ * @param format output format, RENDER_HUMAN for the report_game_scores() layout
+ *
+ * A record that doesn't decode, such as the all 0xff record written for
+ * an invalid game, is printed as an invalid game and the rest follow.
+ *
+ * @return 1 if good or 0 if the file can't be read, the game doesn't exist
+ *         or the output can't be written
+ */
+int unpack_game_file(const char *game_path, long long game, enum render_format format)
+{
+    struct game_file file;
+    struct game_renderer render;
+    struct frame_results frames[MAX_FRAMES];
+    int scores[MAX_FRAMES];
+    int total;
+    int good;
+
+    if (!game_file_open(&file, game_path))
+        return 0;
+    if ((game >= 0 && (uint64_t)game >= file.count) || !renderer_init(&render, STDOUT_FILENO, format, NULL))
+    {
+        game_file_close(&file);
+        return 0;
+    }
+
+    uint64_t first = game < 0 ? 0 : (uint64_t)game;
+    uint64_t last = game < 0 ? file.count : first + 1;
+    render_header(&render, last - first);
+    for (uint64_t k = first; k < last; k++)
+    {
+        enum bowling_error error = game_file_read(&file, k, frames);
+        if (error == NO_ERROR)
+            error = score_game_codes(game_file_codes(&file, k), scores, &total);
+        for (int i = 0; i < MAX_FRAMES && error == NO_ERROR; i++)
+            frames[i].score = scores[i];
+        render_game(&render, k, frames, error);
+    }
+
+    good = renderer_finish(&render);
+    game_file_close(&file);
+    return good;
+}
+
+/**
+ * Tallies the final scores of every game in a game file, scoring the
+ * records in place from their frame codes.
+ *
+ * @param game_path game file to read
+ * @param histogram receives the number of valid games with each final score
+ * @param games receives the number of games in the file
+ * @param invalid_games receives the number of records holding an invalid code
+ * @return 1 if good or 0 if the file can't be read
+ */
+int score_game_file(const char *game_path, unsigned long long histogram[MAX_SCORE + 1], uint64_t *games,
+                    uint64_t *invalid_games)
+{
+    struct game_file file;
+    uint16_t totals[SCORE_CHUNK];
+    uint8_t errors[SCORE_CHUNK];
+
+    memset(histogram, 0, (MAX_SCORE + 1) * sizeof(histogram[0]));
+    *games = 0;
+    *invalid_games = 0;
+    if (!game_file_open(&file, game_path))
+        return 0;
+
+    for (uint64_t first = 0; first < file.count; first += SCORE_CHUNK)
+    {
+        size_t count = file.count - first < SCORE_CHUNK ? (size_t)(file.count - first) : SCORE_CHUNK;
+        *invalid_games += score_game_codes_batch(game_file_codes(&file, first), GAME_FILE_RECORD_SIZE, count,
+                                                 totals, errors);
+        for (size_t g = 0; g < count; g++)
+            histogram[totals[g]] += errors[g] == NO_ERROR;
+    }
+
+    *games = file.count;
+    game_file_close(&file);
+    return 1;
+}
@@ -0,0 +1,43 @@
+// game_file.h
+#ifndef GAME_FILE_H
+#define GAME_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "game_render.h"
+
+#define GAME_FILE_HEADER_SIZE 32
+#define GAME_FILE_RECORD_SIZE MAX_FRAMES    // one frame code per frame
+
+struct game_file_writer
+{
+    FILE *file;
+    uint64_t count;         // games written so far
+};
+
+struct game_file
+{
+    const uint8_t *data;    // the whole mapped file
+    size_t size;
+    uint64_t count;         // games in the file
+};
+
+void game_file_header(uint8_t header[GAME_FILE_HEADER_SIZE], uint64_t count);
+int game_file_create(struct game_file_writer *writer, const char *path);
+enum bowling_error game_file_write(struct game_file_writer *writer, const struct frame_results frames[MAX_FRAMES]);
+int game_file_finish(struct game_file_writer *writer);
+
+int game_file_open(struct game_file *file, const char *path);
+const uint8_t *game_file_codes(const struct game_file *file, uint64_t game);
+enum bowling_error game_file_read(const struct game_file *file, uint64_t game, struct frame_results frames[MAX_FRAMES]);
+void game_file_close(struct game_file *file);
+
+int pack_game_text(const char *text_path, const char *game_path, uint64_t *games);
+int unpack_game_file(const char *game_path, long long game, enum render_format format);
+int score_game_file(const char *game_path, unsigned long long histogram[MAX_SCORE + 1], uint64_t *games,
+                    uint64_t *invalid_games);
+
+#endif // GAME_FILE_H
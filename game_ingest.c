@@ -0,0 +1,338 @@
+/**
+ * @file game_ingest.c
+ * @brief Streaming ingest and re-scoring of recorded games
+ *
+ * Reads recorded games, one per line, validates and scores them, and
+ * writes one result line per game.
+ *
+ * Input format:
+ * Each line holds the pins knocked down by every ball of one game, in
+ * order, separated by spaces, tabs or commas. Blank lines and lines
+ * starting with '#' are skipped.
+ * @code
+ * 10 7 3 9 0 10 0 8 8 2 0 6 10 10 10 8 1
+ * @endcode
+ *
+ * Output format, numbered by input line:
+ * @code
+ * 1 167
+ * 2 error incomplete game
+ * @endcode
+ * where the error is named by bowling_error_name(), as in the single game
+ * program's messages.
+ *
+ * Pipeline:
+ * 1. The input is memory-mapped (or, for "-", read from stdin in 1 MB
+ *    blocks) and parsed in place; no memory is allocated per line
+ * 2. frames_from_rolls() splits each line's rolls into frames, and the
+ *    game is appended to a game_batch
+ * 3. When the batch is full, validate_game_batch() and
+ *    calculate_game_scores_batch() run over the whole batch and the
+ *    results are written out
+ *
+ * Games of the other variants in bowling_variants.h are scored line by
+ * line with variant_score_rolls() instead.
+ *
+ * ingest_each_game() reads tenpin games the same way but hands each
+ * scored game to a callback instead of writing a result line, for
+ * callers that want the games themselves (calibration.c).
+ *
+ * With BOWLING_STATS, validation, scoring and writing out are timed a
+ * batch at a time (bowling_stats.c); the writes go to a stdio buffer, so
+ * the output stage only shows the cost of the write calls when it fills.
+ */
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "game_ingest.h"
+#include "game_batch.h"
+#include "frame_validator.h"
+#include "score_calculator.h"
+#include "bowling_variants.h"
+#include "bowling_stats.h"
+
+#define INGEST_BATCH 4096
+#define READ_BLOCK (1 << 20)
+
+struct ingest_state
+{
+    struct game_batch batch;
+    unsigned long long line_number[INGEST_BATCH];  // input line of each game in the batch
+    uint8_t parse_error[INGEST_BATCH];             // error from frames_from_rolls()
+    uint8_t errors[INGEST_BATCH];                  // error from validate_game_batch()
+    unsigned long long line;                       // lines read so far
+    enum bowling_variant variant;
+    FILE *out;
+    ingest_game_fn each;                           // if set, gets the games instead of out
+    void *context;
+    struct ingest_results *results;
+};
+
+/// @brief Validate, score and write out the games in the batch, then empty it
+static void flush_batch(struct ingest_state *state)
+{
+    struct game_batch *batch = &state->batch;
+
+    STATS_START(validate);
+    validate_game_batch(batch, state->errors);
+    STATS_STOP(STAGE_VALIDATE, validate, batch->count);
+    STATS_START(score);
+    calculate_game_scores_batch(batch);
+    STATS_STOP(STAGE_SCORE, score, batch->count);
+
+    STATS_START(output);
+    for (size_t g = 0; g < batch->count; g++)
+    {
+        int error = state->parse_error[g] != NO_ERROR ? state->parse_error[g] : state->errors[g];
+        if (state->each)
+        {
+            struct frame_results frames[MAX_FRAMES];
+            game_batch_get(batch, g, frames);
+            state->each(state->context, state->line_number[g], frames, (enum bowling_error)error);
+        }
+        if (error != NO_ERROR)
+        {
+            state->results->invalid_games++;
+            STATS_ERROR(error);
+            if (state->out)
+                fprintf(state->out, "%llu error %s\n", state->line_number[g], bowling_error_name(error));
+        }
+        else if (state->out)
+            fprintf(state->out, "%llu %u\n", state->line_number[g], batch->total[g]);
+    }
+    STATS_STOP(STAGE_OUTPUT, output, batch->count);
+    state->results->games += batch->count;
+    game_batch_clear(batch);
+    STATS_POLL();
+}
+
+static int is_separator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+/// @brief Parse one line (without its newline) and add the game to the batch
+static void ingest_line(struct ingest_state *state, const char *p, const char *end)
+{
+    uint8_t rolls[VARIANT_MAX_ROLLS] = { 0 };
+    int count = 0;
+    int too_many = 0;
+    int bad_token = 0;
+
+    state->line++;
+
+    while (p < end && is_separator(*p))
+        p++;
+    if (p == end || *p == '#')
+        return;
+
+    while (p < end)
+    {
+        unsigned pins = 0;
+        const char *start = p;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            if (pins <= UINT8_MAX)
+                pins = pins * 10 + (unsigned)(*p - '0');
+            p++;
+        }
+        if (p == start || (p < end && !is_separator(*p)))
+        {
+            bad_token = 1;
+            break;
+        }
+
+        if (count < VARIANT_MAX_ROLLS)
+            rolls[count++] = pins > UINT8_MAX ? UINT8_MAX : (uint8_t)pins;
+        else
+            too_many = 1;
+
+        while (p < end && is_separator(*p))
+            p++;
+    }
+
+    if (state->variant != VARIANT_TENPIN)
+    {
+        int frame_scores[MAX_FRAMES];
+        int total = 0;
+        enum bowling_error error = variant_score_rolls(state->variant, rolls, count, frame_scores, &total);
+        if (bad_token)
+            error = INVALID_PINS;
+        else if (too_many)
+            error = TOO_MANY_ROLLS;
+
+        state->results->games++;
+        if (error != NO_ERROR)
+        {
+            state->results->invalid_games++;
+            STATS_ERROR(error);
+            fprintf(state->out, "%llu error %s\n", state->line, bowling_error_name(error));
+        }
+        else
+            fprintf(state->out, "%llu %d\n", state->line, total);
+        return;
+    }
+
+    struct frame_results frames[MAX_FRAMES];
+    enum bowling_error error = frames_from_rolls(rolls, count, frames);
+    if (bad_token)
+        error = INVALID_PINS;
+    else if (too_many)
+        error = TOO_MANY_ROLLS;
+
+    size_t game = state->batch.count;
+    game_batch_add(&state->batch, frames);
+    state->line_number[game] = state->line;
+    state->parse_error[game] = (uint8_t)error;
+
+    if (state->batch.count == INGEST_BATCH)
+        flush_batch(state);
+}
+
+/// @brief Ingest every complete line in data, and the unterminated last one if final
+/// @return number of bytes used
+static size_t ingest_buffer(struct ingest_state *state, const char *data, size_t length, int final)
+{
+    const char *p = data;
+    const char *end = data + length;
+
+    while (p < end)
+    {
+        const char *newline = memchr(p, '\n', (size_t)(end - p));
+        if (!newline)
+        {
+            if (!final)
+                break;
+            newline = end;
+        }
+        ingest_line(state, p, newline);
+        p = newline < end ? newline + 1 : end;
+    }
+    return (size_t)(p - data);
+}
+
+static int ingest_stream(struct ingest_state *state, int fd)
+{
+    char *buffer = malloc(READ_BLOCK);
+    size_t held = 0;
+    int good = 1;
+
+    if (!buffer)
+        return 0;
+
+    for (;;)
+    {
+        ssize_t got = read(fd, buffer + held, READ_BLOCK - held);
+        if (got < 0)
+        {
+            good = 0;
+            break;
+        }
+        held += (size_t)got;
+
+        size_t used = ingest_buffer(state, buffer, held, got == 0);
+        // a line longer than the whole buffer is taken as it is
+        if (used == 0 && held == READ_BLOCK)
+            used = ingest_buffer(state, buffer, held, 1);
+        memmove(buffer, buffer + used, held - used);
+        held -= used;
+
+        if (got == 0)
+            break;
+    }
+
+    free(buffer);
+    return good;
+}
+
+static int ingest_mapped(struct ingest_state *state, int fd)
+{
+    struct stat info;
+
+    if (fstat(fd, &info) != 0)
+        return 0;
+    if (info.st_size == 0)
+        return 1;
+    if (!S_ISREG(info.st_mode))
+        return ingest_stream(state, fd);
+
+    char *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+        return ingest_stream(state, fd);
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    ingest_buffer(state, data, (size_t)info.st_size, 1);
+
+    munmap(data, (size_t)info.st_size);
+    return 1;
+}
+
+/// @brief Read every game in path, writing result lines to out or handing the games to each
+static int ingest(const char *path, FILE *out, ingest_game_fn each, void *context, enum bowling_variant variant,
+                  struct ingest_results *results)
+{
+    struct ingest_state *state = malloc(sizeof(*state));
+    int good;
+
+    memset(results, 0, sizeof(*results));
+    if (!state)
+        return 0;
+    if (!game_batch_init(&state->batch, INGEST_BATCH))
+    {
+        free(state);
+        return 0;
+    }
+    state->line = 0;
+    state->variant = variant;
+    state->out = out;
+    state->each = each;
+    state->context = context;
+    state->results = results;
+
+    if (strcmp(path, "-") == 0)
+        good = ingest_stream(state, STDIN_FILENO);
+    else
+    {
+        int fd = open(path, O_RDONLY);
+        good = fd >= 0 && ingest_mapped(state, fd);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    flush_batch(state);
+    game_batch_free(&state->batch);
+    free(state);
+    return good;
+}
+
+/**
+ * Validates and scores every game recorded in a file.
+ *
+ * @param path file to read, or "-" for stdin
+ * @param out where the result lines are written
+ * @param variant rules the games were bowled under
+ * @param results receives the number of games read and how many were invalid
+ * @return 1 if good or 0 if the file can't be read or memory can't be allocated
+ */
+int ingest_games(const char *path, FILE *out, enum bowling_variant variant, struct ingest_results *results)
+{
+    return ingest(path, out, NULL, NULL, variant, results);
+}
+
+/**
+ * Validates and scores every tenpin game recorded in a file and passes
+ * each one to a callback, in file order.
+ *
+ * @param path file to read, or "-" for stdin
+ * @param each called with every game, valid or not
+ * @param results receives the number of games read and how many were invalid
+ * @return 1 if good or 0 if the file can't be read or memory can't be allocated
+ */
+int ingest_each_game(const char *path, ingest_game_fn each, void *context, struct ingest_results *results)
+{
+    return ingest(path, NULL, each, context, VARIANT_TENPIN, results);
+}
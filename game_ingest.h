@@ -0,0 +1,23 @@
+// game_ingest.h
+#ifndef GAME_INGEST_H
+#define GAME_INGEST_H
+
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "bowling_variants.h"
+
+struct ingest_results
+{
+    unsigned long long games;           // game lines read
+    unsigned long long invalid_games;   // games that failed parsing or validation
+};
+
+// called by ingest_each_game() for every game line, in order; frames are scored unless error is set
+typedef void (*ingest_game_fn)(void *context, unsigned long long line, const struct frame_results frames[MAX_FRAMES],
+                               enum bowling_error error);
+
+int ingest_games(const char *path, FILE *out, enum bowling_variant variant, struct ingest_results *results);
+int ingest_each_game(const char *path, ingest_game_fn each, void *context, struct ingest_results *results);
+
+#endif // GAME_INGEST_H
@@ -0,0 +1,439 @@
+/**
+ * @file game_render.c
+ * @brief Buffered output of scored games in several formats
+ *
+ * report_game_scores() makes one printf() call per frame, parsing the
+ * format string every time, which costs more than playing the game. A
+ * game_renderer formats games into a 1 MB buffer with its own integer
+ * formatting and hands the buffer to write() whenever it is nearly full.
+ *
+ * Formats (see render_format_from_name() for the command line names):
+ * - human: the report_game_scores() layout, with a blank line between
+ *   games; an invalid game prints "Error: N"
+ * - csv: a header row from render_header(), then one row per game
+ *   @code
+ *   game,error,total,score_1,...,score_10,rolls
+ *   0,0,135,9,20,...,8,9 0 7 3 ... 8 0
+ *   @endcode
+ *   rolls is the game_ingest.c input line for the game; an invalid game
+ *   only has its game and error fields filled in
+ * - json: JSON Lines, one object per game
+ *   @code
+ *   {"game":0,"error":0,"total":135,"frames":[[9,0],[7,3],...,[8,0]],"scores":[9,20,...,8]}
+ *   @endcode
+ *   an invalid game only has "game" and "error"
+ * - binary: a game file (game_file.c) that --unpack and --summary read:
+ *   the header from render_header(), with the number of games to follow,
+ *   then GAME_FILE_RECORD_SIZE frame codes per game; an invalid game is
+ *   all 0xff. Records carry no game number
+ *
+ * Output is only written in whole games, and every write() is made while
+ * holding the lock of the render_output given to renderer_init(), so
+ * renderers on several threads that share a file descriptor, and that
+ * output, don't split each other's games; renderers writing elsewhere
+ * don't wait on them. A human game gets its blank line in front of it
+ * unless it is the first in the buffer; whether a buffer needs one in
+ * front too is only known when it is written, from the output's written
+ * flag, so one game prints exactly as report_game_scores() does. The
+ * order in which their games come out is whichever buffer fills first,
+ * so it differs from run to run; the csv and json rows carry their game
+ * numbers to sort by, while binary records and human games don't.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "game_render.h"
+#include "frame_codes.h"
+#include "game_file.h"
+
+// more than the longest game in any format
+#define MAX_GAME_OUTPUT 1024
+
+static const char *const format_names[RENDER_FORMAT_COUNT] = { "human", "csv", "json", "binary" };
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/// @brief Write value in decimal
+/// @return the position after the last digit
+static char *put_uint(char *p, unsigned long long value)
+{
+    char digits[20];
+    int count = 0;
+
+    while (value >= 100)
+    {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        digits[count++] = digit_pairs[pair + 1];
+        digits[count++] = digit_pairs[pair];
+    }
+    if (value >= 10)
+    {
+        digits[count++] = digit_pairs[value * 2 + 1];
+        digits[count++] = digit_pairs[value * 2];
+    }
+    else
+        digits[count++] = (char)('0' + value);
+
+    while (count > 0)
+        *p++ = digits[--count];
+    return p;
+}
+
+/// @brief Write value in decimal, right-aligned in width characters like "%*d"
+static char *put_padded(char *p, unsigned value, int width)
+{
+    int digits = 1;
+    for (unsigned rest = value; rest >= 10; rest /= 10)
+        digits++;
+    for (; digits < width; digits++)
+        *p++ = ' ';
+    return put_uint(p, value);
+}
+
+static char *put_text(char *p, const char *text, size_t length)
+{
+    memcpy(p, text, length);
+    return p + length;
+}
+
+#define PUT_TEXT(p, text) put_text(p, text, sizeof(text) - 1)
+
+static int third_ball_earned(const struct frame_results *last)
+{
+    return last->first_ball == MAX_PINS || last->first_ball + last->second_ball == MAX_PINS;
+}
+
+/// @brief The report_game_scores() layout, see print_frame()
+static char *put_human(char *p, const struct frame_results frames[MAX_FRAMES], enum bowling_error error)
+{
+    if (error != NO_ERROR)
+    {
+        p = PUT_TEXT(p, "Error: ");
+        p = put_uint(p, (unsigned)error);
+        *p++ = '\n';
+        return p;
+    }
+
+    unsigned total = 0;
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const struct frame_results *frame = &frames[i];
+        total += (unsigned)frame->score;
+
+        if (i < MAX_FRAMES - 1 && frame->type != STRIKE && frame->type != SPARE && frame->type != OPEN)
+        {
+            p = PUT_TEXT(p, "Error: unknown frame type\n");
+            continue;
+        }
+
+        p = PUT_TEXT(p, "Frame ");
+        p = put_padded(p, (unsigned)i + 1, 2);
+        p = PUT_TEXT(p, ": ");
+        p = put_padded(p, (unsigned)frame->first_ball, 2);
+
+        if (i == MAX_FRAMES - 1)
+        {
+            *p++ = ' ';
+            p = put_padded(p, (unsigned)frame->second_ball, 2);
+            *p++ = ' ';
+            p = put_padded(p, (unsigned)frame->third_ball, 2);
+            p = PUT_TEXT(p, " = ");
+        }
+        else if (frame->type == STRIKE)
+            p = PUT_TEXT(p, "  -  X = ");
+        else
+        {
+            *p++ = ' ';
+            p = put_padded(p, (unsigned)frame->second_ball, 2);
+            p = frame->type == SPARE ? PUT_TEXT(p, "  / = ") : PUT_TEXT(p, "  - = ");
+        }
+
+        p = put_padded(p, (unsigned)frame->score, 2);
+        p = PUT_TEXT(p, " = ");
+        p = put_padded(p, total, 3);
+        *p++ = '\n';
+    }
+    return p;
+}
+
+static char *put_csv(char *p, unsigned long long game, const struct frame_results frames[MAX_FRAMES],
+                     enum bowling_error error)
+{
+    p = put_uint(p, game);
+    *p++ = ',';
+    p = put_uint(p, (unsigned)error);
+    if (error != NO_ERROR)
+    {
+        p = PUT_TEXT(p, ",,,,,,,,,,,,\n");
+        return p;
+    }
+
+    unsigned total = 0;
+    for (int i = 0; i < MAX_FRAMES; i++)
+        total += (unsigned)frames[i].score;
+    *p++ = ',';
+    p = put_uint(p, total);
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        *p++ = ',';
+        p = put_uint(p, (unsigned)frames[i].score);
+    }
+
+    uint8_t rolls[MAX_ROLLS];
+    int count = rolls_from_frames(frames, rolls);
+    *p++ = ',';
+    for (int r = 0; r < count; r++)
+    {
+        if (r > 0)
+            *p++ = ' ';
+        p = put_uint(p, rolls[r]);
+    }
+    *p++ = '\n';
+    return p;
+}
+
+static char *put_json(char *p, unsigned long long game, const struct frame_results frames[MAX_FRAMES],
+                      enum bowling_error error)
+{
+    p = PUT_TEXT(p, "{\"game\":");
+    p = put_uint(p, game);
+    p = PUT_TEXT(p, ",\"error\":");
+    p = put_uint(p, (unsigned)error);
+    if (error != NO_ERROR)
+    {
+        p = PUT_TEXT(p, "}\n");
+        return p;
+    }
+
+    unsigned total = 0;
+    for (int i = 0; i < MAX_FRAMES; i++)
+        total += (unsigned)frames[i].score;
+    p = PUT_TEXT(p, ",\"total\":");
+    p = put_uint(p, total);
+
+    p = PUT_TEXT(p, ",\"frames\":[");
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const struct frame_results *frame = &frames[i];
+        if (i > 0)
+            *p++ = ',';
+        *p++ = '[';
+        p = put_uint(p, (unsigned)frame->first_ball);
+        if (i == MAX_FRAMES - 1 || frame->type != STRIKE)
+        {
+            *p++ = ',';
+            p = put_uint(p, (unsigned)frame->second_ball);
+        }
+        if (i == MAX_FRAMES - 1 && third_ball_earned(frame))
+        {
+            *p++ = ',';
+            p = put_uint(p, (unsigned)frame->third_ball);
+        }
+        *p++ = ']';
+    }
+
+    p = PUT_TEXT(p, "],\"scores\":[");
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        if (i > 0)
+            *p++ = ',';
+        p = put_uint(p, (unsigned)frames[i].score);
+    }
+    p = PUT_TEXT(p, "]}\n");
+    return p;
+}
+
+static char *put_binary(char *p, const struct frame_results frames[MAX_FRAMES], enum bowling_error error)
+{
+    uint8_t codes[GAME_FILE_RECORD_SIZE];
+
+    if (error != NO_ERROR || encode_game(frames, codes) != NO_ERROR)
+        memset(codes, 0xff, sizeof(codes));
+    return put_text(p, (const char *)codes, sizeof(codes));
+}
+
+/**
+ * Sets up a renderer with an empty buffer.
+ *
+ * @param fd file descriptor to write to, not closed by the renderer
+ * @param output lock held around each write and what has been written;
+ *        every renderer sharing fd must be given the same one, and NULL
+ *        is fine for a renderer with fd to itself
+ * @return 1 if good or 0 if the buffer could not be allocated
+ */
+int renderer_init(struct game_renderer *renderer, int fd, enum render_format format, struct render_output *output)
+{
+    renderer->fd = fd;
+    renderer->format = format;
+    renderer->used = 0;
+    renderer->failed = 0;
+    renderer->written = 0;
+    renderer->output = output;
+    renderer->buffer = malloc(RENDER_BUFFER_SIZE);
+    return renderer->buffer != NULL;
+}
+
+/**
+ * Writes the CSV header row or the game file header; human and json
+ * output have no header.
+ *
+ * @param games number of games that will be rendered, recorded in the
+ *        game file header
+ */
+void render_header(struct game_renderer *renderer, unsigned long long games)
+{
+    static const char csv_header[] =
+        "game,error,total,score_1,score_2,score_3,score_4,score_5,"
+        "score_6,score_7,score_8,score_9,score_10,rolls\n";
+    uint8_t file_header[GAME_FILE_HEADER_SIZE];
+    const char *header;
+    size_t size;
+
+    if (renderer->format == RENDER_CSV)
+    {
+        header = csv_header;
+        size = sizeof(csv_header) - 1;
+    }
+    else if (renderer->format == RENDER_BINARY)
+    {
+        game_file_header(file_header, games);
+        header = (const char *)file_header;
+        size = sizeof(file_header);
+    }
+    else
+        return;
+    if (renderer->used + size > RENDER_BUFFER_SIZE)
+        renderer_flush(renderer);
+    memcpy(renderer->buffer + renderer->used, header, size);
+    renderer->used += size;
+}
+
+/**
+ * Adds a game to the output.
+ *
+ * @param game number of the game, printed by the csv and json formats
+ * @param frames the game, already scored unless error is set
+ * @param error result of validating the game
+ */
+void render_game(struct game_renderer *renderer, unsigned long long game,
+                 const struct frame_results frames[MAX_FRAMES], enum bowling_error error)
+{
+    if (renderer->used + MAX_GAME_OUTPUT > RENDER_BUFFER_SIZE)
+        renderer_flush(renderer);
+
+    char *start = renderer->buffer + renderer->used;
+    char *p = start;
+    switch (renderer->format)
+    {
+    case RENDER_HUMAN:
+        // the buffer's first game gets its blank line from renderer_flush()
+        if (renderer->used > 0)
+            *p++ = '\n';
+        p = put_human(p, frames, error);
+        break;
+    case RENDER_CSV:
+        p = put_csv(p, game, frames, error);
+        break;
+    case RENDER_JSON:
+        p = put_json(p, game, frames, error);
+        break;
+    default:
+        p = put_binary(p, frames, error);
+        break;
+    }
+    renderer->used += (size_t)(p - start);
+}
+
+/**
+ * Adds every game in a scored batch to the output.
+ *
+ * @param first_game number of the first game in the batch
+ * @param errors validation result of each game, or NULL if they are all valid
+ */
+void render_game_batch(struct game_renderer *renderer, unsigned long long first_game,
+                       const struct game_batch *batch, const uint8_t errors[])
+{
+    struct frame_results frames[MAX_FRAMES];
+
+    for (size_t g = 0; g < batch->count; g++)
+    {
+        game_batch_get(batch, g, frames);
+        render_game(renderer, first_game + g, frames, errors ? (enum bowling_error)errors[g] : NO_ERROR);
+    }
+}
+
+static void write_all(struct game_renderer *renderer, const char *data, size_t size)
+{
+    size_t written = 0;
+
+    while (written < size && !renderer->failed)
+    {
+        ssize_t got = write(renderer->fd, data + written, size - written);
+        if (got > 0)
+            written += (size_t)got;
+        else if (got < 0 && errno == EINTR)
+            continue;
+        else
+            renderer->failed = 1;
+    }
+}
+
+/// @brief Write out everything in the buffer
+/// @return 1 if good or 0 if this or an earlier write failed
+int renderer_flush(struct game_renderer *renderer)
+{
+    int *written = renderer->output ? &renderer->output->written : &renderer->written;
+
+    if (renderer->output)
+        pthread_mutex_lock(&renderer->output->lock);
+    if (renderer->used > 0)
+    {
+        // human games already on the fd need a blank line before the buffer's first
+        if (renderer->format == RENDER_HUMAN && *written)
+            write_all(renderer, "\n", 1);
+        write_all(renderer, renderer->buffer, renderer->used);
+        *written = 1;
+    }
+    if (renderer->output)
+        pthread_mutex_unlock(&renderer->output->lock);
+
+    renderer->used = 0;
+    return !renderer->failed;
+}
+
+/// @brief Write out the buffer and free it
+/// @return 1 if good or 0 if any write failed
+int renderer_finish(struct game_renderer *renderer)
+{
+    int good = renderer_flush(renderer);
+    free(renderer->buffer);
+    renderer->buffer = NULL;
+    return good;
+}
+
+const char *render_format_name(enum render_format format)
+{
+    return format < RENDER_FORMAT_COUNT ? format_names[format] : "unknown";
+}
+
+/// @brief Look up a format by its command line name: human, csv, json or binary
+/// @return 1 if found or 0 if the name isn't known
+int render_format_from_name(const char *name, enum render_format *format)
+{
+    for (int f = 0; f < RENDER_FORMAT_COUNT; f++)
+    {
+        if (strcmp(name, format_names[f]) == 0)
+        {
+            *format = (enum render_format)f;
+            return 1;
+        }
+    }
+    return 0;
+}
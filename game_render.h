@@ -0,0 +1,55 @@
+// game_render.h
+#ifndef GAME_RENDER_H
+#define GAME_RENDER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bowling_game.h"
+#include "game_batch.h"
+
+#define RENDER_BUFFER_SIZE (1 << 20)
+
+enum render_format
+{
+    RENDER_HUMAN,   // the report_game_scores() layout
+    RENDER_CSV,     // one row per game
+    RENDER_JSON,    // JSON Lines, one object per game
+    RENDER_BINARY,  // a game file: header, then records (frame codes)
+    RENDER_FORMAT_COUNT
+};
+
+// what the renderers writing to one file descriptor share
+struct render_output
+{
+    pthread_mutex_t lock;           // held around each write
+    int written;                    // set once a game has been written, for the human format's blank lines
+};
+
+#define RENDER_OUTPUT_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, 0 }
+
+struct game_renderer
+{
+    int fd;                         // where the output is written
+    enum render_format format;
+    char *buffer;
+    size_t used;                    // bytes waiting to be written
+    int failed;                     // set if a write failed
+    int written;                    // set once a game has been written, if output is NULL
+    struct render_output *output;   // shared by the renderers of one fd; may be NULL
+};
+
+int renderer_init(struct game_renderer *renderer, int fd, enum render_format format, struct render_output *output);
+void render_header(struct game_renderer *renderer, unsigned long long games);
+void render_game(struct game_renderer *renderer, unsigned long long game,
+                 const struct frame_results frames[MAX_FRAMES], enum bowling_error error);
+void render_game_batch(struct game_renderer *renderer, unsigned long long first_game,
+                       const struct game_batch *batch, const uint8_t errors[]);
+int renderer_flush(struct game_renderer *renderer);
+int renderer_finish(struct game_renderer *renderer);
+
+const char *render_format_name(enum render_format format);
+int render_format_from_name(const char *name, enum render_format *format);
+
+#endif // GAME_RENDER_H
@@ -0,0 +1,422 @@
+/**
+ * @file lane_server.c
+ * @brief Multi-lane scoring server fed by lock-free per-lane queues
+ *
+ * Serves many lanes at once from one process: roll events come in from
+ * the pinsetters, are scored ball by ball, and each lane's updated frame
+ * scores are published after every roll.
+ *
+ * Use:
+ * - lane_server_start() sets up every worker and its lanes and starts
+ *   them; the server then runs until lane_server_stop()
+ * - each thread that feeds rolls in takes its own handle with
+ *   lane_server_producer(), up to config->producers of them, and calls
+ *   lane_server_submit(producer, lane, pins) for every ball bowled
+ * - lane_server_stop(), called once every feeding thread is done
+ *   submitting, scores what is still queued, stops the workers and
+ *   returns the combined results
+ * The lane simulator (lane_sim.c) behind --serve is one such client.
+ *
+ * Threads:
+ * - workers score: each lane belongs to one worker (lane % workers),
+ *   which keeps the lane's game_state and updates it with push_roll(), so
+ *   a lane's state is only ever touched by one thread
+ * - every producer handle has its own spsc_queue to every worker, so each
+ *   queue has exactly one writer and one reader and needs no locks; a
+ *   lane fed by one producer gets its rolls in the order submitted
+ *
+ * When a lane's game is finished the worker checks it again with
+ * validate_and_score_game(), tallies the final score, optionally renders
+ * the game, and starts the lane's next game. The workers render games in
+ * the order they finish them and share the output, so with several
+ * workers the rendered games come out in a different order each run; csv
+ * and json rows carry the game number to sort them by.
+ *
+ * A producer that finds a queue full yields until the worker catches up.
+ * A worker with nothing queued yields, and after IDLE_SPINS empty passes
+ * sleeps IDLE_SLEEP_NS between them, so an idle server costs little and
+ * thousands of lanes can be served on a box with only a few cores.
+ *
+ * With BOWLING_STATS every roll scored, game re-checked and game rendered
+ * is timed on its own (bowling_stats.c), which slows the server down
+ * noticeably; the times are per event, not per batch.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lane_server.h"
+#include "spsc_queue.h"
+#include "score_calculator.h"
+#include "bowling_stats.h"
+#include "worker_threads.h"
+
+#define QUEUE_CAPACITY 4096
+#define WORKER_BURST 256    // events taken from one queue before moving to the next
+#define IDLE_SPINS 1000     // empty passes a worker yields through before it starts sleeping
+#define IDLE_SLEEP_NS 50000
+
+// a roll event is the lane number and the pins, packed into a queue item
+#define ROLL_EVENT(lane, pins) (((uint64_t)(lane) << 8) | (uint64_t)(uint8_t)(pins))
+#define EVENT_LANE(event) ((int)((event) >> 8))
+#define EVENT_PINS(event) ((int)((event) & 0xff))
+
+struct lane_producer
+{
+    int index;
+    struct lane_server *server;
+};
+
+struct worker
+{
+    pthread_t thread;
+    int index;
+    int failed;
+    struct game_state *states;          // [lane / workers]
+    unsigned long long *games_done;     // [lane / workers]
+    struct game_renderer render;
+    int rendering;
+    struct lane_server_results results;
+    struct lane_server *server;
+};
+
+struct lane_server
+{
+    struct lane_server_config config;
+    int producers;
+    int workers;
+    int started_workers;
+    struct spsc_queue *queues;          // [producer][worker]
+    atomic_int next_producer;           // next handle lane_server_producer() gives out
+    atomic_int stopping;                // set by lane_server_stop()
+    atomic_ullong next_game;            // number of the next game to finish, without config.games
+    double start;
+    struct lane_producer producer[MAX_THREADS];
+    struct worker worker[MAX_THREADS];
+};
+
+/// @brief Check, tally and reset a lane whose game has just finished
+static void finish_game(struct worker *worker, struct game_state *state, struct game_renderer *render,
+                        unsigned long long game)
+{
+    struct frame_results frames[MAX_FRAMES];
+    int total = 0;
+
+    STATS_START(validate);
+    memcpy(frames, state->frames, sizeof(frames));
+    enum bowling_error error = validate_and_score_game(frames, NULL);
+    for (int i = 0; i < MAX_FRAMES; i++)
+        total += frames[i].score;
+    STATS_STOP(STAGE_VALIDATE, validate, 1);
+
+    if (error != NO_ERROR || total != state->total)
+    {
+        worker->results.invalid_games++;
+        STATS_ERROR(error);
+    }
+    else
+        worker->results.histogram[total]++;
+    worker->results.games++;
+
+    if (render)
+    {
+        STATS_START(output);
+        render_game(render, game, frames, error);
+        STATS_STOP(STAGE_OUTPUT, output, 1);
+    }
+    init_game_state(state);
+}
+
+static void worker_free(struct worker *worker)
+{
+    if (worker->rendering)
+        free(worker->render.buffer);
+    free(worker->states);
+    free(worker->games_done);
+}
+
+/**
+ * Sets up a worker's lanes and renderer. Done for every worker before any
+ * roll can be submitted: a worker that gave up after a producer had
+ * started would leave its queues full and the producer waiting on them
+ * forever.
+ *
+ * @return 1 if good or 0 if memory could not be allocated, with nothing
+ *         left allocated
+ */
+static int worker_init(struct worker *worker, struct lane_server *server, int index)
+{
+    const struct lane_server_config *config = &server->config;
+    int lanes = (config->lanes - index + server->workers - 1) / server->workers;
+    size_t count = lanes > 0 ? (size_t)lanes : 1;
+
+    worker->index = index;
+    worker->server = server;
+    worker->states = malloc(count * sizeof(*worker->states));
+    worker->games_done = calloc(count, sizeof(*worker->games_done));
+    worker->rendering = 0;
+    if (!worker->states || !worker->games_done ||
+        (config->render && !(worker->rendering = renderer_init(&worker->render, config->render->fd,
+                                                               config->render->format, config->render->output))))
+    {
+        worker_free(worker);
+        return 0;
+    }
+    for (int k = 0; k < lanes; k++)
+        init_game_state(&worker->states[k]);
+    return 1;
+}
+
+/// @brief Yield, or sleep a little once the worker has been idle a while
+static void worker_idle(int *idle)
+{
+    if (++*idle < IDLE_SPINS)
+        sched_yield();
+    else
+    {
+        struct timespec pause = { 0, IDLE_SLEEP_NS };
+        nanosleep(&pause, NULL);
+    }
+}
+
+/// @brief Score the roll events for this worker's lanes until the server is stopped
+static void *worker_thread(void *arg)
+{
+    struct worker *worker = arg;
+    struct lane_server *server = worker->server;
+    const struct lane_server_config *config = &server->config;
+    struct game_state *states = worker->states;
+    unsigned long long *games_done = worker->games_done;
+    struct game_renderer *render = worker->rendering ? &worker->render : NULL;
+    int idle = 0;
+
+    for (;;)
+    {
+        // every event submitted before lane_server_stop() is visible once it is seen
+        int done = atomic_load_explicit(&server->stopping, memory_order_acquire);
+        unsigned long long got = 0;
+
+        for (int p = 0; p < server->producers; p++)
+        {
+            struct spsc_queue *queue = &server->queues[p * server->workers + worker->index];
+            uint64_t event;
+            for (int n = 0; n < WORKER_BURST && spsc_pop(queue, &event); n++)
+            {
+                int lane = EVENT_LANE(event);
+                int k = lane / server->workers;
+                struct game_state *state = &states[k];
+
+                got++;
+                STATS_START(score);
+                enum bowling_error error = push_roll(state, EVENT_PINS(event));
+                STATS_STOP(STAGE_SCORE, score, 1);
+                if (error != NO_ERROR)
+                {
+                    worker->results.invalid_rolls++;
+                    STATS_ERROR(error);
+                    continue;
+                }
+                if (config->publish)
+                    config->publish(config->publish_context, lane, state);
+                if (game_state_complete(state))
+                {
+                    unsigned long long game = config->games > 0
+                        ? (unsigned long long)lane * config->games + games_done[k]
+                        : atomic_fetch_add_explicit(&server->next_game, 1, memory_order_relaxed);
+                    games_done[k]++;
+                    finish_game(worker, state, render, game);
+                }
+            }
+        }
+        worker->results.rolls += got;
+        STATS_POLL();
+
+        if (got > 0)
+            idle = 0;
+        else if (done)
+            break;
+        else
+            worker_idle(&idle);
+    }
+
+    if (render && !renderer_flush(render))
+        worker->failed = 1;
+    return NULL;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// @brief Free the queues, lanes and the server itself, once no worker is running
+static void lane_server_free(struct lane_server *server, int queues, int workers)
+{
+    for (int w = 0; w < workers; w++)
+        worker_free(&server->worker[w]);
+    for (int q = 0; q < queues; q++)
+        spsc_free(&server->queues[q]);
+    free(server->queues);
+    free(server);
+}
+
+/**
+ * Sets up the queues and every lane and starts the workers. The config is
+ * copied; the renderer, publish context and anything they refer to must
+ * outlive the server.
+ *
+ * @param config lanes and threads
+ * @param server receives the running server
+ * @return 1 if good or 0 if the config is out of range, memory could not
+ *         be allocated or a thread could not be started
+ */
+int lane_server_start(const struct lane_server_config *config, struct lane_server **server)
+{
+    *server = NULL;
+    if (config->lanes <= 0 || config->producers > MAX_THREADS || config->workers > MAX_THREADS)
+        return 0;
+
+    struct lane_server *s = calloc(1, sizeof(*s));
+    if (!s)
+        return 0;
+    s->config = *config;
+    s->producers = config->producers > 0 ? config->producers : 1;
+    s->workers = worker_thread_count(config->workers);
+    atomic_init(&s->next_producer, 0);
+    atomic_init(&s->stopping, 0);
+    atomic_init(&s->next_game, 0);
+
+    int queues = s->producers * s->workers;
+    s->queues = aligned_alloc(SPSC_CACHE_LINE, (size_t)queues * sizeof(struct spsc_queue));
+    int ready = 0;
+    while (s->queues && ready < queues && spsc_init(&s->queues[ready], QUEUE_CAPACITY))
+        ready++;
+    int ready_workers = 0;
+    while (ready == queues && ready_workers < s->workers && worker_init(&s->worker[ready_workers], s, ready_workers))
+        ready_workers++;
+    if (ready_workers < s->workers)
+    {
+        lane_server_free(s, ready, ready_workers);
+        return 0;
+    }
+
+    for (int p = 0; p < s->producers; p++)
+    {
+        s->producer[p].index = p;
+        s->producer[p].server = s;
+    }
+
+    s->start = now_seconds();
+    for (; s->started_workers < s->workers; s->started_workers++)
+        if (pthread_create(&s->worker[s->started_workers].thread, NULL, worker_thread,
+                           &s->worker[s->started_workers]) != 0)
+            break;
+    if (s->started_workers < s->workers)
+    {
+        // nothing was submitted, so the started workers stop straight away
+        struct lane_server_results ignored;
+        lane_server_stop(s, &ignored);
+        return 0;
+    }
+
+    *server = s;
+    return 1;
+}
+
+/**
+ * Gives the calling thread its own handle for submitting rolls. A handle
+ * must only be used by one thread at a time.
+ *
+ * @param producer receives the handle, valid until lane_server_stop()
+ * @return 1 if good or 0 if all config->producers handles are taken
+ */
+int lane_server_producer(struct lane_server *server, struct lane_producer **producer)
+{
+    int index = atomic_fetch_add_explicit(&server->next_producer, 1, memory_order_relaxed);
+
+    if (index >= server->producers)
+        return 0;
+    *producer = &server->producer[index];
+    return 1;
+}
+
+/**
+ * Queues a ball for scoring, waiting for room if the lane's worker is
+ * behind. A lane's balls must all come through the same handle to be
+ * scored in order. Pins outside 0-10 are counted as invalid rolls.
+ *
+ * @param lane lane the ball was bowled on, 0 to config->lanes - 1
+ * @param pins pins knocked down
+ * @return 1 if queued or 0 if there is no such lane
+ */
+int lane_server_submit(struct lane_producer *producer, int lane, int pins)
+{
+    struct lane_server *server = producer->server;
+
+    if (lane < 0 || lane >= server->config.lanes)
+        return 0;
+    if (pins < 0 || pins > MAX_PINS)
+        pins = 0xff;
+
+    struct spsc_queue *queue = &server->queues[producer->index * server->workers + lane % server->workers];
+    while (!spsc_push(queue, ROLL_EVENT(lane, pins)))
+        sched_yield();
+    return 1;
+}
+
+/**
+ * Scores every roll already submitted, stops the workers and frees the
+ * server. Every thread feeding it must have made its last
+ * lane_server_submit() call before this is called; games still in
+ * progress are dropped.
+ *
+ * @param results filled in with the combined results of all workers
+ * @return 1 if good or 0 if the games could not be written
+ */
+int lane_server_stop(struct lane_server *server, struct lane_server_results *results)
+{
+    int good = 1;
+
+    memset(results, 0, sizeof(*results));
+    atomic_store_explicit(&server->stopping, 1, memory_order_release);
+    for (int w = 0; w < server->started_workers; w++)
+    {
+        struct worker *worker = &server->worker[w];
+        pthread_join(worker->thread, NULL);
+        good = good && !worker->failed;
+
+        results->games += worker->results.games;
+        results->rolls += worker->results.rolls;
+        results->invalid_rolls += worker->results.invalid_rolls;
+        results->invalid_games += worker->results.invalid_games;
+        for (int s = 0; s <= MAX_SCORE; s++)
+            results->histogram[s] += worker->results.histogram[s];
+    }
+    results->seconds = now_seconds() - server->start;
+
+    lane_server_free(server, server->producers * server->workers, server->workers);
+    return good;
+}
+
+/// @brief Print the totals and throughput of a run
+void report_lane_server(const struct lane_server_results *results, FILE *out)
+{
+    unsigned long long scored = results->games - results->invalid_games;
+    double sum = 0.0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+        sum += (double)s * results->histogram[s];
+
+    fprintf(out, "Games:         %12llu\n", results->games);
+    fprintf(out, "Rolls:         %12llu\n", results->rolls);
+    fprintf(out, "Invalid rolls: %12llu\n", results->invalid_rolls);
+    fprintf(out, "Invalid games: %12llu\n", results->invalid_games);
+    fprintf(out, "Mean:          %12.2f\n", scored > 0 ? sum / scored : 0.0);
+    fprintf(out, "Seconds:       %12.3f\n", results->seconds);
+    fprintf(out, "Rolls/sec:     %12.0f\n", results->seconds > 0 ? results->rolls / results->seconds : 0.0);
+    fprintf(out, "Games/sec:     %12.0f\n", results->seconds > 0 ? results->games / results->seconds : 0.0);
+}
@@ -0,0 +1,47 @@
+// lane_server.h
+#ifndef LANE_SERVER_H
+#define LANE_SERVER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "live_score.h"
+#include "game_render.h"
+
+// called by a lane's worker after every roll it scores on that lane
+typedef void (*lane_publish_fn)(void *context, int lane, const struct game_state *state);
+
+struct lane_server;
+struct lane_producer;
+
+struct lane_server_config
+{
+    int lanes;                      // lanes to serve, numbered from 0
+    int producers;                  // threads that will submit rolls, one handle each, 0 for one
+    int workers;                    // scoring threads, 0 for one per core
+    unsigned long long games;       // if set, lane L's game n is numbered L * games + n when rendered,
+                                    // otherwise games are numbered in the order they finish
+    const struct game_renderer *render; // if set, every finished game is written to its fd in its format,
+                                        // sharing its output
+    lane_publish_fn publish;        // if set, sees every lane's score after each roll
+    void *publish_context;
+};
+
+struct lane_server_results
+{
+    unsigned long long games;           // games finished
+    unsigned long long rolls;           // roll events scored
+    unsigned long long invalid_rolls;   // roll events push_roll() rejected
+    unsigned long long invalid_games;   // finished games that failed validation
+    unsigned long long histogram[MAX_SCORE + 1];    // count of each final score
+    double seconds;                     // wall clock time serving
+};
+
+int lane_server_start(const struct lane_server_config *config, struct lane_server **server);
+int lane_server_producer(struct lane_server *server, struct lane_producer **producer);
+int lane_server_submit(struct lane_producer *producer, int lane, int pins);
+int lane_server_stop(struct lane_server *server, struct lane_server_results *results);
+void report_lane_server(const struct lane_server_results *results, FILE *out);
+
+#endif // LANE_SERVER_H
@@ -0,0 +1,181 @@
+/**
+ * @file lane_sim.c
+ * @brief Simulated pinsetters feeding the lane server, for --serve
+ *
+ * Stands in for the pinsetters of config->server.lanes lanes: starts a
+ * lane server (lane_server.c), and on each of config->producers threads
+ * takes a producer handle and simulates a share of the lanes
+ * (lane % producers), bowling one frame per lane in turn with
+ * throw_frame_r() and submitting every ball. Once every lane has bowled
+ * config->games games the server is stopped and its results returned.
+ *
+ * The simulated lanes draw from their thread's generator, except with
+ * RNG_PHILOX, where every game has its own stream numbered like the
+ * rendered games (lane * games + n), so the games bowled don't depend on
+ * the number of producers.
+ *
+ * A fixed seed and thread counts bowl the same games and give the same
+ * summary every run; the order the games are rendered in is up to the
+ * server's workers.
+ *
+ * Example output (--serve 1000 --games 100 --seed 1, one core):
+ * Lanes:                 1000
+ * Games:               100000
+ * Rolls:              1830364
+ * Invalid rolls:            0
+ * Invalid games:            0
+ * Mean:                136.44
+ * Seconds:              0.097
+ * Rolls/sec:         18796585
+ * Games/sec:          1026932
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lane_sim.h"
+#include "bowling_stats.h"
+
+// a simulated lane, owned by one producer
+struct lane_sim
+{
+    struct frame_results frames[MAX_FRAMES];
+    int frame;                          // next frame to bowl
+    unsigned long long games_left;
+    struct bowling_rng rng;             // with RNG_PHILOX, the stream of the lane's current game
+};
+
+struct sim_producer
+{
+    pthread_t thread;
+    int index;
+    int producers;
+    int failed;
+    struct bowling_rng rng;
+    struct lane_producer *handle;
+    const struct lane_sim_config *config;
+};
+
+/// @brief Submit the balls of the frame just bowled
+static void submit_frame(struct lane_producer *handle, int lane, const struct frame_results *frame, int frame_number)
+{
+    lane_server_submit(handle, lane, frame->first_ball);
+    if (frame_number < MAX_FRAMES - 1)
+    {
+        if (frame->type != STRIKE)
+            lane_server_submit(handle, lane, frame->second_ball);
+    }
+    else
+    {
+        lane_server_submit(handle, lane, frame->second_ball);
+        if (frame->first_ball == MAX_PINS || frame->first_ball + frame->second_ball == MAX_PINS)
+            lane_server_submit(handle, lane, frame->third_ball);
+    }
+}
+
+/// @brief Simulate this producer's lanes a frame at a time until they have bowled all their games
+static void *producer_thread(void *arg)
+{
+    struct sim_producer *producer = arg;
+    const struct lane_sim_config *config = producer->config;
+    int lanes = (config->server.lanes - producer->index + producer->producers - 1) / producer->producers;
+    struct lane_sim *sims = calloc(lanes > 0 ? (size_t)lanes : 1, sizeof(*sims));
+
+    if (!sims)
+    {
+        producer->failed = 1;
+        return NULL;
+    }
+
+    int active = config->games > 0 ? lanes : 0;
+    int counter_based = producer->rng.kind == RNG_PHILOX;
+    for (int k = 0; k < lanes; k++)
+    {
+        sims[k].games_left = config->games;
+        sims[k].rng = producer->rng;
+    }
+
+    while (active > 0)
+    {
+        for (int k = 0; k < lanes; k++)
+        {
+            struct lane_sim *sim = &sims[k];
+            int lane = producer->index + k * producer->producers;
+
+            if (sim->games_left == 0)
+                continue;
+            if (sim->frame == 0)
+            {
+                init_game_results(sim->frames);
+                bowling_rng_seek(&sim->rng, (unsigned long long)lane * config->games +
+                                            (config->games - sim->games_left));
+            }
+
+            STATS_START(generate);
+            throw_frame_r(sim->frames, sim->frame, config->model, counter_based ? &sim->rng : &producer->rng);
+            STATS_STOP(STAGE_GENERATE, generate, 1);
+            submit_frame(producer->handle, lane, &sim->frames[sim->frame], sim->frame);
+
+            if (++sim->frame == MAX_FRAMES)
+            {
+                sim->frame = 0;
+                if (--sim->games_left == 0)
+                    active--;
+            }
+        }
+    }
+
+    free(sims);
+    return NULL;
+}
+
+/**
+ * Serves config->server.lanes lanes, fed by the lane simulators, until
+ * every lane has bowled config->games games.
+ *
+ * @param config lanes, threads and simulated games
+ * @param results filled in with the combined results of the server's workers
+ * @return 1 if good or 0 if memory could not be allocated, a thread could
+ *         not be started, or the games could not be written
+ */
+int run_lane_simulation(const struct lane_sim_config *config, struct lane_server_results *results)
+{
+    struct lane_server_config server_config = config->server;
+    int producers = config->producers > 0 ? config->producers : 1;
+    struct lane_server *server;
+    int good = 1;
+
+    memset(results, 0, sizeof(*results));
+    server_config.producers = producers;
+    server_config.games = config->games;
+    struct sim_producer *sims = calloc((size_t)producers, sizeof(*sims));
+    if (!sims || !lane_server_start(&server_config, &server))
+    {
+        free(sims);
+        return 0;
+    }
+
+    int started = 0;
+    for (; started < producers; started++)
+    {
+        struct sim_producer *producer = &sims[started];
+        producer->index = started;
+        producer->producers = producers;
+        producer->config = config;
+        bowling_rng_init(&producer->rng, config->rng, config->seed, (uint64_t)started);
+        if (!lane_server_producer(server, &producer->handle) ||
+            pthread_create(&producer->thread, NULL, producer_thread, producer) != 0)
+            break;
+    }
+    if (started < producers)
+        good = 0;
+
+    for (int p = 0; p < started; p++)
+    {
+        pthread_join(sims[p].thread, NULL);
+        good = good && !sims[p].failed;
+    }
+    good = lane_server_stop(server, results) && good;
+    free(sims);
+    return good;
+}
@@ -0,0 +1,23 @@
+// lane_sim.h
+#ifndef LANE_SIM_H
+#define LANE_SIM_H
+
+#include <stdint.h>
+
+#include "bowling_rng.h"
+#include "roll_model.h"
+#include "lane_server.h"
+
+struct lane_sim_config
+{
+    struct lane_server_config server;   // lanes, workers, output; producers and games are set from below
+    int producers;                      // lane simulator threads, 0 for one
+    unsigned long long games;           // games each simulated lane bowls
+    uint64_t seed;                      // each simulator thread gets its own stream
+    enum rng_kind rng;
+    const struct roll_model *model;
+};
+
+int run_lane_simulation(const struct lane_sim_config *config, struct lane_server_results *results);
+
+#endif // LANE_SIM_H
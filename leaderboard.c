@@ -0,0 +1,261 @@
+/**
+ * @file leaderboard.c
+ * @brief Streaming top games, top series and rolling averages
+ *
+ * Games are added one at a time as they are scored, and the board keeps:
+ * - the 'top' highest games, in a min-heap: a game that doesn't beat the
+ *   lowest kept one (almost every game, once the board has filled) costs
+ *   one comparison, and one that does costs O(log top) swaps
+ * - the 'top' highest LEADERBOARD_SERIES_GAMES-game series, the same way.
+ *   A player's series is their first games of a session, and sessions
+ *   are taken to arrive in order: a player's series in progress is
+ *   dropped if they move on to another session before finishing it
+ * - each player's average over their last 'window' games, from a ring of
+ *   the scores and a running sum, so an update is O(1)
+ *
+ * Nothing is ever sorted while games are added; a reader sorts its own
+ * copy of a heap when it asks for the list.
+ *
+ * Concurrency:
+ * One thread adds games while any number of threads read:
+ * - the heaps are guarded by one seqlock (seqlock.h), which only a game
+ *   that makes a top list takes, so readers rarely have to retry
+ * - each player's rolling average has its own seqlock
+ * - players live in fixed chunks that are never moved; a chunk is
+ *   published with a release store once it is set up, so a reader sees
+ *   either no chunk or a ready one
+ *
+ * Players are numbered by the caller, densely from 0 (the ids from
+ * league_player_id() for example), up to LEADERBOARD_CHUNK_PLAYERS *
+ * LEADERBOARD_MAX_CHUNKS.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "leaderboard.h"
+
+#define LEADERBOARD_ARENA_BLOCK (1 << 20)
+
+/// @brief Set up an empty board
+/// @param top entries kept in each top list, at most LEADERBOARD_MAX_TOP
+/// @param window games in each rolling average, at most LEADERBOARD_MAX_WINDOW
+void leaderboard_init(struct leaderboard *board, int top, int window)
+{
+    memset(board, 0, sizeof(*board));
+    board->top = top < 1 ? 1 : top > LEADERBOARD_MAX_TOP ? LEADERBOARD_MAX_TOP : top;
+    board->window = window < 1 ? 1 : window > LEADERBOARD_MAX_WINDOW ? LEADERBOARD_MAX_WINDOW : window;
+    seqlock_init(&board->lock);
+    for (int c = 0; c < LEADERBOARD_MAX_CHUNKS; c++)
+        atomic_init(&board->chunks[c], NULL);
+    arena_init(&board->arena, LEADERBOARD_ARENA_BLOCK);
+}
+
+/// @brief Free the players; no reader may be using the board
+void leaderboard_free(struct leaderboard *board)
+{
+    arena_free(&board->arena);
+    for (int c = 0; c < LEADERBOARD_MAX_CHUNKS; c++)
+        atomic_store_explicit(&board->chunks[c], NULL, memory_order_relaxed);
+}
+
+// a ranks below b: lower, or as high but added later
+static inline int ranks_below(const struct leaderboard_entry *a, const struct leaderboard_entry *b)
+{
+    return a->score < b->score || (a->score == b->score && a->order > b->order);
+}
+
+/// @brief Keep the entry if the heap has room or it ranks above the lowest entry kept
+/// @return 1 if the heap changed
+static int heap_offer(struct leaderboard *board, struct leaderboard_heap *heap, const struct leaderboard_entry *entry)
+{
+    int i;
+
+    if (heap->count == board->top && !ranks_below(&heap->entries[0], entry))
+        return 0;
+
+    seqlock_write_begin(&board->lock);
+    if (heap->count < board->top)
+    {
+        // sift up from the new leaf
+        i = heap->count++;
+        while (i > 0 && ranks_below(entry, &heap->entries[(i - 1) / 2]))
+        {
+            heap->entries[i] = heap->entries[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    }
+    else
+    {
+        // replace the lowest and sift down
+        i = 0;
+        for (;;)
+        {
+            int child = 2 * i + 1;
+            if (child >= heap->count)
+                break;
+            if (child + 1 < heap->count && ranks_below(&heap->entries[child + 1], &heap->entries[child]))
+                child++;
+            if (!ranks_below(&heap->entries[child], entry))
+                break;
+            heap->entries[i] = heap->entries[child];
+            i = child;
+        }
+    }
+    heap->entries[i] = *entry;
+    seqlock_write_end(&board->lock);
+    return 1;
+}
+
+/// @brief The player's slot, allocating its chunk if needed (writer only)
+static struct leaderboard_player *player_slot(struct leaderboard *board, uint32_t player)
+{
+    uint32_t c = player / LEADERBOARD_CHUNK_PLAYERS;
+    if (c >= LEADERBOARD_MAX_CHUNKS)
+        return NULL;
+
+    struct leaderboard_chunk *chunk = atomic_load_explicit(&board->chunks[c], memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = arena_alloc(&board->arena, sizeof(*chunk));
+        uint16_t *rings = arena_alloc(&board->arena, LEADERBOARD_CHUNK_PLAYERS * (size_t)board->window * sizeof(*rings));
+        if (!chunk || !rings)
+            return NULL;
+        for (int p = 0; p < LEADERBOARD_CHUNK_PLAYERS; p++)
+        {
+            seqlock_init(&chunk->players[p].lock);
+            chunk->players[p].recent = rings + (size_t)p * board->window;
+        }
+        atomic_store_explicit(&board->chunks[c], chunk, memory_order_release);
+    }
+    return &chunk->players[player % LEADERBOARD_CHUNK_PLAYERS];
+}
+
+/**
+ * Adds a game, from the one thread that writes to the board.
+ *
+ * @param board the board
+ * @param player the player's number
+ * @param session the session the game was bowled in
+ * @param score the game's score
+ * @return 1 if good or 0 if the player number is too big or memory could
+ *         not be allocated
+ */
+int leaderboard_add_game(struct leaderboard *board, uint32_t player, uint32_t session, int score)
+{
+    struct leaderboard_player *slot = player_slot(board, player);
+    if (!slot)
+        return 0;
+
+    uint32_t order = board->order++;
+    struct leaderboard_entry game = { (uint32_t)score, player, session, order };
+    heap_offer(board, &board->games, &game);
+
+    seqlock_write_begin(&slot->lock);
+    int kept = slot->games < (uint32_t)board->window ? (int)slot->games : board->window;
+    uint16_t *oldest = &slot->recent[slot->games % (uint32_t)board->window];
+    if (kept == board->window)
+        slot->sum -= *oldest;
+    *oldest = (uint16_t)score;
+    slot->sum += (uint32_t)score;
+    slot->games++;
+
+    if (slot->games == 1 || slot->session != session)
+    {
+        slot->session = session;
+        slot->series_games = 0;
+        slot->series_pins = 0;
+    }
+    int series_done = 0;
+    if (slot->series_games < LEADERBOARD_SERIES_GAMES)
+    {
+        slot->series_pins += (uint16_t)score;
+        series_done = ++slot->series_games == LEADERBOARD_SERIES_GAMES;
+    }
+    uint32_t series_pins = slot->series_pins;
+    seqlock_write_end(&slot->lock);
+
+    if (series_done)
+    {
+        struct leaderboard_entry series = { series_pins, player, session, order };
+        heap_offer(board, &board->series, &series);
+    }
+    return 1;
+}
+
+// highest first
+static int compare_entries(const void *a, const void *b)
+{
+    const struct leaderboard_entry *x = a;
+    const struct leaderboard_entry *y = b;
+    return ranks_below(x, y) ? 1 : ranks_below(y, x) ? -1 : 0;
+}
+
+/// @brief Copy a heap under the seqlock and sort the copy, highest first
+static int read_heap(const struct leaderboard *board, const struct leaderboard_heap *heap,
+                     struct leaderboard_entry entries[LEADERBOARD_MAX_TOP])
+{
+    unsigned sequence;
+    int count;
+
+    do
+    {
+        sequence = seqlock_read_begin(&board->lock);
+        count = heap->count;
+        if (count > LEADERBOARD_MAX_TOP)
+            count = LEADERBOARD_MAX_TOP;
+        memcpy(entries, heap->entries, (size_t)count * sizeof(entries[0]));
+    } while (seqlock_read_retry(&board->lock, sequence));
+
+    qsort(entries, (size_t)count, sizeof(entries[0]), compare_entries);
+    return count;
+}
+
+/// @brief The highest games so far, highest first; safe while games are added
+/// @return the number of entries
+int leaderboard_top_games(const struct leaderboard *board, struct leaderboard_entry entries[LEADERBOARD_MAX_TOP])
+{
+    return read_heap(board, &board->games, entries);
+}
+
+/// @brief The highest series so far, highest first; safe while games are added
+/// @return the number of entries
+int leaderboard_top_series(const struct leaderboard *board, struct leaderboard_entry entries[LEADERBOARD_MAX_TOP])
+{
+    return read_heap(board, &board->series, entries);
+}
+
+/**
+ * Gives a player's average over their last 'window' games; safe while
+ * games are added.
+ *
+ * @param board the board
+ * @param player the player's number
+ * @param average receives the average, 0 if the player has no games
+ * @param games receives the number of games it covers
+ * @return 1 if the player has games or 0 if not
+ */
+int leaderboard_rolling_average(const struct leaderboard *board, uint32_t player, double *average, int *games)
+{
+    uint32_t c = player / LEADERBOARD_CHUNK_PLAYERS;
+    struct leaderboard_chunk *chunk = c < LEADERBOARD_MAX_CHUNKS
+        ? atomic_load_explicit((_Atomic(struct leaderboard_chunk *) *)&board->chunks[c], memory_order_acquire)
+        : NULL;
+    uint32_t count = 0;
+    uint32_t sum = 0;
+
+    if (chunk)
+    {
+        const struct leaderboard_player *slot = &chunk->players[player % LEADERBOARD_CHUNK_PLAYERS];
+        unsigned sequence;
+        do
+        {
+            sequence = seqlock_read_begin(&slot->lock);
+            count = slot->games;
+            sum = slot->sum;
+        } while (seqlock_read_retry(&slot->lock, sequence));
+    }
+
+    *games = count < (uint32_t)board->window ? (int)count : board->window;
+    *average = *games > 0 ? (double)sum / *games : 0.0;
+    return count > 0;
+}
@@ -0,0 +1,69 @@
+// leaderboard.h
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "seqlock.h"
+
+#define LEADERBOARD_MAX_TOP 256         // most entries each top list can keep
+#define LEADERBOARD_MAX_WINDOW 100      // most games a rolling average can cover
+#define LEADERBOARD_WINDOW 10           // default rolling average window
+#define LEADERBOARD_SERIES_GAMES 3      // games in a series
+#define LEADERBOARD_CHUNK_PLAYERS 1024  // players allocated together
+#define LEADERBOARD_MAX_CHUNKS 4096     // so up to 4M players
+
+struct leaderboard_entry
+{
+    uint32_t score;             // a game's score or a series total
+    uint32_t player;
+    uint32_t session;
+    uint32_t order;             // games added before it; the earlier of two equal scores ranks higher
+};
+
+// min-heap: the entry that would be dropped first is at [0]
+struct leaderboard_heap
+{
+    int count;
+    struct leaderboard_entry entries[LEADERBOARD_MAX_TOP];
+};
+
+struct leaderboard_player
+{
+    struct seqlock lock;        // guards the rest
+    uint32_t games;             // games added for the player
+    uint32_t sum;               // total of the last 'window' games
+    uint32_t session;           // session of the series in progress
+    uint16_t series_games;
+    uint16_t series_pins;
+    uint16_t *recent;           // ring of the last 'window' scores, oldest at games % window
+};
+
+struct leaderboard_chunk
+{
+    struct leaderboard_player players[LEADERBOARD_CHUNK_PLAYERS];
+};
+
+struct leaderboard
+{
+    int top;                    // entries kept in each top list
+    int window;                 // games in a rolling average
+    uint32_t order;             // games added so far
+    struct seqlock lock;        // guards the heaps
+    struct leaderboard_heap games;
+    struct leaderboard_heap series;
+    _Atomic(struct leaderboard_chunk *) chunks[LEADERBOARD_MAX_CHUNKS];
+    struct arena arena;         // the chunks and their rings
+};
+
+void leaderboard_init(struct leaderboard *board, int top, int window);
+void leaderboard_free(struct leaderboard *board);
+int leaderboard_add_game(struct leaderboard *board, uint32_t player, uint32_t session, int score);
+
+int leaderboard_top_games(const struct leaderboard *board, struct leaderboard_entry entries[LEADERBOARD_MAX_TOP]);
+int leaderboard_top_series(const struct leaderboard *board, struct leaderboard_entry entries[LEADERBOARD_MAX_TOP]);
+int leaderboard_rolling_average(const struct leaderboard *board, uint32_t player, double *average, int *games);
+
+#endif // LEADERBOARD_H
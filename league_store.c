@@ -0,0 +1,580 @@
+/**
+ * @file league_store.c
+ * @brief In-memory store of league games with per-player aggregates
+ *
+ * Holds millions of games tagged by player, session and lane, and answers
+ * the league questions from running totals instead of re-reading the
+ * games: averages, handicaps, strike and spare percentages and
+ * LEAGUE_SERIES_GAMES-game series totals.
+ *
+ * Storage:
+ * - everything lives in one arena (arena.h): players, their names, and
+ *   fixed-size blocks of games and series; adding a game allocates
+ *   nothing except when the player's current block is full, once every
+ *   LEAGUE_BLOCK_GAMES games
+ * - a game is stored as its MAX_FRAMES frame codes (frame_codes.c) plus
+ *   its tags and score, 20 bytes
+ * - each player's blocks are chained in the order the games were added,
+ *   so a player's games are read without touching anyone else's
+ * - players are found by name through an open-addressing hash of ids;
+ *   the id array and the hash grow by doubling
+ *
+ * Aggregates, updated as each game is added:
+ * - games, pins and the high game of each player, and games and pins of
+ *   each lane
+ * - strikes out of fresh racks, and spares out of racks left standing
+ *   after the first ball (the 10th frame's fill balls included)
+ * - the series of each (player, session): the total of the player's
+ *   first LEAGUE_SERIES_GAMES games that session. Sessions normally come
+ *   in order, so the player's latest series is checked first and older
+ *   ones are only searched when a session comes back
+ *
+ * With store->board set, every game stored is also fed to that
+ * leaderboard (leaderboard.c), which keeps the top games and series and
+ * each player's rolling average as the games stream in.
+ *
+ * Handicap is the usual percentage of the difference between a basis
+ * score and the player's average, the average truncated to a whole pin
+ * and the handicap never below 0.
+ *
+ * League file format (--league FILE), one game per line:
+ * @code
+ * # player session lane rolls
+ * alice 1 12 10 7 3 9 0 10 0 8 8 2 0 6 10 10 10 8 1
+ * @endcode
+ * Names are one word. Blank lines and lines starting with '#' are
+ * skipped; lines that aren't a valid game are counted and not stored.
+ *
+ * Example standings (10000 players, 150 games each, default roll model;
+ * loading the 1.5 million games takes about 1.5 s on one core):
+ * Player            Games  Average  Hdcp  Strike%  Spare%  High  Series
+ * p4261               150   143.85    69    28.08   38.62   247     577
+ * p4160               150   143.09    69    26.84   38.15   206     546
+ * ...
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "league_store.h"
+#include "frame_codes.h"
+#include "score_calculator.h"
+
+#define LEAGUE_ARENA_BLOCK (4 << 20)
+#define LEAGUE_FIRST_PLAYERS 1024
+
+/// @brief Set up an empty store
+/// @return 1 if good or 0 if memory could not be allocated
+int league_init(struct league_store *store)
+{
+    memset(store, 0, sizeof(*store));
+    arena_init(&store->arena, LEAGUE_ARENA_BLOCK);
+    store->players = malloc(LEAGUE_FIRST_PLAYERS * sizeof(*store->players));
+    store->index = calloc(2 * LEAGUE_FIRST_PLAYERS, sizeof(*store->index));
+    if (!store->players || !store->index)
+    {
+        league_free(store);
+        return 0;
+    }
+    store->player_capacity = LEAGUE_FIRST_PLAYERS;
+    store->index_size = 2 * LEAGUE_FIRST_PLAYERS;
+    return 1;
+}
+
+void league_free(struct league_store *store)
+{
+    arena_free(&store->arena);
+    free(store->players);
+    free(store->index);
+    free(store->lanes);
+    memset(store, 0, sizeof(*store));
+}
+
+static uint32_t name_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;   // FNV-1a
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
+}
+
+/// @brief Slot of the name in the hash, or of the empty slot where it would go
+static uint32_t find_slot(const struct league_store *store, const char *name)
+{
+    uint32_t mask = store->index_size - 1;
+    uint32_t slot = name_hash(name) & mask;
+
+    while (store->index[slot] != 0 && strcmp(store->players[store->index[slot] - 1]->name, name) != 0)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+/// @brief Double the player array and the hash
+static int grow_players(struct league_store *store)
+{
+    uint32_t capacity = store->player_capacity * 2;
+    struct league_player **players = realloc(store->players, capacity * sizeof(*players));
+    if (!players)
+        return 0;
+    store->players = players;
+    store->player_capacity = capacity;
+
+    uint32_t *index = calloc(2 * (size_t)capacity, sizeof(*index));
+    if (!index)
+        return 0;
+    free(store->index);
+    store->index = index;
+    store->index_size = 2 * capacity;
+    for (uint32_t id = 0; id < store->player_count; id++)
+        store->index[find_slot(store, store->players[id]->name)] = id + 1;
+    return 1;
+}
+
+/// @brief Id of a player by name
+/// @return the id, or -1 if the name isn't in the store
+int league_find_player(const struct league_store *store, const char *name)
+{
+    uint32_t slot = find_slot(store, name);
+    return store->index[slot] != 0 ? (int)store->index[slot] - 1 : -1;
+}
+
+/// @brief Id of a player by name, adding the player if they're new
+/// @return the id, or -1 if memory could not be allocated
+int league_player_id(struct league_store *store, const char *name)
+{
+    uint32_t slot = find_slot(store, name);
+    if (store->index[slot] != 0)
+        return (int)store->index[slot] - 1;
+
+    if (store->player_count == store->player_capacity)
+    {
+        if (!grow_players(store))
+            return -1;
+        slot = find_slot(store, name);
+    }
+
+    size_t length = strlen(name);
+    struct league_player *player = arena_alloc(&store->arena, sizeof(*player));
+    char *copy = arena_alloc(&store->arena, length + 1);
+    if (!player || !copy)
+        return -1;
+    memcpy(copy, name, length + 1);
+    player->name = copy;
+
+    store->players[store->player_count] = player;
+    store->index[slot] = ++store->player_count;
+    return (int)store->player_count - 1;
+}
+
+/// @brief Count the strikes and spares of a validated game, and the chances of each
+static void count_marks(const struct frame_results frames[MAX_FRAMES], struct league_player *player)
+{
+    for (int i = 0; i < MAX_FRAMES - 1; i++)
+    {
+        player->strike_chances++;
+        if (frames[i].type == STRIKE)
+            player->strikes++;
+        else
+        {
+            player->spare_chances++;
+            player->spares += frames[i].type == SPARE;
+        }
+    }
+
+    // 10th frame: every fresh rack is a strike chance, every rack left standing a spare chance
+    const struct frame_results *last = &frames[MAX_FRAMES - 1];
+    player->strike_chances++;
+    if (last->first_ball == MAX_PINS)
+    {
+        player->strike_chances++;
+        player->strikes++;
+        if (last->second_ball == MAX_PINS)
+        {
+            player->strike_chances++;
+            player->strikes++;
+            player->strikes += last->third_ball == MAX_PINS;
+        }
+        else
+        {
+            player->spare_chances++;
+            player->spares += last->second_ball + last->third_ball == MAX_PINS;
+        }
+    }
+    else
+    {
+        player->spare_chances++;
+        if (last->first_ball + last->second_ball == MAX_PINS)
+        {
+            player->spares++;
+            player->strike_chances++;
+            player->strikes += last->third_ball == MAX_PINS;
+        }
+    }
+}
+
+/// @brief The player's series for the session, added if it's new
+static struct league_series *session_series(struct league_store *store, struct league_player *player,
+                                            uint32_t session)
+{
+    struct league_series_block *block = player->last_series;
+
+    // sessions normally arrive in order, so the latest series is the likely one
+    if (block && block->series[block->count - 1].session == session)
+        return &block->series[block->count - 1];
+    struct league_series *found = (struct league_series *)league_find_series(player, session);
+    if (found)
+        return found;
+
+    if (!block || block->count == LEAGUE_BLOCK_SERIES)
+    {
+        block = arena_alloc(&store->arena, sizeof(*block));
+        if (!block)
+            return NULL;
+        if (player->last_series)
+            player->last_series->next = block;
+        else
+            player->first_series = block;
+        player->last_series = block;
+    }
+    struct league_series *series = &block->series[block->count++];
+    series->session = session;
+    return series;
+}
+
+/// @brief Find the lane's totals, growing the lane table if needed
+static struct league_lane *lane_totals(struct league_store *store, int lane)
+{
+    if (lane >= store->lane_count)
+    {
+        int count = store->lane_count > 0 ? store->lane_count : 64;
+        while (count <= lane)
+            count *= 2;
+        struct league_lane *lanes = realloc(store->lanes, (size_t)count * sizeof(*lanes));
+        if (!lanes)
+            return NULL;
+        memset(lanes + store->lane_count, 0, (size_t)(count - store->lane_count) * sizeof(*lanes));
+        store->lanes = lanes;
+        store->lane_count = count;
+    }
+    return &store->lanes[lane];
+}
+
+/**
+ * Validates, scores and stores a game.
+ *
+ * @param store where the game goes
+ * @param player id from league_player_id()
+ * @param session the session the game was bowled in
+ * @param lane the lane it was bowled on, 0 to LEAGUE_MAX_LANE
+ * @param frames the game
+ * @param error receives the validation result; an invalid game isn't stored
+ * @return 1 if good or 0 if memory could not be allocated or the lane is
+ *         out of range
+ */
+int league_add_game(struct league_store *store, int player_id, uint32_t session, int lane,
+                    const struct frame_results frames[MAX_FRAMES], enum bowling_error *error)
+{
+    struct frame_results scored[MAX_FRAMES];
+    struct league_player *player = store->players[player_id];
+    uint8_t codes[MAX_FRAMES];
+    int cumulative[MAX_FRAMES];
+
+    if (lane < 0 || lane > LEAGUE_MAX_LANE)
+        return 0;
+
+    memcpy(scored, frames, sizeof(scored));
+    *error = validate_and_score_game(scored, cumulative);
+    if (*error == NO_ERROR)
+        *error = encode_game(scored, codes);
+    if (*error != NO_ERROR)
+        return 1;
+
+    struct league_game_block *block = player->last_games;
+    if (!block || block->count == LEAGUE_BLOCK_GAMES)
+    {
+        block = arena_alloc(&store->arena, sizeof(*block));
+        if (!block)
+            return 0;
+        if (player->last_games)
+            player->last_games->next = block;
+        else
+            player->first_games = block;
+        player->last_games = block;
+    }
+
+    struct league_series *series = session_series(store, player, session);
+    struct league_lane *lane_total = lane_totals(store, lane);
+    if (!series || !lane_total)
+        return 0;
+
+    int score = cumulative[MAX_FRAMES - 1];
+    struct league_game *game = &block->games[block->count++];
+    game->session = session;
+    game->lane = (uint16_t)lane;
+    game->score = (uint16_t)score;
+    memcpy(game->codes, codes, sizeof(codes));
+    game->game = (uint8_t)(series->games < UINT8_MAX ? series->games : UINT8_MAX);
+
+    if (series->games < LEAGUE_SERIES_GAMES)
+        series->pins += (uint16_t)score;
+    if (series->games < UINT16_MAX)
+        series->games++;
+
+    player->games++;
+    player->pins += (unsigned long long)score;
+    if (score > player->high_game)
+        player->high_game = score;
+    count_marks(scored, player);
+
+    lane_total->games++;
+    lane_total->pins += (unsigned long long)score;
+    store->games++;
+
+    if (store->board && !leaderboard_add_game(store->board, (uint32_t)player_id, session, score))
+        return 0;
+    return 1;
+}
+
+static int is_separator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '\n';
+}
+
+/// @brief Take the next whitespace separated word, terminating it in place
+static char *next_word(char **p)
+{
+    char *start = *p;
+    while (*start && is_separator(*start))
+        start++;
+    if (!*start)
+        return NULL;
+
+    char *end = start;
+    while (*end && !is_separator(*end))
+        end++;
+    if (*end)
+        *end++ = '\0';
+    *p = end;
+    return start;
+}
+
+/// @brief Parse a word as a number no bigger than 'max'
+/// @return 1 if good or 0 if it isn't one
+static int parse_number(const char *word, unsigned long max, unsigned long *value)
+{
+    char *end;
+    if (!word || *word < '0' || *word > '9')
+        return 0;
+    *value = strtoul(word, &end, 10);
+    return *end == '\0' && *value <= max;
+}
+
+/// @brief Add the game on one line of a league file
+/// @return 1 if good or 0 if memory could not be allocated
+static int load_line(struct league_store *store, char *line, struct league_load_results *results)
+{
+    char *p = line;
+    char *name = next_word(&p);
+    unsigned long session, lane, pins;
+    uint8_t rolls[MAX_ROLLS];
+    int count = 0;
+    int bad = 0;
+
+    if (!name || name[0] == '#')
+        return 1;
+    results->lines++;
+
+    if (!parse_number(next_word(&p), UINT32_MAX, &session) || !parse_number(next_word(&p), LEAGUE_MAX_LANE, &lane))
+        bad = 1;
+    for (char *word; !bad && (word = next_word(&p)) != NULL; )
+    {
+        if (count == MAX_ROLLS || !parse_number(word, MAX_PINS, &pins))
+            bad = 1;
+        else
+            rolls[count++] = (uint8_t)pins;
+    }
+
+    struct frame_results frames[MAX_FRAMES];
+    if (bad || frames_from_rolls(rolls, count, frames) != NO_ERROR)
+    {
+        results->invalid_games++;
+        return 1;
+    }
+
+    int player = league_player_id(store, name);
+    enum bowling_error error;
+    if (player < 0 || !league_add_game(store, player, (uint32_t)session, (int)lane, frames, &error))
+        return 0;
+    if (error != NO_ERROR)
+        results->invalid_games++;
+    return 1;
+}
+
+/**
+ * Adds every game in a league file (format at the top of this file).
+ *
+ * @param store where the games go
+ * @param path file to read, or "-" for stdin
+ * @param results receives the number of game lines and how many were invalid
+ * @return 1 if good or 0 if the file can't be read or memory can't be allocated
+ */
+int league_load(struct league_store *store, const char *path, struct league_load_results *results)
+{
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    char *line = NULL;
+    size_t size = 0;
+    int good = 1;
+
+    memset(results, 0, sizeof(*results));
+    if (!file)
+        return 0;
+    while (good && getline(&line, &size, file) >= 0)
+        good = load_line(store, line, results);
+    if (ferror(file))
+        good = 0;
+
+    free(line);
+    if (file != stdin)
+        fclose(file);
+    return good;
+}
+
+/// @brief Mean score of the player's games, 0 if they have none
+double league_average(const struct league_player *player)
+{
+    return player->games > 0 ? (double)player->pins / player->games : 0.0;
+}
+
+/// @brief Handicap: 'percent' percent of how far the player's average, in whole pins, falls short of 'basis'
+int league_handicap(const struct league_player *player, int basis, int percent)
+{
+    if (player->games == 0)
+        return 0;
+    int average = (int)(player->pins / player->games);
+    return average < basis ? (basis - average) * percent / 100 : 0;
+}
+
+/// @brief Strikes as a percentage of fresh racks
+double league_strike_percent(const struct league_player *player)
+{
+    return player->strike_chances > 0 ? 100.0 * player->strikes / player->strike_chances : 0.0;
+}
+
+/// @brief Spares as a percentage of racks left standing after the first ball
+double league_spare_percent(const struct league_player *player)
+{
+    return player->spare_chances > 0 ? 100.0 * player->spares / player->spare_chances : 0.0;
+}
+
+/// @brief The player's series in a session, or NULL if they didn't bowl in it
+const struct league_series *league_find_series(const struct league_player *player, uint32_t session)
+{
+    for (const struct league_series_block *block = player->first_series; block; block = block->next)
+        for (int i = 0; i < block->count; i++)
+            if (block->series[i].session == session)
+                return &block->series[i];
+    return NULL;
+}
+
+/// @brief Highest total of a full LEAGUE_SERIES_GAMES-game series, 0 if the player has none
+int league_high_series(const struct league_player *player)
+{
+    int high = 0;
+    for (const struct league_series_block *block = player->first_series; block; block = block->next)
+        for (int i = 0; i < block->count; i++)
+            if (block->series[i].games >= LEAGUE_SERIES_GAMES && block->series[i].pins > high)
+                high = block->series[i].pins;
+    return high;
+}
+
+/// @brief Mean score of the games bowled on a lane, 0 if there are none
+double league_lane_average(const struct league_store *store, int lane)
+{
+    if (lane < 0 || lane >= store->lane_count || store->lanes[lane].games == 0)
+        return 0.0;
+    return (double)store->lanes[lane].pins / store->lanes[lane].games;
+}
+
+// highest average first, then by name
+static int compare_standing(const void *a, const void *b)
+{
+    const struct league_player *x = *(const struct league_player *const *)a;
+    const struct league_player *y = *(const struct league_player *const *)b;
+    double ax = league_average(x);
+    double ay = league_average(y);
+    if (ax != ay)
+        return ax < ay ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+static void report_player_line(const struct league_player *player, FILE *out)
+{
+    fprintf(out, "%-16s %6llu %8.2f %5d %8.2f %7.2f %5d %7d\n", player->name, player->games,
+            league_average(player), league_handicap(player, LEAGUE_HANDICAP_BASIS, LEAGUE_HANDICAP_PERCENT),
+            league_strike_percent(player), league_spare_percent(player), player->high_game,
+            league_high_series(player));
+}
+
+/// @brief Print every player's line of the standings, highest average first
+void report_league(const struct league_store *store, FILE *out)
+{
+    const struct league_player **order = malloc((store->player_count > 0 ? store->player_count : 1) * sizeof(*order));
+
+    fprintf(out, "Player            Games  Average  Hdcp  Strike%%  Spare%%  High  Series\n");
+    if (!order)
+        return;
+    for (uint32_t id = 0; id < store->player_count; id++)
+        order[id] = store->players[id];
+    qsort(order, store->player_count, sizeof(*order), compare_standing);
+
+    for (uint32_t i = 0; i < store->player_count; i++)
+        report_player_line(order[i], out);
+    free(order);
+}
+
+/// @brief Print a player's standings line, every game and every series
+void report_league_player(const struct league_store *store, int player_id, FILE *out)
+{
+    const struct league_player *player = store->players[player_id];
+
+    fprintf(out, "Player            Games  Average  Hdcp  Strike%%  Spare%%  High  Series\n");
+    report_player_line(player, out);
+
+    if (store->board)
+    {
+        double average;
+        int games;
+        leaderboard_rolling_average(store->board, (uint32_t)player_id, &average, &games);
+        fprintf(out, "\nLast %d games: %.2f\n", games, average);
+    }
+
+    fprintf(out, "\nSession  Game  Lane  Score\n");
+    for (const struct league_game_block *block = player->first_games; block; block = block->next)
+        for (int i = 0; i < block->count; i++)
+            fprintf(out, "%7u %5d %5u %6u\n", block->games[i].session, block->games[i].game + 1,
+                    block->games[i].lane, block->games[i].score);
+
+    fprintf(out, "\nSession  Games  Series\n");
+    for (const struct league_series_block *block = player->first_series; block; block = block->next)
+        for (int i = 0; i < block->count; i++)
+            fprintf(out, "%7u %6u %7u\n", block->series[i].session, block->series[i].games, block->series[i].pins);
+}
+
+static void report_entries(const struct league_store *store, const char *title,
+                           const struct leaderboard_entry entries[], int count, FILE *out)
+{
+    fprintf(out, "\n%-6s Player           Session\n", title);
+    for (int i = 0; i < count; i++)
+        fprintf(out, "%6u %-16s %7u\n", entries[i].score, store->players[entries[i].player]->name,
+                entries[i].session);
+}
+
+/// @brief Print the store's leaderboard: the top games and the top series
+void report_league_top(const struct league_store *store, FILE *out)
+{
+    struct leaderboard_entry entries[LEADERBOARD_MAX_TOP];
+
+    if (!store->board)
+        return;
+    report_entries(store, "Game", entries, leaderboard_top_games(store->board, entries), out);
+    report_entries(store, "Series", entries, leaderboard_top_series(store->board, entries), out);
+}
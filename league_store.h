@@ -0,0 +1,112 @@
+// league_store.h
+#ifndef LEAGUE_STORE_H
+#define LEAGUE_STORE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "arena.h"
+#include "leaderboard.h"
+
+#define LEAGUE_SERIES_GAMES 3       // games in a series
+#define LEAGUE_BLOCK_GAMES 64       // games in each of a player's game blocks
+#define LEAGUE_BLOCK_SERIES 32      // series in each of a player's series blocks
+#define LEAGUE_MAX_LANE 65535
+#define LEAGUE_HANDICAP_BASIS 220   // default handicap: 90% of the average's shortfall from 220
+#define LEAGUE_HANDICAP_PERCENT 90
+
+// one stored game, 20 bytes
+struct league_game
+{
+    uint32_t session;           // league night, week or tournament round
+    uint16_t lane;
+    uint16_t score;
+    uint8_t codes[MAX_FRAMES];  // the frames as frame codes, see frame_codes.c
+    uint8_t game;               // game number within the session, from 0
+    uint8_t reserved;
+};
+
+struct league_game_block
+{
+    struct league_game_block *next;
+    int count;
+    struct league_game games[LEAGUE_BLOCK_GAMES];
+};
+
+// the games a player bowled in one session
+struct league_series
+{
+    uint32_t session;
+    uint16_t games;             // games bowled in the session
+    uint16_t pins;              // total of the first LEAGUE_SERIES_GAMES of them
+};
+
+struct league_series_block
+{
+    struct league_series_block *next;
+    int count;
+    struct league_series series[LEAGUE_BLOCK_SERIES];
+};
+
+struct league_player
+{
+    const char *name;
+    unsigned long long games;
+    unsigned long long pins;
+    unsigned long long strikes;         // racks cleared with the first ball
+    unsigned long long strike_chances;  // fresh racks
+    unsigned long long spares;          // racks cleared with the second ball
+    unsigned long long spare_chances;   // racks left standing after the first ball
+    int high_game;
+    struct league_game_block *first_games, *last_games;
+    struct league_series_block *first_series, *last_series;
+};
+
+struct league_lane
+{
+    unsigned long long games;
+    unsigned long long pins;
+};
+
+struct league_store
+{
+    struct arena arena;                 // players, names and blocks
+    struct league_player **players;     // by player id
+    uint32_t player_count;
+    uint32_t player_capacity;
+    uint32_t *index;                    // hash of names to player id + 1, 0 for empty
+    uint32_t index_size;                // power of two
+    struct league_lane *lanes;          // by lane number
+    int lane_count;
+    unsigned long long games;
+    struct leaderboard *board;          // if set, every game added is fed to it
+};
+
+struct league_load_results
+{
+    unsigned long long lines;           // game lines read
+    unsigned long long invalid_games;   // lines that weren't a valid game, not stored
+};
+
+int league_init(struct league_store *store);
+void league_free(struct league_store *store);
+int league_player_id(struct league_store *store, const char *name);
+int league_find_player(const struct league_store *store, const char *name);
+int league_add_game(struct league_store *store, int player, uint32_t session, int lane,
+                    const struct frame_results frames[MAX_FRAMES], enum bowling_error *error);
+int league_load(struct league_store *store, const char *path, struct league_load_results *results);
+
+double league_average(const struct league_player *player);
+int league_handicap(const struct league_player *player, int basis, int percent);
+double league_strike_percent(const struct league_player *player);
+double league_spare_percent(const struct league_player *player);
+const struct league_series *league_find_series(const struct league_player *player, uint32_t session);
+int league_high_series(const struct league_player *player);
+double league_lane_average(const struct league_store *store, int lane);
+
+void report_league(const struct league_store *store, FILE *out);
+void report_league_player(const struct league_store *store, int player, FILE *out);
+void report_league_top(const struct league_store *store, FILE *out);
+
+#endif // LEAGUE_STORE_H
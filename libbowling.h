@@ -0,0 +1,67 @@
+/**
+ * @file libbowling.h
+ * @brief Everything libbowling offers, for programs linking the library
+ *
+ * make lib builds libbowling.a and libbowling.so from every source file
+ * but main.c. Everything a call needs is passed in by the caller, so
+ * separate threads can use the library at once as long as each has its
+ * own objects:
+ * - generating games: a struct bowling_rng and a struct roll_model for
+ *   play_game_r(), throw_frame_r() and ball_r(); a roll model, and the
+ *   pin deck it may point to, is only read, so threads can share one
+ * - scoring: the frames, a game_batch or a game_state (live_score.h)
+ * - displaying: the FILE * or game_renderer to write to
+ * - whole runs: run_simulation(), run_verify(), run_lane_simulation() and
+ *   the league store take a config or store object and keep their
+ *   workers and tallies in it or on the heap
+ * - serving lanes: lane_server_start() returns a server that keeps its
+ *   workers and lanes on the heap; each thread submitting rolls takes its
+ *   own handle from lane_server_producer()
+ *
+ * Renderers that write to the same file descriptor from several threads
+ * must be given the same struct render_output by the caller
+ * (renderer_init()); nothing is shared between unrelated renderers.
+ *
+ * The library's global state, all of it safe to share between threads:
+ * the constant frame code tables, the lookup tables of
+ * score_calculator_codes.c and the default roll model (each built once
+ * behind pthread_once() and only read after), the seed and stream count
+ * behind the single game functions (atomics, see below), and, in a make
+ * STATS=1 build only, the --stats counters (bowling_stats.c).
+ *
+ * play_game(), throw_frame() and ball() keep the single game program's
+ * generator and model per thread, set with seed_game() and
+ * use_roll_model() on that thread; a thread that sets neither plays the
+ * default model from its own stream of the last seed given to
+ * seed_game() by any thread.
+ */
+#ifndef LIBBOWLING_H
+#define LIBBOWLING_H
+
+#include "bowling_game.h"
+#include "bowling_rng.h"
+#include "roll_model.h"
+#include "frame_validator.h"
+#include "frame_codes.h"
+#include "game_batch.h"
+#include "score_calculator.h"
+#include "live_score.h"
+#include "bowling_variants.h"
+#include "game_display.h"
+#include "game_render.h"
+#include "game_file.h"
+#include "game_ingest.h"
+#include "simulation.h"
+#include "score_distribution.h"
+#include "what_if.h"
+#include "lane_server.h"
+#include "lane_sim.h"
+#include "league_store.h"
+#include "leaderboard.h"
+#include "verify.h"
+#include "scoreboard.h"
+#include "calibration.h"
+#include "pin_deck.h"
+#include "worker_threads.h"
+
+#endif // LIBBOWLING_H
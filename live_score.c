@@ -0,0 +1,176 @@
+/**
+ * @file live_score.c
+ * @brief Incremental per-roll scoring for live lane displays
+ *
+ * calculate_game_scores() can only score a finished game and recomputes
+ * every frame. push_roll() instead updates a game_state as each ball is
+ * rolled, in constant time:
+ * - the ball is checked against the pins standing with validate_roll(),
+ *   so an illegal roll is rejected before it changes anything
+ * - its pins are added to the frame being bowled and to every earlier
+ *   frame still waiting for bonus balls; there are at most two of those
+ *   (a strike waits for two balls, a spare for one)
+ * - frames whose bonus balls have all been rolled are finalized in order
+ *   and get their running total
+ *
+ * Frame states:
+ * - frames before 'finalized' have their final score and cumulative total
+ * - frames from 'finalized' up to 'frame' have a partial score, waiting
+ *   for balls of their own or bonus balls
+ *
+ * Once the game is complete the frames hold exactly the scores
+ * calculate_game_scores() gives.
+ *
+ * Usage Example:
+ * @code
+ * struct game_state state;
+ * init_game_state(&state);
+ * if (push_roll(&state, pins) != NO_ERROR) {
+ *     // illegal roll, state is unchanged
+ * }
+ * @endcode
+ */
+#include "live_score.h"
+#include "frame_validator.h"
+
+/// @brief Start a new game with no balls rolled
+void init_game_state(struct game_state *state)
+{
+    init_game_results(state->frames);
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        state->cumulative[i] = 0;
+        state->bonus_balls[i] = 0;
+    }
+    state->frame = 0;
+    state->ball = 0;
+    state->finalized = 0;
+    state->total = 0;
+    state->live_total = 0;
+}
+
+/// @brief Has the last ball of the game been rolled?
+/// @return 1 if the game is over or 0 if not
+int game_state_complete(const struct game_state *state)
+{
+    return state->frame == MAX_FRAMES;
+}
+
+/// @brief Finalize every frame that isn't waiting for any more balls
+static void finalize_frames(struct game_state *state)
+{
+    while (state->finalized < state->frame && state->bonus_balls[state->finalized] == 0)
+    {
+        state->total += state->frames[state->finalized].score;
+        state->cumulative[state->finalized] = state->total;
+        state->finalized++;
+    }
+}
+
+/**
+ * Adds one ball to the game.
+ *
+ * @param state The game so far
+ * @param pins Pins knocked down by the ball
+ *
+ * @return NO_ERROR, INVALID_PINS if more pins than are standing (or fewer
+ *         than 0) were knocked down, or TOO_MANY_ROLLS if the game is over.
+ *         On an error the state is not changed.
+ */
+enum bowling_error push_roll(struct game_state *state, int pins)
+{
+    if (game_state_complete(state))
+        return TOO_MANY_ROLLS;
+
+    struct frame_results *frame = &state->frames[state->frame];
+    enum bowling_error error = validate_roll(frame, state->frame, state->ball, pins);
+    if (error != NO_ERROR)
+        return error;
+
+    // earlier frames still waiting for bonus balls, at most two
+    for (int i = state->finalized; i < state->frame; i++)
+    {
+        if (state->bonus_balls[i] > 0)
+        {
+            state->frames[i].score += pins;
+            state->bonus_balls[i]--;
+            state->live_total += pins;
+        }
+    }
+
+    if (state->ball == 0)
+        frame->first_ball = pins;
+    else if (state->ball == 1)
+        frame->second_ball = pins;
+    else
+        frame->third_ball = pins;
+    frame->score += pins;
+    state->live_total += pins;
+    state->ball++;
+
+    // is the frame over?
+    int frame_over;
+    if (state->frame < MAX_FRAMES - 1)
+    {
+        if (frame->first_ball == MAX_PINS)
+        {
+            frame->type = STRIKE;
+            state->bonus_balls[state->frame] = 2;
+            frame_over = 1;
+        }
+        else if (state->ball == 2)
+        {
+            frame->type = frame->first_ball + frame->second_ball == MAX_PINS ? SPARE : OPEN;
+            state->bonus_balls[state->frame] = frame->type == SPARE ? 1 : 0;
+            frame_over = 1;
+        }
+        else
+            frame_over = 0;
+    }
+    else
+    {
+        // 10th frame ends when it gets no further ball
+        frame_over = pins_standing(frame, state->frame, state->ball) < 0;
+        if (frame_over)
+            frame->type = LAST_FRAME;
+    }
+
+    if (frame_over)
+    {
+        state->frame++;
+        state->ball = 0;
+    }
+    finalize_frames(state);
+    return NO_ERROR;
+}
+
+/**
+ * Replays the recorded frames of a game, for example a game in progress,
+ * into a game_state.
+ *
+ * @param frames the game; it ends at the first UNDEFINED frame, and frame
+ *               types are worked out again from the balls
+ * @param state receives the game so far
+ *
+ * @return NO_ERROR, or the push_roll() error for the first illegal ball,
+ *         in which case the state holds the balls before it
+ */
+enum bowling_error game_state_from_frames(const struct frame_results frames[MAX_FRAMES], struct game_state *state)
+{
+    init_game_state(state);
+
+    for (int i = 0; i < MAX_FRAMES && frames[i].type != UNDEFINED; i++)
+    {
+        const struct frame_results *frame = &frames[i];
+        int balls[3] = { frame->first_ball, frame->second_ball, frame->third_ball };
+
+        // push balls until the frame is over, which push_roll() decides by the same rules
+        for (int b = 0; b < 3 && state->frame == i; b++)
+        {
+            enum bowling_error error = push_roll(state, balls[b]);
+            if (error != NO_ERROR)
+                return error;
+        }
+    }
+    return NO_ERROR;
+}
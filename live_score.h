@@ -0,0 +1,24 @@
+// live_score.h
+#ifndef LIVE_SCORE_H
+#define LIVE_SCORE_H
+
+#include "bowling_game.h"
+
+struct game_state
+{
+    struct frame_results frames[MAX_FRAMES];    // balls so far, score includes bonuses so far
+    int cumulative[MAX_FRAMES];     // running total, set once a frame is finalized
+    int bonus_balls[MAX_FRAMES];    // bonus balls each frame is still waiting for
+    int frame;                      // frame being bowled, MAX_FRAMES once the game is over
+    int ball;                       // next ball within the frame
+    int finalized;                  // frames whose score can no longer change
+    int total;                      // score of the finalized frames
+    int live_total;                 // every pin and bonus counted so far
+};
+
+void init_game_state(struct game_state *state);
+enum bowling_error push_roll(struct game_state *state, int pins);
+int game_state_complete(const struct game_state *state);
+enum bowling_error game_state_from_frames(const struct frame_results frames[MAX_FRAMES], struct game_state *state);
+
+#endif // LIVE_SCORE_H
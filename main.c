@@ -0,0 +1,829 @@
+/**
+ * @file main.c
+ * @brief Program entry point and command line handling
+ *
+ * With no arguments a single random game is played, validated, scored
+ * and displayed.
+ *
+ * Usage:
+ *   bowling_game [--seed S] [--rng NAME] [--model FILE] [--format F]
+ *   bowling_game --simulate N [--threads T] [--seed S] [--rng NAME] [--model FILE] [--format F]
+ *   bowling_game --replay K --rng philox [--seed S] [--model FILE] [--format F]
+ *   bowling_game --ingest FILE [--rules VARIANT]
+ *   bowling_game --pack TEXT GAMES
+ *   bowling_game --unpack GAMES [--game K] [--format F]
+ *   bowling_game --summary GAMES
+ *   bowling_game --distribution [--model FILE]
+ *   bowling_game --what-if ROLLS [--target X] [--model FILE]
+ *   bowling_game --serve LANES [--games G] [--threads T] [--producers P] [--seed S] [--format F]
+ *                [--scoreboard NAME]
+ *   bowling_game --watch NAME [--lane L]
+ *   bowling_game --league FILE [--player NAME] [--top K]
+ *   bowling_game --verify N [--threads T] [--seed S]
+ *   bowling_game --calibrate CORPUS [--by GROUP] [--output PATH] [--threads T]
+ *   bowling_game --splits N [--seed S] [--rng NAME] [--model FILE]
+ *
+ * Any of them also takes --stats, and any that plays games --pins.
+ *
+ * Options:
+ * --simulate N  play N games and report the final score distribution
+ * --threads T   worker threads for --simulate, --verify or --calibrate,
+ *               default one per core, at most 256
+ * --seed S      seed for the random number generator, default the time
+ * --rng NAME    random number generator: xoshiro (default), pcg, splitmix
+ *               or philox; with philox every game of --simulate or --serve
+ *               is a function of the seed and its game number only
+ * --replay K    play game K (counting from 0) of a --simulate --rng philox
+ *               run with the same seed and model again, on its own
+ * --model FILE  roll probabilities, see roll_model.c for the format
+ * --pins        play each rack as the pins left standing, with a pin deck
+ *               built on the roll model, see pin_deck.c
+ * --ingest FILE validate and score recorded games, "-" for stdin; see
+ *               game_ingest.c for the formats
+ * --rules VARIANT  with --ingest, score the games as tenpin (default),
+ *               candlepin, duckpin or fivepin, see bowling_variants.h
+ * --pack TEXT GAMES  convert games printed by this program to a binary
+ *               game file, see game_file.c
+ * --unpack GAMES  print the games in a binary game file
+ * --game K      with --unpack, print only game K (counting from 0)
+ * --summary GAMES  report the final score distribution of the games in a
+ *               binary game file, scored straight from the stored codes
+ * --distribution  print the exact probability of every final score under
+ *               the roll model, see score_distribution.c
+ * --what-if ROLLS  for a game in progress, given as the pins of each ball
+ *               so far ("10 7 3 9"), print the highest possible, expected
+ *               and likely final scores, see what_if.c
+ * --target X    with --what-if, the score to give the chance of reaching,
+ *               default 200
+ * --serve LANES  score LANES lanes at once, fed by simulated pinsetters,
+ *               and report the throughput, see lane_sim.c and lane_server.c
+ * --games G     with --serve, games each lane bowls, default 10
+ * --producers P with --serve, lane simulator threads, default 1
+ * --scoreboard NAME  with --serve, publish every lane's game after each
+ *               roll to the shared memory scoreboard NAME, see scoreboard.c
+ * --watch NAME  print the games on the shared memory scoreboard NAME, one
+ *               line per lane
+ * --lane L      with --watch, print lane L's game frame by frame
+ * --league FILE load a league's games, "-" for stdin, and print the
+ *               standings, see league_store.c for the format
+ * --player NAME with --league, print only that player's line, games and
+ *               series, and their average over their last 10 games
+ * --top K       with --league, also print the K highest games and series,
+ *               see leaderboard.c
+ * --verify N    score every legal frame triple and N random games with
+ *               every scorer and compare them with a reference scorer,
+ *               see verify.c; --threads and --seed as for --simulate
+ * --calibrate CORPUS  fit a roll model, for --model, to the games in a
+ *               binary game file, recorded games (as for --ingest) or a
+ *               league file, see calibration.c; fails unless at least
+ *               half the games are valid
+ * --by GROUP    with --calibrate on a league file, write a model per
+ *               player or lane instead, as NAME.model or laneN.model
+ * --output PATH with --calibrate, the model file, default stdout, or with
+ *               --by the directory for the models, default the current one
+ * --splits N    play N games with the pin deck and report how often racks
+ *               were split and converted, and the most common leaves
+ * --format F    print games as human (default), csv, json or binary, see
+ *               game_render.c; with --simulate or --serve every game is
+ *               printed, in no set order across threads, and the summary
+ *               goes to stderr; binary output is a game file
+ * --stats       when done, print the time spent in each stage and the
+ *               errors found to stderr; needs a make STATS=1 build, which
+ *               also prints them on SIGUSR1, see bowling_stats.c
+ *
+ * A numeric option given anything but a whole number in its range prints
+ * the usage and fails.
+ *
+ * Returns 1 if the game(s) completed and 0 on an error, matching the
+ * original single game behaviour.
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bowling_game.h"
+#include "frame_validator.h"
+#include "score_calculator.h"
+#include "simulation.h"
+#include "roll_model.h"
+#include "game_ingest.h"
+#include "game_file.h"
+#include "game_render.h"
+#include "score_distribution.h"
+#include "what_if.h"
+#include "lane_server.h"
+#include "lane_sim.h"
+#include "bowling_stats.h"
+#include "league_store.h"
+#include "verify.h"
+#include "scoreboard.h"
+#include "calibration.h"
+#include "pin_deck.h"
+#include "worker_threads.h"
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--seed S] [--rng NAME] [--model FILE] [--format F]\n", program);
+    fprintf(stderr, "       %s --simulate N [--threads T] [--seed S] [--rng NAME] [--model FILE] [--format F]\n", program);
+    fprintf(stderr, "       %s --replay K --rng philox [--seed S] [--model FILE] [--format F]\n", program);
+    fprintf(stderr, "       %s --ingest FILE [--rules VARIANT]\n", program);
+    fprintf(stderr, "       %s --pack TEXT GAMES\n", program);
+    fprintf(stderr, "       %s --unpack GAMES [--game K] [--format F]\n", program);
+    fprintf(stderr, "       %s --summary GAMES\n", program);
+    fprintf(stderr, "       %s --distribution [--model FILE]\n", program);
+    fprintf(stderr, "       %s --what-if ROLLS [--target X] [--model FILE]\n", program);
+    fprintf(stderr, "       %s --serve LANES [--games G] [--threads T] [--producers P] [--seed S] [--format F]\n"
+                    "                [--scoreboard NAME]\n",
+            program);
+    fprintf(stderr, "       %s --watch NAME [--lane L]\n", program);
+    fprintf(stderr, "       %s --league FILE [--player NAME] [--top K]\n", program);
+    fprintf(stderr, "       %s --verify N [--threads T] [--seed S]\n", program);
+    fprintf(stderr, "       %s --calibrate CORPUS [--by player|lane] [--output PATH] [--threads T]\n", program);
+    fprintf(stderr, "       %s --splits N [--seed S] [--rng NAME] [--model FILE]\n", program);
+    fprintf(stderr, "       any of them with --stats, and any that plays games with --pins\n");
+}
+
+/**
+ * Reads the number given to a command line option.
+ *
+ * @param option the option, for the error message
+ * @param text its argument, a whole number with nothing after it
+ * @param base as for strtoull(), 0 to also take hex and octal
+ * @param value receives the number, from min to max
+ * @return 1 if good or 0, with the error printed, if it isn't such a number
+ */
+static int parse_number(const char *option, const char *text, int base, unsigned long long min,
+                        unsigned long long max, unsigned long long *value)
+{
+    const char *p = text;
+    char *end;
+
+    while (isspace((unsigned char)*p))
+        p++;
+    errno = 0;
+    *value = strtoull(p, &end, base);
+    // strtoull() takes a minus sign and negates, so "-1" would be ULLONG_MAX
+    if (*p == '-' || end == p || *end != '\0' || errno == ERANGE || *value < min || *value > max)
+    {
+        fprintf(stderr, "Error: %s needs a number from %llu to %llu, not \"%s\"\n", option, min, max, text);
+        return 0;
+    }
+    return 1;
+}
+
+static void report_stats(void)
+{
+    stats_report(stderr);
+}
+
+static int ingest(const char *path, enum bowling_variant variant)
+{
+    static char output_buffer[1 << 20];
+    struct ingest_results results;
+
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+    int good = ingest_games(path, stdout, variant, &results);
+    fflush(stdout);
+    if (!good)
+    {
+        fprintf(stderr, "Error: can't read %s\n", path);
+        return 0;
+    }
+
+    fprintf(stderr, "Games: %llu Invalid: %llu\n", results.games, results.invalid_games);
+    return 1;
+}
+
+/// @brief Print the outlook for a game given as the pins of each ball so far
+static int what_if(const char *rolls, int target, const struct roll_model *model)
+{
+    static struct what_if_tables tables;
+    struct game_state state;
+    struct what_if_result result;
+    char *end;
+    int ball = 0;
+
+    init_game_state(&state);
+    for (const char *p = rolls; ; p = end)
+    {
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0')
+            break;
+        ball++;
+        long pins = strtol(p, &end, 10);
+        if (end == p || (*end != '\0' && !isspace((unsigned char)*end)))
+        {
+            fprintf(stderr, "Error: ball %d is not a pin count\n", ball);
+            return 0;
+        }
+        enum bowling_error error = pins < 0 || pins > MAX_PINS ? INVALID_PINS : push_roll(&state, (int)pins);
+        if (error != NO_ERROR)
+        {
+            fprintf(stderr, "Error: %s at ball %d (%ld pins)\n", bowling_error_name(error), ball, pins);
+            return 0;
+        }
+    }
+
+    what_if_init(&tables, model);
+    what_if_query(&tables, &state, target, &result);
+    printf("Score:    %8d\n", result.score);
+    printf("Max:      %8d\n", result.max_score);
+    printf("Expected: %8.2f\n", result.expected_score);
+    printf("P(>=%d): %8.6f\n", target, result.chance);
+    return 1;
+}
+
+/// @brief lane_publish_fn that copies each lane's game to the shared memory scoreboard 'board'
+static void publish_to_scoreboard(void *board, int lane, const struct game_state *state)
+{
+    scoreboard_publish(board, lane, state);
+}
+
+/// @brief Run the lane server with simulated lanes and report its throughput
+static int serve(const struct simulation_config *simulation, int lanes, unsigned long long games, int producers,
+                 const char *scoreboard_name, FILE *out)
+{
+    struct lane_sim_config config = { { lanes, producers, simulation->threads, games, simulation->render, NULL, NULL },
+                                      producers, games, simulation->seed, simulation->rng, simulation->model };
+    struct lane_server_results results;
+    struct scoreboard board;
+
+    if (scoreboard_name)
+    {
+        if (!scoreboard_create(&board, scoreboard_name, lanes))
+        {
+            fprintf(stderr, "Error: can't create scoreboard %s\n", scoreboard_name);
+            return 0;
+        }
+        config.server.publish = publish_to_scoreboard;
+        config.server.publish_context = &board;
+    }
+
+    int good = run_lane_simulation(&config, &results);
+    if (scoreboard_name)
+        scoreboard_close(&board);
+    if (!good)
+    {
+        fprintf(stderr, "Error: can't start the lane server or write the games\n");
+        return 0;
+    }
+    fprintf(out, "Lanes:         %12d\n", lanes);
+    report_lane_server(&results, out);
+    return 1;
+}
+
+/// @brief Print the games on a shared memory scoreboard, or one lane's game
+static int watch(const char *name, int lane)
+{
+    struct scoreboard board;
+
+    if (!scoreboard_open(&board, name))
+    {
+        fprintf(stderr, "Error: can't open scoreboard %s\n", name);
+        return 0;
+    }
+    int good = 1;
+    if (lane < 0)
+        report_scoreboard(&board, stdout);
+    else if (!report_scoreboard_lane(&board, lane, stdout))
+    {
+        fprintf(stderr, "Error: can't read lane %d\n", lane);
+        good = 0;
+    }
+    scoreboard_close(&board);
+    return good;
+}
+
+/// @brief Load a league file and print the standings, or one player's record
+static int league(const char *path, const char *player_name, int top)
+{
+    static struct leaderboard board;
+    struct league_store store;
+    struct league_load_results results;
+    int good = 1;
+
+    if (!league_init(&store))
+    {
+        fprintf(stderr, "Error: out of memory\n");
+        return 0;
+    }
+    leaderboard_init(&board, top, LEADERBOARD_WINDOW);
+    store.board = &board;
+    if (!league_load(&store, path, &results))
+    {
+        fprintf(stderr, "Error: can't read %s\n", path);
+        league_free(&store);
+        leaderboard_free(&board);
+        return 0;
+    }
+    fprintf(stderr, "Games: %llu Invalid: %llu Players: %u\n", results.lines, results.invalid_games,
+            store.player_count);
+
+    if (!player_name)
+    {
+        report_league(&store, stdout);
+        if (top > 0)
+            report_league_top(&store, stdout);
+    }
+    else
+    {
+        int player = league_find_player(&store, player_name);
+        if (player >= 0)
+            report_league_player(&store, player, stdout);
+        else
+        {
+            fprintf(stderr, "Error: no player %s\n", player_name);
+            good = 0;
+        }
+    }
+    league_free(&store);
+    leaderboard_free(&board);
+    return good;
+}
+
+/// @brief Tell if enough of a corpus's games are valid to fit a model to, saying why not if they aren't
+static int corpus_usable(const char *corpus, unsigned long long games, unsigned long long invalid)
+{
+    unsigned long long valid = games - invalid;
+
+    if (valid == 0 || (double)valid < CALIBRATION_MIN_VALID * (double)games)
+    {
+        fprintf(stderr, "Error: only %llu of %llu games in %s are valid\n", valid, games, corpus);
+        return 0;
+    }
+    return 1;
+}
+
+/// @brief Fit a roll model to a game file, recorded games or league file, or a model per player or lane of a league file
+static int calibrate(const char *corpus, enum calibration_group by, const char *output, int threads)
+{
+    struct calibration_results results;
+    struct roll_model model;
+    enum calibration_corpus kind;
+    int good;
+
+    if (!calibration_corpus_kind(corpus, &kind))
+    {
+        fprintf(stderr, "Error: can't read %s\n", corpus);
+        return 0;
+    }
+    if (kind != CORPUS_LEAGUE && by != CALIBRATE_ALL)
+    {
+        fprintf(stderr, "Error: --by needs a league file, %s is %s\n", corpus,
+                kind == CORPUS_GAME_FILE ? "a game file" : "recorded games");
+        return 0;
+    }
+
+    if (kind == CORPUS_GAME_FILE)
+        good = calibrate_game_file(corpus, threads, &results);
+    else if (kind == CORPUS_RECORDED_GAMES)
+        good = calibrate_recorded_games(corpus, &results);
+    else
+    {
+        struct league_store store;
+        struct league_load_results loaded;
+        if (!league_init(&store))
+        {
+            fprintf(stderr, "Error: out of memory\n");
+            return 0;
+        }
+        if (!league_load(&store, corpus, &loaded))
+        {
+            fprintf(stderr, "Error: can't read %s\n", corpus);
+            league_free(&store);
+            return 0;
+        }
+        // checked before any per player or lane model is written
+        if (!corpus_usable(corpus, loaded.lines, loaded.invalid_games))
+        {
+            league_free(&store);
+            return 0;
+        }
+        good = calibrate_league(&store, by, threads, output ? output : ".", &results);
+        results.games += loaded.invalid_games;
+        results.invalid_games += loaded.invalid_games;
+        league_free(&store);
+    }
+    if (!good)
+    {
+        fprintf(stderr, "Error: out of memory or can't write the models\n");
+        return 0;
+    }
+    if (!corpus_usable(corpus, results.games, results.invalid_games))
+        return 0;
+
+    if (by == CALIBRATE_ALL)
+    {
+        calibration_fit(&results.counts, NULL, 0, &model);
+        if (!calibration_save(&model, &results.counts, output))
+        {
+            fprintf(stderr, "Error: can't write %s\n", output ? output : "stdout");
+            return 0;
+        }
+    }
+    report_calibration(&results, stderr);
+    return 1;
+}
+
+/// @brief Play games with a pin deck and report the leaves, splits and spares
+static int split_statistics(const struct simulation_config *config, const struct pin_deck *deck)
+{
+    struct frame_results frames[MAX_FRAMES];
+    struct bowling_rng rng;
+
+    struct pin_deck_stats *stats = calloc(1, sizeof(*stats));
+    if (!stats)
+    {
+        fprintf(stderr, "Error: out of memory\n");
+        return 0;
+    }
+    bowling_rng_init(&rng, config->rng, config->seed, 0);
+    for (unsigned long long game = 0; game < config->games; game++)
+    {
+        init_game_results(frames);
+        pin_deck_play_game(frames, deck, &rng, stats);
+    }
+    report_pin_deck_stats(stats, stdout);
+    free(stats);
+    return 1;
+}
+
+/// @brief Compare every scorer with the reference scorer, see verify.c
+/// @return 1 if they all agree on every game
+static int verify_scorers(const struct simulation_config *simulation)
+{
+    struct verify_config config = { simulation->games, simulation->threads, simulation->seed };
+    struct verify_results results;
+
+    if (!run_verify(&config, &results))
+    {
+        fprintf(stderr, "Error: out of memory\n");
+        return 0;
+    }
+    report_verify(&config, &results, stdout);
+    return verify_mismatches(&results) == 0;
+}
+
+/// @brief Play, score and print one game; with a counter-based generator, game 'game' of a simulation
+static int play_single_game(const struct simulation_config *config, unsigned long long game,
+                            enum render_format format)
+{
+    struct frame_results frames[MAX_FRAMES];
+    struct game_renderer render;
+    struct bowling_rng rng;
+
+    // seed random number generator
+    bowling_rng_init(&rng, config->rng, config->seed, 0);
+    bowling_rng_seek(&rng, game);
+
+    // Initiate game results
+    init_game_results(frames);
+
+    STATS_START(generate);
+    play_game_r(frames, config->model, &rng);
+    STATS_STOP(STAGE_GENERATE, generate, 1);
+
+    // Validate and score the game in one pass
+    STATS_START(score);
+    enum bowling_error error = validate_and_score_game(frames, NULL);
+    STATS_STOP(STAGE_SCORE, score, 1);
+    if (error != NO_ERROR)
+        STATS_ERROR(error);
+
+    if (!renderer_init(&render, STDOUT_FILENO, format, NULL))
+        return 0;
+    STATS_START(output);
+    render_header(&render, 1);
+    render_game(&render, game, frames, error);
+    int written = renderer_finish(&render);
+    STATS_STOP(STAGE_OUTPUT, output, 1);
+
+    return error == NO_ERROR && written;
+}
+
+int main(int argc, char *argv[])
+{
+    struct simulation_config config = { 0, 0, (uint64_t)time(NULL), RNG_XOSHIRO256, NULL, NULL };
+    struct roll_model model;
+    static struct pin_deck deck;
+    const char *model_path = NULL;
+    int pins = 0;
+    int splits = 0;
+    const char *ingest_path = NULL;
+    enum bowling_variant variant = VARIANT_TENPIN;
+    const char *pack_path = NULL;
+    const char *game_path = NULL;
+    const char *summary_path = NULL;
+    long long game = -1;
+    long long replay = -1;
+    int simulate = 0;
+    int distribution = 0;
+    const char *what_if_rolls = NULL;
+    int target = 200;
+    int serve_lanes = 0;
+    unsigned long long serve_games = 10;
+    int producers = 0;
+    enum render_format format = RENDER_HUMAN;
+    int format_set = 0;
+    int stats = 0;
+    const char *league_path = NULL;
+    const char *player_name = NULL;
+    int top = 0;
+    int verify = 0;
+    const char *scoreboard_name = NULL;
+    const char *watch_name = NULL;
+    int lane = -1;
+    const char *calibrate_path = NULL;
+    enum calibration_group calibrate_by = CALIBRATE_ALL;
+    const char *output_path = NULL;
+    unsigned long long number;
+    int good = 1;
+
+    for (int i = 1; i < argc && good; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--simulate") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, ULLONG_MAX, &config.games);
+            i++;
+            simulate = 1;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--replay") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, LLONG_MAX, &number);
+            replay = (long long)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, MAX_THREADS, &number);
+            config.threads = (int)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 0, 0, UINT64_MAX, &number);
+            config.seed = (uint64_t)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--model") == 0)
+            model_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--ingest") == 0)
+            ingest_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--rules") == 0)
+        {
+            if (!variant_from_name(argv[++i], &variant))
+            {
+                usage(argv[0]);
+                return 0;
+            }
+        }
+        else if (i + 2 < argc && strcmp(argv[i], "--pack") == 0)
+        {
+            pack_path = argv[++i];
+            game_path = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--unpack") == 0)
+            game_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--summary") == 0)
+            summary_path = argv[++i];
+        else if (strcmp(argv[i], "--distribution") == 0)
+            distribution = 1;
+        else if (i + 1 < argc && strcmp(argv[i], "--what-if") == 0)
+            what_if_rolls = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--target") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, MAX_SCORE, &number);
+            target = (int)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--serve") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 1, INT_MAX, &number);
+            serve_lanes = (int)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--games") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, ULLONG_MAX, &serve_games);
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--producers") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, MAX_THREADS, &number);
+            producers = (int)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--scoreboard") == 0)
+            scoreboard_name = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--watch") == 0)
+            watch_name = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--lane") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, INT_MAX, &number);
+            lane = (int)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--league") == 0)
+            league_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--player") == 0)
+            player_name = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--top") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, LEADERBOARD_MAX_TOP, &number);
+            top = (int)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--verify") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, ULLONG_MAX, &config.games);
+            i++;
+            verify = 1;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--calibrate") == 0)
+            calibrate_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--by") == 0)
+        {
+            i++;
+            if (strcmp(argv[i], "player") == 0)
+                calibrate_by = CALIBRATE_BY_PLAYER;
+            else if (strcmp(argv[i], "lane") == 0)
+                calibrate_by = CALIBRATE_BY_LANE;
+            else
+            {
+                usage(argv[0]);
+                return 0;
+            }
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--output") == 0)
+            output_path = argv[++i];
+        else if (strcmp(argv[i], "--pins") == 0)
+            pins = 1;
+        else if (i + 1 < argc && strcmp(argv[i], "--splits") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, ULLONG_MAX, &config.games);
+            i++;
+            splits = 1;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+            stats = 1;
+        else if (i + 1 < argc && strcmp(argv[i], "--game") == 0)
+        {
+            good = parse_number(argv[i], argv[i + 1], 10, 0, LLONG_MAX, &number);
+            game = (long long)number;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--format") == 0)
+        {
+            format_set = render_format_from_name(argv[++i], &format);
+            if (!format_set)
+            {
+                usage(argv[0]);
+                return 0;
+            }
+        }
+        else if (!(i + 1 < argc && strcmp(argv[i], "--rng") == 0 && rng_kind_from_name(argv[++i], &config.rng)))
+        {
+            usage(argv[0]);
+            return 0;
+        }
+    }
+    if (!good)
+    {
+        usage(argv[0]);
+        return 0;
+    }
+
+    stats_watch_signal();
+    if (stats)
+        atexit(report_stats);
+
+    if (ingest_path)
+        return ingest(ingest_path, variant);
+
+    if (league_path)
+        return league(league_path, player_name, top);
+
+    if (verify)
+        return verify_scorers(&config);
+
+    if (watch_name)
+        return watch(watch_name, lane);
+
+    if (calibrate_path)
+        return calibrate(calibrate_path, calibrate_by, output_path, config.threads);
+
+    if (pack_path)
+    {
+        uint64_t games;
+        if (!pack_game_text(pack_path, game_path, &games))
+        {
+            fprintf(stderr, "Error: can't pack %s into %s\n", pack_path, game_path);
+            return 0;
+        }
+        fprintf(stderr, "Games: %llu\n", (unsigned long long)games);
+        return 1;
+    }
+
+    if (summary_path)
+    {
+        static struct simulation_results results;
+        uint64_t games, invalid;
+        if (!score_game_file(summary_path, results.histogram, &games, &invalid))
+        {
+            fprintf(stderr, "Error: can't read game file %s\n", summary_path);
+            return 0;
+        }
+        results.games = games;
+        results.invalid_games = invalid;
+        report_simulation(&results, stdout);
+        return 1;
+    }
+
+    if (game_path)
+    {
+        if (!unpack_game_file(game_path, game, format))
+        {
+            if (game >= 0)
+                fprintf(stderr, "Error: can't read game %lld of game file %s\n", game, game_path);
+            else
+                fprintf(stderr, "Error: can't read game file %s\n", game_path);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (!model_path)
+        roll_model_default(&model);
+    else if (!roll_model_load(&model, model_path))
+    {
+        fprintf(stderr, "Error: can't load roll model %s\n", model_path);
+        return 0;
+    }
+    if (pins || splits)
+    {
+        pin_deck_init(&deck, &model);
+        pin_deck_roll_model(&deck, &model);
+    }
+    config.model = &model;
+
+    if (splits)
+        return split_statistics(&config, &deck);
+
+    if (what_if_rolls)
+        return what_if(what_if_rolls, target, &model);
+
+    if (distribution)
+    {
+        double pmf[MAX_SCORE + 1];
+        score_distribution(&model, pmf);
+        report_distribution(pmf, stdout);
+        return 1;
+    }
+
+    if (replay >= 0)
+    {
+        if (config.rng != RNG_PHILOX)
+        {
+            fprintf(stderr, "Error: --replay needs --rng philox\n");
+            return 0;
+        }
+        return play_single_game(&config, (unsigned long long)replay, format);
+    }
+
+    if (!simulate && serve_lanes <= 0)
+        return play_single_game(&config, 0, format);
+
+    // writes the header; the workers render the games with their own buffers, sharing its output
+    struct game_renderer render;
+    struct render_output output = RENDER_OUTPUT_INITIALIZER;
+    if (format_set)
+    {
+        if (!renderer_init(&render, STDOUT_FILENO, format, &output))
+        {
+            fprintf(stderr, "Error: out of memory\n");
+            return 0;
+        }
+        render_header(&render, serve_lanes > 0 ? (unsigned long long)serve_lanes * serve_games : config.games);
+        renderer_finish(&render);
+        config.render = &render;
+    }
+
+    if (serve_lanes > 0)
+        return serve(&config, serve_lanes, serve_games, producers, scoreboard_name, format_set ? stderr : stdout);
+
+    struct simulation_results results;
+    if (!run_simulation(&config, &results))
+    {
+        fprintf(stderr, "Error: out of memory or can't write the games\n");
+        return 0;
+    }
+    report_simulation(&results, format_set ? stderr : stdout);
+
+    return 1;
+}
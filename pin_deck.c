@@ -0,0 +1,483 @@
+/**
+ * @file pin_deck.c
+ * @brief Pin-level rack model: which pins stand, splits and spare conversion
+ *
+ * The roll model (roll_model.c) only knows how many pins are standing, so
+ * a 7-10 split and a 4-5 spare look the same to it. The pin deck plays
+ * each rack as the set of pins left standing, a 10-bit mask with bit i
+ * set if pin i + 1 stands:
+ * @code
+ *   7   8   9   10
+ *     4   5   6
+ *       2   3
+ *         1
+ * @endcode
+ * - the first ball at a full rack draws the leave, one of the 1024 masks,
+ *   from an alias table over all of them: one generator call, one compare
+ * - a spare attempt clears the leave with that leave's own conversion
+ *   probability, and a miss knocks down a count of its pins as the miss
+ *   rows give (a roll model whose rows can't clear the rack); both are
+ *   folded into one alias table per leave, so it is one draw as well
+ * - pins knocked down are the popcount of what the ball took, so the
+ *   frame_results are filled exactly as throw_frame_r() fills them
+ *
+ * A roll model with its deck set (pin_deck_roll_model()) makes
+ * throw_frame_r() play this way, so --simulate, --serve and --replay all
+ * can. That model's count rows are the ones the deck implies, so
+ * score_distribution() and what_if() agree with the games it plays.
+ *
+ * Default deck (pin_deck_init()), built on a count model so that the
+ * first ball's count and each spare count's conversion rate match it:
+ * - within each count, a leave's weight is the product of how readily
+ *   each of its pins is left (a right-hander's 10 pin and 7 pin most, the
+ *   head pin hardly ever), a twentieth of that for a split
+ * - within each count, a split is converted 0.15 as often as a leave
+ *   whose pins touch, the rate for the count staying the model's
+ * A calibrated deck can replace the tables with pin_deck_set().
+ *
+ * Splits follow the USBC definition: the head pin is down, two or more
+ * pins stand, and either a pin is down between standing pins (they don't
+ * all touch) or a pin is down immediately ahead of two standing pins.
+ *
+ * Example (--splits 1000000 --seed 1, default model; --simulate --pins
+ * plays within 5% of the speed of the count model, with the same score
+ * distribution):
+ * Games:               1000000
+ * Racks:              10572193
+ * Strikes:              24.53%
+ * Splits:                9.63%
+ * Spares made:          39.56%
+ * Splits made:           6.40%
+ * Leave                         Left%   Made%
+ * 10                             4.78   39.98
+ * 1-2-3-4-5-6-7-8-9-10           4.54   24.46
+ * 6-10                           3.87   41.47
+ * ...
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "pin_deck.h"
+
+#define SPLIT_LEAVE_WEIGHT 0.05     // a split is left this much less often than a leave that touches
+#define SPLIT_CONVERSION 0.15       // and converted this much less often
+
+// position of pins 1-10 in the rack: row from the head pin, and across in half pin spacings
+static const int pin_row[MAX_PINS] = { 0, 1, 1, 2, 2, 2, 3, 3, 3, 3 };
+static const int pin_x[MAX_PINS] = { 0, -1, 1, -2, 0, 2, -3, -1, 1, 3 };
+
+// how readily a right-hander's first ball leaves each pin standing, pins 1-10
+static const double stand_weight[MAX_PINS] = { 0.05, 0.6, 0.4, 0.8, 0.3, 0.6, 1.0, 0.5, 0.4, 1.5 };
+
+/// @brief The pins touching pin 'pin', as a mask
+static unsigned pin_neighbours(int pin)
+{
+    unsigned mask = 0;
+    for (int other = 0; other < MAX_PINS; other++)
+    {
+        int rows = abs(pin_row[other] - pin_row[pin]);
+        int across = abs(pin_x[other] - pin_x[pin]);
+        if ((rows == 0 && across == 2) || (rows == 1 && across == 1))
+            mask |= 1u << other;
+    }
+    return mask;
+}
+
+/// @brief The two pins immediately behind pin 'pin', as a mask, 0 for the back row
+static unsigned pins_behind(int pin)
+{
+    unsigned mask = 0;
+    for (int other = 0; other < MAX_PINS; other++)
+        if (pin_row[other] == pin_row[pin] + 1 && abs(pin_x[other] - pin_x[pin]) == 1)
+            mask |= 1u << other;
+    return mask;
+}
+
+/**
+ * Tells if a leave is a split (see the file comment).
+ *
+ * @param leave pins standing, bit i for pin i + 1
+ * @return 1 if it is a split or 0 if not
+ */
+int pin_leave_is_split(unsigned leave)
+{
+    leave &= PIN_DECK_FULL_RACK;
+    if ((leave & 1u) || pin_count(leave) < 2)
+        return 0;
+
+    // a pin down immediately ahead of two standing pins
+    for (int pin = 0; pin < MAX_PINS; pin++)
+    {
+        unsigned behind = pins_behind(pin);
+        if (!(leave & (1u << pin)) && behind && (leave & behind) == behind)
+            return 1;
+    }
+
+    // otherwise a split if the standing pins don't all touch
+    unsigned reached = leave & -leave;
+    unsigned previous = 0;
+    while (reached != previous)
+    {
+        previous = reached;
+        for (int pin = 0; pin < MAX_PINS; pin++)
+            if (reached & (1u << pin))
+                reached |= pin_neighbours(pin) & leave;
+    }
+    return reached != leave;
+}
+
+/// @brief Name a leave by its pins, "7-10", or "none" for a strike
+void pin_leave_name(unsigned leave, char name[PIN_LEAVE_NAME_SIZE])
+{
+    char *p = name;
+
+    if (!(leave & PIN_DECK_FULL_RACK))
+    {
+        strcpy(name, "none");
+        return;
+    }
+    for (int pin = 0; pin < MAX_PINS; pin++)
+        if (leave & (1u << pin))
+            p += sprintf(p, p == name ? "%d" : "-%d", pin + 1);
+}
+
+/// @brief Build the alias table over the leaves from their probabilities, as build_roll_table() does
+static void build_leave_table(struct pin_deck *deck)
+{
+    static const int outcomes = PIN_DECK_LEAVES;
+    double scaled[PIN_DECK_LEAVES];
+    int small[PIN_DECK_LEAVES], large[PIN_DECK_LEAVES];
+    int small_count = 0, large_count = 0;
+
+    for (int i = 0; i < outcomes; i++)
+    {
+        scaled[i] = deck->leave[i] * outcomes;
+        if (scaled[i] < 1.0)
+            small[small_count++] = i;
+        else
+            large[large_count++] = i;
+    }
+
+    while (small_count > 0 && large_count > 0)
+    {
+        int s = small[--small_count];
+        int l = large[--large_count];
+
+        deck->leave_threshold[s] = (uint32_t)(scaled[s] * 4294967296.0);
+        deck->leave_alias[s] = (uint16_t)l;
+
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0)
+            small[small_count++] = l;
+        else
+            large[large_count++] = l;
+    }
+
+    // whatever is left is (to rounding) a full column that always keeps itself
+    while (large_count > 0)
+    {
+        int l = large[--large_count];
+        deck->leave_threshold[l] = UINT32_MAX;
+        deck->leave_alias[l] = (uint16_t)l;
+    }
+    while (small_count > 0)
+    {
+        int s = small[--small_count];
+        deck->leave_threshold[s] = UINT32_MAX;
+        deck->leave_alias[s] = (uint16_t)s;
+    }
+}
+
+/**
+ * Sets the leave and conversion tables, with the deck's miss rows.
+ *
+ * @param deck
+ * @param leave_weights non-negative weight of the first ball leaving each
+ *        rack standing, normalized
+ * @param conversion probability of clearing each leave with a spare
+ *        attempt, 0 to 1; the entry for leave 0 isn't used
+ * @return 1 if good or 0 if a weight is negative, they are all zero, or a
+ *         conversion probability is out of range
+ */
+int pin_deck_set(struct pin_deck *deck, const double leave_weights[PIN_DECK_LEAVES],
+                 const double conversion[PIN_DECK_LEAVES])
+{
+    double sum = 0.0;
+
+    for (int leave = 0; leave < PIN_DECK_LEAVES; leave++)
+    {
+        if (!(leave_weights[leave] >= 0.0) || (leave > 0 && !(conversion[leave] >= 0.0 && conversion[leave] <= 1.0)))
+            return 0;
+        sum += leave_weights[leave];
+    }
+    if (sum <= 0.0)
+        return 0;
+
+    // each leave's spare table is built in a scratch model's row for its pin count
+    struct roll_model scratch;
+    roll_model_default(&scratch);
+    for (int leave = 0; leave < PIN_DECK_LEAVES; leave++)
+    {
+        int pins = pin_count((unsigned)leave);
+        double weights[MAX_PINS + 1];
+
+        deck->leave[leave] = leave_weights[leave] / sum;
+        deck->conversion[leave] = leave > 0 ? conversion[leave] : 1.0;
+        deck->split[leave] = (uint8_t)pin_leave_is_split((unsigned)leave);
+        for (int i = 0; i < pins; i++)
+            weights[i] = (1.0 - deck->conversion[leave]) * deck->miss.pmf[pins][i];
+        weights[pins] = deck->conversion[leave];
+        roll_model_set(&scratch, pins, weights);
+        deck->spare[leave] = scratch.table[pins];
+    }
+    build_leave_table(deck);
+    return 1;
+}
+
+/**
+ * Builds the default deck on a count model (see the file comment).
+ *
+ * @param deck receives the deck
+ * @param counts the model the first ball counts, spare conversion rates
+ *        and missed spare counts come from
+ */
+void pin_deck_init(struct pin_deck *deck, const struct roll_model *counts)
+{
+    double weights[PIN_DECK_LEAVES];
+    double conversion[PIN_DECK_LEAVES];
+    double class_weight[MAX_PINS + 1] = { 0 };
+    double class_probability[MAX_PINS + 1] = { 0 };
+    double class_difficulty[MAX_PINS + 1] = { 0 };
+
+    memset(deck, 0, sizeof(*deck));
+    roll_model_default(&deck->miss);
+
+    // the shape of each leave, then scaled so each count keeps the model's probability
+    for (unsigned leave = 0; leave < PIN_DECK_LEAVES; leave++)
+    {
+        double weight = pin_leave_is_split(leave) ? SPLIT_LEAVE_WEIGHT : 1.0;
+        for (int pin = 0; pin < MAX_PINS; pin++)
+            if (leave & (1u << pin))
+                weight *= stand_weight[pin];
+        weights[leave] = weight;
+        class_weight[pin_count(leave)] += weight;
+    }
+    for (unsigned leave = 0; leave < PIN_DECK_LEAVES; leave++)
+    {
+        int standing = pin_count(leave);
+        weights[leave] *= counts->pmf[MAX_PINS][MAX_PINS - standing] / class_weight[standing];
+        class_probability[standing] += weights[leave];
+        class_difficulty[standing] += weights[leave] * (pin_leave_is_split(leave) ? SPLIT_CONVERSION : 1.0);
+    }
+
+    // splits are harder to convert, the rate over each count staying the model's
+    for (unsigned leave = 1; leave < PIN_DECK_LEAVES; leave++)
+    {
+        int standing = pin_count(leave);
+        double ease = pin_leave_is_split(leave) ? SPLIT_CONVERSION : 1.0;
+        double scale = class_difficulty[standing] > 0.0 ? class_probability[standing] / class_difficulty[standing] : 1.0;
+        conversion[leave] = counts->pmf[standing][standing] * scale * ease;
+        if (conversion[leave] > 1.0)
+            conversion[leave] = 1.0;
+    }
+
+    // a missed spare knocks down what the model gives, short of clearing the rack
+    for (int pins = 1; pins <= MAX_PINS; pins++)
+    {
+        double miss[MAX_PINS + 1];
+        double sum = 0.0;
+        for (int i = 0; i < pins; i++)
+            sum += miss[i] = counts->pmf[pins][i];
+        for (int i = 0; i < pins && sum <= 0.0; i++)
+            miss[i] = 1.0;
+        miss[pins] = 0.0;
+        roll_model_set(&deck->miss, pins, miss);
+    }
+
+    pin_deck_set(deck, weights, conversion);
+}
+
+/**
+ * Sets a count model's rows to the ones a deck implies and has
+ * throw_frame_r() play with the deck.
+ *
+ * @param deck must stay valid while games are played with the model
+ * @param model its 10 pin row becomes the first ball's count and each
+ *        other row the spare attempts at that many pins; rows the deck
+ *        never reaches are kept
+ */
+void pin_deck_roll_model(const struct pin_deck *deck, struct roll_model *model)
+{
+    double rows[MAX_PINS + 1][MAX_PINS + 1] = { { 0 } };
+    double reach[MAX_PINS + 1] = { 0 };
+
+    for (unsigned leave = 0; leave < PIN_DECK_LEAVES; leave++)
+    {
+        int standing = pin_count(leave);
+        double p = deck->leave[leave];
+
+        rows[MAX_PINS][MAX_PINS - standing] += p;
+        if (standing == 0 || standing == MAX_PINS)
+            continue;
+        reach[standing] += p;
+        rows[standing][standing] += p * deck->conversion[leave];
+        for (int i = 0; i < standing; i++)
+            rows[standing][i] += p * (1.0 - deck->conversion[leave]) * deck->miss.pmf[standing][i];
+    }
+
+    roll_model_set(model, MAX_PINS, rows[MAX_PINS]);
+    for (int pins = 1; pins < MAX_PINS; pins++)
+        if (reach[pins] > 0.0)
+            roll_model_set(model, pins, rows[pins]);
+    model->deck = deck;
+}
+
+/// @brief Ball at a full rack, counted in the stats; returns the leave
+static inline unsigned fresh_rack(const struct pin_deck *deck, struct bowling_rng *rng, struct pin_deck_stats *stats)
+{
+    unsigned leave = pin_deck_first_ball(deck, rng);
+    if (stats)
+    {
+        stats->racks++;
+        stats->leaves[leave]++;
+    }
+    return leave;
+}
+
+/// @brief Spare attempt at a leave, counted in the stats; returns the pins knocked down
+static inline int spare(const struct pin_deck *deck, unsigned leave, struct bowling_rng *rng,
+                        struct pin_deck_stats *stats)
+{
+    int pins = pin_deck_spare_ball(deck, leave, rng);
+    if (stats)
+    {
+        stats->attempts[leave]++;
+        stats->conversions[leave] += pins == pin_count(leave);
+    }
+    return pins;
+}
+
+/**
+ * Plays a frame with the pin deck, by the throw_frame_r() rules.
+ *
+ * @param frames the game; a frame already played is left alone
+ * @param frame_number 0 to MAX_FRAMES - 1
+ * @param deck
+ * @param rng
+ * @param stats if not NULL, every leave and spare attempt is counted in it
+ */
+void pin_deck_throw_frame(struct frame_results frames[MAX_FRAMES], int frame_number, const struct pin_deck *deck,
+                          struct bowling_rng *rng, struct pin_deck_stats *stats)
+{
+    struct frame_results *frame = &frames[frame_number];
+    if (frame->type != UNDEFINED)
+        return;
+
+    unsigned leave = fresh_rack(deck, rng, stats);
+    frame->first_ball = MAX_PINS - pin_count(leave);
+
+    if (frame_number == MAX_FRAMES - 1)
+    {
+        frame->type = LAST_FRAME;
+        if (leave == 0)
+        {
+            // a strike earns two more balls, the third at what the second left
+            unsigned second = fresh_rack(deck, rng, stats);
+            frame->second_ball = MAX_PINS - pin_count(second);
+            if (second == 0)
+                frame->third_ball = MAX_PINS - pin_count(fresh_rack(deck, rng, stats));
+            else
+                frame->third_ball = spare(deck, second, rng, stats);
+        }
+        else
+        {
+            frame->second_ball = spare(deck, leave, rng, stats);
+            if (frame->first_ball + frame->second_ball == MAX_PINS)
+                frame->third_ball = MAX_PINS - pin_count(fresh_rack(deck, rng, stats));
+            else
+                frame->third_ball = 0;
+        }
+    }
+    else if (leave == 0)
+    {
+        frame->second_ball = 0;
+        frame->type = STRIKE;
+    }
+    else
+    {
+        frame->second_ball = spare(deck, leave, rng, stats);
+        frame->type = frame->first_ball + frame->second_ball == MAX_PINS ? SPARE : OPEN;
+    }
+}
+
+/// @brief Play all 10 frames with the pin deck, counting the leaves in 'stats' if not NULL
+void pin_deck_play_game(struct frame_results frames[MAX_FRAMES], const struct pin_deck *deck,
+                        struct bowling_rng *rng, struct pin_deck_stats *stats)
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+        pin_deck_throw_frame(frames, i, deck, rng, stats);
+    if (stats)
+        stats->games++;
+}
+
+struct leave_count
+{
+    uint64_t count;
+    unsigned leave;
+};
+
+static int compare_leave_counts(const void *a, const void *b)
+{
+    const struct leave_count *x = a, *y = b;
+    if (x->count != y->count)
+        return x->count < y->count ? 1 : -1;
+    return x->leave < y->leave ? -1 : x->leave > y->leave;
+}
+
+static double percent(uint64_t part, uint64_t whole)
+{
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+/// @brief Print how often racks were struck, split and converted, and the most common leaves
+void report_pin_deck_stats(const struct pin_deck_stats *stats, FILE *out)
+{
+    static const int listed = PIN_DECK_TOP_LEAVES;
+    struct leave_count counts[PIN_DECK_LEAVES];
+    uint64_t splits = 0, split_attempts = 0, split_conversions = 0;
+    uint64_t attempts = 0, conversions = 0;
+    char name[PIN_LEAVE_NAME_SIZE];
+
+    for (unsigned leave = 1; leave < PIN_DECK_LEAVES; leave++)
+    {
+        int split = pin_leave_is_split(leave);
+        splits += split ? stats->leaves[leave] : 0;
+        split_attempts += split ? stats->attempts[leave] : 0;
+        split_conversions += split ? stats->conversions[leave] : 0;
+        attempts += split ? 0 : stats->attempts[leave];
+        conversions += split ? 0 : stats->conversions[leave];
+    }
+
+    fprintf(out, "Games:          %12llu\n", (unsigned long long)stats->games);
+    fprintf(out, "Racks:          %12llu\n", (unsigned long long)stats->racks);
+    fprintf(out, "Strikes:        %11.2f%%\n", percent(stats->leaves[0], stats->racks));
+    fprintf(out, "Splits:         %11.2f%%\n", percent(splits, stats->racks));
+    fprintf(out, "Spares made:    %11.2f%%\n", percent(conversions, attempts));
+    fprintf(out, "Splits made:    %11.2f%%\n", percent(split_conversions, split_attempts));
+
+    for (unsigned leave = 0; leave < PIN_DECK_LEAVES; leave++)
+    {
+        counts[leave].count = stats->leaves[leave];
+        counts[leave].leave = leave;
+    }
+    qsort(counts + 1, PIN_DECK_LEAVES - 1, sizeof(counts[0]), compare_leave_counts);
+
+    fprintf(out, "Leave                         Left%%   Made%%\n");
+    for (int i = 1; i <= listed && counts[i].count > 0; i++)
+    {
+        unsigned leave = counts[i].leave;
+        pin_leave_name(leave, name);
+        fprintf(out, "%-20s %-6s %7.2f %7.2f\n", name, pin_leave_is_split(leave) ? "split" : "",
+                percent(counts[i].count, stats->racks), percent(stats->conversions[leave], stats->attempts[leave]));
+    }
+}
@@ -0,0 +1,72 @@
+// pin_deck.h
+#ifndef PIN_DECK_H
+#define PIN_DECK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "bowling_rng.h"
+#include "roll_model.h"
+
+#define PIN_DECK_LEAVES 1024        // racks as 10-bit masks, bit i set if pin i + 1 stands
+#define PIN_DECK_FULL_RACK 0x3ffu
+#define PIN_DECK_TOP_LEAVES 12      // leaves listed by report_pin_deck_stats()
+#define PIN_LEAVE_NAME_SIZE 24      // "1-2-3-4-5-6-7-8-9-10" and the terminator
+
+struct pin_deck
+{
+    double leave[PIN_DECK_LEAVES];              // probability the first ball leaves each rack standing
+    double conversion[PIN_DECK_LEAVES];         // probability a spare attempt at each leave clears it
+    uint32_t leave_threshold[PIN_DECK_LEAVES];  // alias table over the leaves, as struct roll_table
+    uint16_t leave_alias[PIN_DECK_LEAVES];
+    struct roll_model miss;                     // pins knocked down by a missed spare, [pins standing]
+    struct roll_table spare[PIN_DECK_LEAVES];   // pins knocked down by a spare attempt at each leave
+    uint8_t split[PIN_DECK_LEAVES];             // 1 if the leave is a split
+};
+
+// what a pin deck game left, for the split statistics
+struct pin_deck_stats
+{
+    uint64_t games;
+    uint64_t racks;                             // balls at a full rack
+    uint64_t leaves[PIN_DECK_LEAVES];           // what they left standing
+    uint64_t attempts[PIN_DECK_LEAVES];         // spare attempts at each leave
+    uint64_t conversions[PIN_DECK_LEAVES];      // and how many of them cleared it
+};
+
+/// @brief Pins standing in a rack
+static inline int pin_count(unsigned rack)
+{
+    return __builtin_popcount(rack);
+}
+
+/// @brief Rack left by a ball at a full rack, O(1) from the leave alias table
+static inline unsigned pin_deck_first_ball(const struct pin_deck *deck, struct bowling_rng *rng)
+{
+    uint64_t r = bowling_rng_next(rng);
+    unsigned column = (unsigned)(r >> 54);
+    return (uint32_t)r < deck->leave_threshold[column] ? column : deck->leave_alias[column];
+}
+
+/// @brief Pins knocked down by a spare attempt at 'leave', O(1) from that leave's alias table
+static inline int pin_deck_spare_ball(const struct pin_deck *deck, unsigned leave, struct bowling_rng *rng)
+{
+    return roll_table_sample(&deck->spare[leave], pin_count(leave), rng);
+}
+
+int pin_leave_is_split(unsigned leave);
+void pin_leave_name(unsigned leave, char name[PIN_LEAVE_NAME_SIZE]);
+
+void pin_deck_init(struct pin_deck *deck, const struct roll_model *counts);
+int pin_deck_set(struct pin_deck *deck, const double leave_weights[PIN_DECK_LEAVES],
+                 const double conversion[PIN_DECK_LEAVES]);
+void pin_deck_roll_model(const struct pin_deck *deck, struct roll_model *model);
+
+void pin_deck_throw_frame(struct frame_results frames[MAX_FRAMES], int frame_number, const struct pin_deck *deck,
+                          struct bowling_rng *rng, struct pin_deck_stats *stats);
+void pin_deck_play_game(struct frame_results frames[MAX_FRAMES], const struct pin_deck *deck,
+                        struct bowling_rng *rng, struct pin_deck_stats *stats);
+void report_pin_deck_stats(const struct pin_deck_stats *stats, FILE *out);
+
+#endif // PIN_DECK_H
@@ -0,0 +1,231 @@
+/**
+ * @file roll_model.c
+ * @brief Per-pins-standing roll probability tables with O(1) sampling
+ *
+ * The roll model gives, for every number of pins standing (0-10), the
+ * probability of knocking down each number of them. ball() used to walk
+ * an if/else ladder of hard-coded thresholds and call rand() up to twice
+ * per roll; now it makes a single draw from an alias table.
+ *
+ * Alias method:
+ * For n+1 outcomes each column i is kept with probability threshold[i]/2^32
+ * and otherwise replaced by alias[i]. The top 32 bits of one 64-bit draw
+ * pick the column and the low 32 bits are compared with the threshold, so
+ * a roll costs one generator call, one multiply and one compare with no
+ * data-dependent branches.
+ *
+ * Default model (the distribution ball() has always used):
+ * - 10 pins standing: 20% all, 15% all but 1, 15% all but 2,
+ *   50% spread evenly over 0-10
+ * - fewer pins standing: 30% all, 20% all but 1, 30% all but 2,
+ *   20% spread evenly over 0-pins
+ *   (all but 1 or 2 can't go below 0 pins)
+ *
+ * Model file format, one line per number of pins standing; lines left out
+ * keep the default and '#' starts a comment:
+ * @code
+ * # pins standing: weight of knocking down 0, 1, ..., pins
+ * 10: 4.5 4.5 4.5 4.5 4.5 4.5 4.5 4.5 19.5 19.5 24.5
+ * 1: 30 70
+ * @endcode
+ * Weights don't have to add up to anything, they are normalized.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "roll_model.h"
+
+// Distribution thresholds used by the default model, in percent
+#define FULL_RACK_ALL      20   // strike
+#define FULL_RACK_ALL_BUT1 15   // 9 pins
+#define FULL_RACK_ALL_BUT2 15   // 8 pins
+#define SPARE_ALL          30   // spare
+#define SPARE_ALL_BUT1     20
+#define SPARE_ALL_BUT2     30
+
+/// @brief Build the alias table for one number of pins standing from its pmf
+static void build_roll_table(struct roll_table *table, const double pmf[], int outcomes)
+{
+    double scaled[MAX_PINS + 1];
+    int small[MAX_PINS + 1], large[MAX_PINS + 1];
+    int small_count = 0, large_count = 0;
+
+    for (int i = 0; i < outcomes; i++)
+    {
+        scaled[i] = pmf[i] * outcomes;
+        if (scaled[i] < 1.0)
+            small[small_count++] = i;
+        else
+            large[large_count++] = i;
+    }
+
+    while (small_count > 0 && large_count > 0)
+    {
+        int s = small[--small_count];
+        int l = large[--large_count];
+
+        table->threshold[s] = (uint32_t)(scaled[s] * 4294967296.0);
+        table->alias[s] = (uint8_t)l;
+
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0)
+            small[small_count++] = l;
+        else
+            large[large_count++] = l;
+    }
+
+    // whatever is left is (to rounding) a full column that always keeps itself
+    while (large_count > 0)
+    {
+        int l = large[--large_count];
+        table->threshold[l] = UINT32_MAX;
+        table->alias[l] = (uint8_t)l;
+    }
+    while (small_count > 0)
+    {
+        int s = small[--small_count];
+        table->threshold[s] = UINT32_MAX;
+        table->alias[s] = (uint8_t)s;
+    }
+}
+
+/**
+ * Sets the distribution for one number of pins standing.
+ *
+ * @param model
+ * @param pins number of pins standing, 0 to MAX_PINS
+ * @param weights pins+1 non-negative weights for knocking down 0..pins
+ * @return 1 if good or 0 if pins is out of range or the weights are negative or all zero
+ */
+int roll_model_set(struct roll_model *model, int pins, const double weights[])
+{
+    double sum = 0.0;
+
+    if (pins < 0 || pins > MAX_PINS)
+        return 0;
+    for (int i = 0; i <= pins; i++)
+    {
+        if (!(weights[i] >= 0.0))
+            return 0;
+        sum += weights[i];
+    }
+    if (sum <= 0.0)
+        return 0;
+
+    memset(model->pmf[pins], 0, sizeof(model->pmf[pins]));
+    for (int i = 0; i <= pins; i++)
+        model->pmf[pins][i] = weights[i] / sum;
+
+    build_roll_table(&model->table[pins], model->pmf[pins], pins + 1);
+    return 1;
+}
+
+/// @brief The distribution ball() has always used, see the file comment
+void roll_model_default(struct roll_model *model)
+{
+    memset(model, 0, sizeof(*model));
+
+    for (int pins = 0; pins <= MAX_PINS; pins++)
+    {
+        double weights[MAX_PINS + 1];
+        int all, all_but1, all_but2;
+
+        if (pins == MAX_PINS)
+        {
+            all = FULL_RACK_ALL;
+            all_but1 = FULL_RACK_ALL_BUT1;
+            all_but2 = FULL_RACK_ALL_BUT2;
+        }
+        else
+        {
+            all = SPARE_ALL;
+            all_but1 = SPARE_ALL_BUT1;
+            all_but2 = SPARE_ALL_BUT2;
+        }
+
+        // remaining percent spread evenly over every outcome
+        double spread = (100.0 - all - all_but1 - all_but2) / (pins + 1);
+        for (int i = 0; i <= pins; i++)
+            weights[i] = spread;
+        weights[pins] += all;
+        weights[pins >= 1 ? pins - 1 : 0] += all_but1;
+        weights[pins >= 2 ? pins - 2 : 0] += all_but2;
+
+        roll_model_set(model, pins, weights);
+    }
+}
+
+/**
+ * Loads a model file (see the file comment for the format) on top of the
+ * default model.
+ *
+ * @param model receives the model
+ * @param path file to read
+ * @return 1 if good or 0 if the file can't be read or a line is malformed
+ */
+int roll_model_load(struct roll_model *model, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[1024];
+    int good = 1;
+
+    if (!file)
+        return 0;
+
+    roll_model_default(model);
+    while (good && fgets(line, sizeof(line), file))
+    {
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char *p = line;
+        char *end;
+        long pins = strtol(p, &end, 10);
+        if (end == p)
+        {
+            // blank line
+            while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+                p++;
+            good = *p == '\0';
+            continue;
+        }
+
+        p = end;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p != ':' || pins < 0 || pins > MAX_PINS)
+        {
+            good = 0;
+            break;
+        }
+        p++;
+
+        double weights[MAX_PINS + 1];
+        for (int i = 0; i <= pins && good; i++)
+        {
+            weights[i] = strtod(p, &end);
+            good = end != p;
+            p = end;
+        }
+        while (good && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+        good = good && *p == '\0' && roll_model_set(model, (int)pins, weights);
+    }
+
+    fclose(file);
+    return good;
+}
+
+/// @brief Write the model in the format roll_model_load() reads
+void roll_model_save(const struct roll_model *model, FILE *file)
+{
+    fprintf(file, "# pins standing: probability of knocking down 0, 1, ..., pins\n");
+    for (int pins = MAX_PINS; pins >= 0; pins--)
+    {
+        fprintf(file, "%d:", pins);
+        for (int i = 0; i <= pins; i++)
+            fprintf(file, " %.6f", model->pmf[pins][i]);
+        fprintf(file, "\n");
+    }
+}
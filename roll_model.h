@@ -0,0 +1,46 @@
+// roll_model.h
+#ifndef ROLL_MODEL_H
+#define ROLL_MODEL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "bowling_rng.h"
+
+struct pin_deck;
+
+// Alias table for one number of pins standing, outcomes 0..pins
+struct roll_table
+{
+    uint32_t threshold[MAX_PINS + 1];   // keep the column if the draw is below this
+    uint8_t alias[MAX_PINS + 1];        // otherwise take this outcome
+};
+
+struct roll_model
+{
+    double pmf[MAX_PINS + 1][MAX_PINS + 1];     // [pins standing][pins knocked down]
+    struct roll_table table[MAX_PINS + 1];      // [pins standing]
+    const struct pin_deck *deck;                // if set, throw_frame_r() plays racks pin by pin, see pin_deck.c
+};
+
+void roll_model_default(struct roll_model *model);
+int roll_model_set(struct roll_model *model, int pins, const double weights[]);
+int roll_model_load(struct roll_model *model, const char *path);
+void roll_model_save(const struct roll_model *model, FILE *file);
+
+/// @brief One draw from an alias table over outcomes 0..pins, O(1) and branch-free
+static inline int roll_table_sample(const struct roll_table *table, int pins, struct bowling_rng *rng)
+{
+    uint64_t r = bowling_rng_next(rng);
+    uint32_t column = (uint32_t)(((r >> 32) * (uint64_t)(pins + 1)) >> 32);
+    return (uint32_t)r < table->threshold[column] ? (int)column : table->alias[column];
+}
+
+/// @brief Number of pins knocked down when 'pins' are standing, O(1) and branch-free
+static inline int roll_model_sample(const struct roll_model *model, int pins, struct bowling_rng *rng)
+{
+    return roll_table_sample(&model->table[pins], pins, rng);
+}
+
+#endif // ROLL_MODEL_H
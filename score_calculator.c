@@ -66,6 +66,7 @@
  * Frame validation should be performed before score calculation.
  */
 #include "score_calculator.h"
+#include "frame_validator.h"
 
 enum bowling_error 
 calculate_game_scores(struct frame_results frames[MAX_FRAMES])
@@ -74,16 +75,18 @@ calculate_game_scores(struct frame_results frames[MAX_FRAMES])
     for (int i = 0; i < MAX_FRAMES; i++)
     {
         // if frame 1-9, score normally
-        if (i < 9)
+        if (i < MAX_FRAMES - 1)
         {
             // if we threw a strike, 10 plus next two balls
             if (frames[i].type == STRIKE)
             {
                 frames[i].score = STRIKE_SCORE; 
-                if (i == 8) // if in frame 9  
+                if (i == MAX_FRAMES - 2) // if in frame 9  
                     frames[i].score += frames[i+1].first_ball + frames[i+1].second_ball;
-                else
+                else if (frames[i+1].type == STRIKE) // next ball after a strike is in the frame after
                     frames[i].score += frames[i+1].first_ball + frames[i+2].first_ball;
+                else
+                    frames[i].score += frames[i+1].first_ball + frames[i+1].second_ball;
             }
             else if (frames[i].type == SPARE)
             {
@@ -101,3 +104,222 @@ calculate_game_scores(struct frame_results frames[MAX_FRAMES])
     }
     return NO_ERROR;
 }
+
+/**
+ * Validates and scores a game in one pass over the frames.
+ * 
+ * @param frames The game; each frame's score is filled in
+ * @param cumulative Receives the running total after each frame, may be NULL
+ * 
+ * @return The same result validate_game() gives. The pass stops at the
+ *         first frame that fails, so the scores are only complete for
+ *         NO_ERROR.
+ * 
+ * Each frame is checked with validate_frame() and scored straight away,
+ * instead of walking the frames once in validate_game() and again in
+ * calculate_game_scores(). A frame's bonus balls come from the next two
+ * frames, which are checked before the game is accepted.
+ */
+enum bowling_error
+validate_and_score_game(struct frame_results frames[MAX_FRAMES], int cumulative[MAX_FRAMES])
+{
+    int total = 0;
+
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const struct frame_results *frame = &frames[i];
+        enum bowling_error error = validate_frame(i, frame->type, frame->first_ball,
+                                                  frame->second_ball, frame->third_ball);
+        if (error != NO_ERROR)
+            return error;
+
+        int score;
+        if (i == MAX_FRAMES - 1)
+            score = frame->first_ball + frame->second_ball + frame->third_ball;
+        else if (frame->type == STRIKE)
+        {
+            if (i < MAX_FRAMES - 2 && frames[i+1].type == STRIKE)
+                score = STRIKE_SCORE + frames[i+1].first_ball + frames[i+2].first_ball;
+            else
+                score = STRIKE_SCORE + frames[i+1].first_ball + frames[i+1].second_ball;
+        }
+        else if (frame->type == SPARE)
+            score = STRIKE_SCORE + frames[i+1].first_ball;
+        else
+            score = frame->first_ball + frame->second_ball;   // validate_frame() only lets OPEN through
+
+        frames[i].score = score;
+        total += score;
+        if (cumulative)
+            cumulative[i] = total;
+    }
+
+    return NO_ERROR;
+}
+
+/**
+ * Validates and scores every game in a batch in one pass.
+ * 
+ * @param batch The games; batch->score and batch->total are filled in
+ * @param errors Receives the bowling_error of each game, may be NULL
+ * 
+ * @return The number of games that are not valid
+ * 
+ * Gives the same errors as validate_game_batch() and, for valid games,
+ * the same scores as calculate_game_scores_batch(); the scores of invalid
+ * games are meaningless. Each frame column is read once for both, and the
+ * loop has no branches on the data unless a frame is invalid.
+ */
+size_t
+validate_and_score_game_batch(struct game_batch *batch, uint8_t errors[])
+{
+    static const uint8_t zero_balls[1024];
+    uint8_t local_errors[1024];
+    uint8_t valid[1024];
+    size_t invalid = 0;
+
+    for (size_t start = 0; start < batch->count; start += 1024)
+    {
+        size_t end = start + 1024 < batch->count ? start + 1024 : batch->count;
+        uint8_t *chunk = errors ? errors + start : local_errors;
+
+        for (size_t g = start; g < end; g++)
+        {
+            chunk[g - start] = NO_ERROR;
+            batch->total[g] = 0;
+        }
+
+        for (int i = 0; i < MAX_FRAMES; i++)
+        {
+            const uint8_t *type = batch->type + BATCH_INDEX(batch, i, 0);
+            const uint8_t *first_ball = batch->first_ball + BATCH_INDEX(batch, i, 0);
+            const uint8_t *second_ball = batch->second_ball + BATCH_INDEX(batch, i, 0);
+            uint16_t *score = batch->score + BATCH_INDEX(batch, i, 0);
+            // the next frames only matter for frames 1-9 and 1-8
+            const uint8_t *next_type = i < MAX_FRAMES - 1 ? type + batch->capacity : type;
+            const uint8_t *next_first = i < MAX_FRAMES - 1 ? first_ball + batch->capacity : first_ball;
+            const uint8_t *next_second = i < MAX_FRAMES - 1 ? second_ball + batch->capacity : second_ball;
+            const uint8_t *after_first = i < MAX_FRAMES - 2 ? next_first + batch->capacity : next_first;
+            // only the 10th frame has a third ball, indexed from the start of the chunk
+            const uint8_t *third_ball = i == MAX_FRAMES - 1 ? batch->third_ball + start : zero_balls;
+
+            // score and check every game without branches, so the loop vectorizes
+            for (size_t g = start; g < end; g++)
+            {
+                // a valid frame's own balls make 10 for a strike or spare, so
+                // only the bonus balls depend on the type
+                int strike = type[g] == STRIKE;
+                int mark = strike | (type[g] == SPARE);
+                int next_strike = (i < MAX_FRAMES - 2) & (next_type[g] == STRIKE);
+                int second_bonus = next_strike ? after_first[g] : next_second[g];
+                int frame_score = first_ball[g] + second_ball[g] + third_ball[g - start];
+                if (i < MAX_FRAMES - 1)
+                    frame_score += mark * next_first[g] + strike * second_bonus;
+
+                score[g] = (uint16_t)frame_score;
+                batch->total[g] += (uint16_t)frame_score;
+                valid[g - start] = (uint8_t)packed_frame_valid(i, type[g], first_ball[g], second_ball[g],
+                                                               third_ball[g - start]);
+            }
+
+            // almost every frame is valid; only work out which rule failed when one isn't
+            for (size_t g = start; g < end; g++)
+                if (!valid[g - start] && chunk[g - start] == NO_ERROR)
+                    chunk[g - start] = (uint8_t)validate_frame(i, (enum frame_type)type[g], first_ball[g],
+                                                               second_ball[g], third_ball[g - start]);
+        }
+
+        for (size_t g = start; g < end; g++)
+            invalid += chunk[g - start] != NO_ERROR;
+    }
+
+    return invalid;
+}
+
+/**
+ * Calculates the scores of games first_game to last_game-1 of a batch with
+ * plain C, using the same rules as calculate_game_scores().
+ * 
+ * @param batch The games to score; batch->score and batch->total are filled in
+ * @param first_game, last_game The range of games to score
+ * @return INVALID_FRAME_TYPE if any game has a frame 1-9 that isn't a STRIKE,
+ *         SPARE or OPEN (that frame scores 0), otherwise NO_ERROR
+ * 
+ * Each frame is scored across all games before moving to the next frame,
+ * so every column is read front to back. This is the reference that the
+ * vectorized kernels in score_calculator_simd.c must match exactly, and
+ * they call it for the games left over after their last full vector.
+ */
+enum bowling_error
+calculate_game_scores_batch_scalar(struct game_batch *batch, size_t first_game, size_t last_game)
+{
+    enum bowling_error result = NO_ERROR;
+
+    for (size_t g = first_game; g < last_game; g++)
+        batch->total[g] = 0;
+
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const uint8_t *type = batch->type + BATCH_INDEX(batch, i, 0);
+        const uint8_t *first_ball = batch->first_ball + BATCH_INDEX(batch, i, 0);
+        const uint8_t *second_ball = batch->second_ball + BATCH_INDEX(batch, i, 0);
+        uint16_t *score = batch->score + BATCH_INDEX(batch, i, 0);
+
+        if (i == MAX_FRAMES - 1)
+        {
+            // 10th frame
+            for (size_t g = first_game; g < last_game; g++)
+                score[g] = first_ball[g] + second_ball[g] + batch->third_ball[g];
+        }
+        else
+        {
+            const uint8_t *next_type = type + batch->capacity;
+            const uint8_t *next_first = first_ball + batch->capacity;
+            const uint8_t *next_second = second_ball + batch->capacity;
+            // the frame after next only matters for frames 1-8
+            const uint8_t *after_first = i < MAX_FRAMES - 2 ? next_first + batch->capacity : next_first;
+
+            for (size_t g = first_game; g < last_game; g++)
+            {
+                if (type[g] == STRIKE)
+                {
+                    if (i < MAX_FRAMES - 2 && next_type[g] == STRIKE)
+                        score[g] = STRIKE_SCORE + next_first[g] + after_first[g];
+                    else
+                        score[g] = STRIKE_SCORE + next_first[g] + next_second[g];
+                }
+                else if (type[g] == SPARE)
+                    score[g] = STRIKE_SCORE + next_first[g];
+                else if (type[g] == OPEN)
+                    score[g] = first_ball[g] + second_ball[g];
+                else
+                {
+                    score[g] = 0;
+                    result = INVALID_FRAME_TYPE;
+                }
+            }
+        }
+
+        for (size_t g = first_game; g < last_game; g++)
+            batch->total[g] += score[g];
+    }
+
+    return result;
+}
+
+/**
+ * Calculates the scores of every game in a batch using the same rules as
+ * calculate_game_scores().
+ * 
+ * @param batch The games to score; batch->score and batch->total are filled in
+ * @return INVALID_FRAME_TYPE if any game has a frame 1-9 that isn't a STRIKE,
+ *         SPARE or OPEN (that frame scores 0), otherwise NO_ERROR
+ * 
+ * Uses the widest vectorized kernel the CPU supports; every kernel gives
+ * exactly the same scores.
+ */
+enum bowling_error
+calculate_game_scores_batch(struct game_batch *batch)
+{
+    return calculate_game_scores_batch_kernel(batch, best_score_kernel());
+}
@@ -2,9 +2,44 @@
 #ifndef SCORE_CALCULATOR_H
 #define SCORE_CALCULATOR_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "bowling_game.h"
+#include "game_batch.h"
 
 enum bowling_error
 calculate_game_scores(struct frame_results frames[MAX_FRAMES]);
+enum bowling_error
+calculate_game_scores_batch(struct game_batch *batch);
+enum bowling_error
+calculate_game_scores_batch_scalar(struct game_batch *batch, size_t first_game, size_t last_game);
+
+// validation and scoring in a single pass
+enum bowling_error
+validate_and_score_game(struct frame_results frames[MAX_FRAMES], int cumulative[MAX_FRAMES]);
+size_t
+validate_and_score_game_batch(struct game_batch *batch, uint8_t errors[]);
+
+// lookup-table scoring of frame codes, score_calculator_codes.c
+enum bowling_error
+score_game_codes(const uint8_t codes[MAX_FRAMES], int frame_scores[MAX_FRAMES], int *total);
+size_t
+score_game_codes_batch(const uint8_t *records, size_t stride, size_t count, uint16_t totals[], uint8_t errors[]);
+
+// vectorized batch scoring, score_calculator_simd.c
+enum score_kernel
+{
+    SCORE_KERNEL_SCALAR,    // plain C
+    SCORE_KERNEL_SSE42,     // 8 games per vector
+    SCORE_KERNEL_AVX2,      // 16 games per vector
+    SCORE_KERNEL_COUNT
+};
+
+enum score_kernel best_score_kernel(void);
+int score_kernel_available(enum score_kernel kernel);
+const char *score_kernel_name(enum score_kernel kernel);
+enum bowling_error
+calculate_game_scores_batch_kernel(struct game_batch *batch, enum score_kernel kernel);
 
 #endif // SCORE_CALCULATOR_H
@@ -0,0 +1,152 @@
+/**
+ * @file score_calculator_codes.c
+ * @brief Lookup-table scoring of games stored as frame codes
+ *
+ * A game stored as its frame codes (frame_codes.c) is already known to be
+ * legal as long as every code is in range, so validation is one compare
+ * per frame, and every frame's score is a table lookup on its own code
+ * and the codes after it instead of a branch on its type:
+ * - frames 1-8: pair_score[code][next code], plus the first ball of the
+ *   frame after next when both are strikes (the only case that needs it)
+ * - frame 9: ninth_score[code][10th frame code]; a strike in the 9th
+ *   takes its bonus from the 10th frame's first two balls
+ * - frame 10: tenth_score[code], the pins of its balls
+ *
+ * The tables hold 66*66 + 66*241 + 241 bytes (about 20 KB) and are built
+ * from the code tables the first time they are needed; after that they
+ * are only read, so any number of threads can score at once.
+ *
+ * Scores match calculate_game_scores() on the decoded game exactly.
+ */
+#include <pthread.h>
+
+#include "score_calculator.h"
+#include "frame_codes.h"
+
+static uint8_t pair_score[REGULAR_FRAME_CODES][REGULAR_FRAME_CODES];
+static uint8_t ninth_score[REGULAR_FRAME_CODES][LAST_FRAME_CODES];
+static uint8_t tenth_score[LAST_FRAME_CODES];
+static uint8_t regular_first_ball[REGULAR_FRAME_CODES];
+static uint8_t last_first_ball[LAST_FRAME_CODES];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+// the strike code, see frame_codes.c
+#define STRIKE_CODE 0
+
+/// @brief Score of a frame given the first two balls of the frame after it
+static int frame_score(const struct frame_code *frame, int next_first, int next_second)
+{
+    switch (frame->type)
+    {
+    case STRIKE:
+        return STRIKE_SCORE + next_first + next_second;
+    case SPARE:
+        return MAX_PINS + next_first;
+    default:
+        return frame->first_ball + frame->second_ball;
+    }
+}
+
+static void build_tables(void)
+{
+    for (int c = 0; c < REGULAR_FRAME_CODES; c++)
+    {
+        const struct frame_code *frame = &regular_frame_codes[c];
+        regular_first_ball[c] = frame->first_ball;
+
+        // after a strike in frames 1-8 the second bonus ball is in the frame after next; added at scoring time
+        for (int n = 0; n < REGULAR_FRAME_CODES; n++)
+            pair_score[c][n] = (uint8_t)frame_score(frame, regular_frame_codes[n].first_ball,
+                                                    regular_frame_codes[n].second_ball);
+
+        // the 10th frame holds both bonus balls of a strike in the 9th
+        for (int l = 0; l < LAST_FRAME_CODES; l++)
+            ninth_score[c][l] = (uint8_t)frame_score(frame, last_frame_codes[l].first_ball,
+                                                     last_frame_codes[l].second_ball);
+    }
+
+    for (int l = 0; l < LAST_FRAME_CODES; l++)
+    {
+        const struct frame_code *last = &last_frame_codes[l];
+        tenth_score[l] = (uint8_t)(last->first_ball + last->second_ball + last->third_ball);
+        last_first_ball[l] = last->first_ball;
+    }
+}
+
+static inline int codes_in_range(const uint8_t codes[MAX_FRAMES])
+{
+    int good = codes[MAX_FRAMES - 1] < LAST_FRAME_CODES;
+    for (int i = 0; i < MAX_FRAMES - 1; i++)
+        good &= codes[i] < REGULAR_FRAME_CODES;
+    return good;
+}
+
+/// @brief Score the frames of a game whose codes are in range
+static inline int score_codes(const uint8_t codes[MAX_FRAMES], int frame_scores[MAX_FRAMES])
+{
+    int total = 0;
+
+    for (int i = 0; i < MAX_FRAMES - 2; i++)
+    {
+        int after_next = i < MAX_FRAMES - 3 ? regular_first_ball[codes[i + 2]] : last_first_ball[codes[MAX_FRAMES - 1]];
+        int score = pair_score[codes[i]][codes[i + 1]] +
+                    ((codes[i] == STRIKE_CODE) & (codes[i + 1] == STRIKE_CODE)) * after_next;
+        if (frame_scores)
+            frame_scores[i] = score;
+        total += score;
+    }
+
+    int ninth = ninth_score[codes[MAX_FRAMES - 2]][codes[MAX_FRAMES - 1]];
+    int tenth = tenth_score[codes[MAX_FRAMES - 1]];
+    if (frame_scores)
+    {
+        frame_scores[MAX_FRAMES - 2] = ninth;
+        frame_scores[MAX_FRAMES - 1] = tenth;
+    }
+    return total + ninth + tenth;
+}
+
+/**
+ * Validates and scores a game given as frame codes.
+ *
+ * @param codes the game's frame codes, as encode_game() gives them
+ * @param frame_scores receives each frame's score, bonuses included; may be NULL
+ * @param total receives the final score
+ * @return NO_ERROR, or INVALID_PINS if a code is out of range (as decode_game())
+ */
+enum bowling_error score_game_codes(const uint8_t codes[MAX_FRAMES], int frame_scores[MAX_FRAMES], int *total)
+{
+    pthread_once(&tables_once, build_tables);
+    if (!codes_in_range(codes))
+        return INVALID_PINS;
+    *total = score_codes(codes, frame_scores);
+    return NO_ERROR;
+}
+
+/**
+ * Validates and scores many games stored as frame codes, such as the
+ * records of a game file.
+ *
+ * @param records the first game's codes
+ * @param stride bytes from one game's codes to the next, at least MAX_FRAMES
+ * @param count number of games
+ * @param totals receives each game's final score, 0 for an invalid game
+ * @param errors receives each game's result, as score_game_codes()
+ * @return the number of invalid games
+ */
+size_t score_game_codes_batch(const uint8_t *records, size_t stride, size_t count, uint16_t totals[],
+                              uint8_t errors[])
+{
+    size_t invalid = 0;
+
+    pthread_once(&tables_once, build_tables);
+    for (size_t g = 0; g < count; g++)
+    {
+        const uint8_t *codes = records + g * stride;
+        int good = codes_in_range(codes);
+        totals[g] = good ? (uint16_t)score_codes(codes, NULL) : 0;
+        errors[g] = good ? NO_ERROR : INVALID_PINS;
+        invalid += !good;
+    }
+    return invalid;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file score_calculator_simd.c
+ * @brief Vectorized batch scoring with runtime CPU dispatch
+ *
+ * calculate_game_scores_batch_scalar() branches on every frame's type,
+ * which random game data mispredicts constantly. The kernels here score
+ * one frame of many games at once with no branches on the data:
+ * - strike, spare and open frames are turned into lane masks by comparing
+ *   the frame type column
+ * - all three candidate scores are computed for every game
+ * - the masks select the right candidate for each game
+ * - a strike followed by a strike takes its second bonus ball from the
+ *   frame after next, chosen with a blend on the next frame's strike mask
+ *
+ * Lanes are 16 bits wide so that every sum is computed exactly as the
+ * scalar code does it, even for balls that failed validation; scores are
+ * bit-identical to the scalar path for any batch contents.
+ *
+ * Kernels:
+ * - SCORE_KERNEL_SSE42: 8 games per 128-bit vector
+ * - SCORE_KERNEL_AVX2:  16 games per 256-bit vector
+ * - SCORE_KERNEL_SCALAR: calculate_game_scores_batch_scalar()
+ *
+ * The kernels are compiled with function target attributes, so the
+ * program runs on any x86-64 CPU and picks the best kernel at run time
+ * with __builtin_cpu_supports(). On other architectures only the scalar
+ * kernel is available. Games left over after the last full vector are
+ * scored by the scalar kernel.
+ */
+#include "score_calculator.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+#if HAVE_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+static __m128i load8_sse(const uint8_t *column)
+{
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)column));
+}
+
+__attribute__((target("sse4.2")))
+static enum bowling_error score_batch_sse42(struct game_batch *batch)
+{
+    size_t count = batch->count & ~(size_t)7;
+    const __m128i strike_type = _mm_set1_epi16(STRIKE);
+    const __m128i spare_type = _mm_set1_epi16(SPARE);
+    const __m128i open_type = _mm_set1_epi16(OPEN);
+    const __m128i strike_score = _mm_set1_epi16(STRIKE_SCORE);
+    __m128i invalid = _mm_setzero_si128();
+
+    for (size_t g = 0; g < count; g += 8)
+        _mm_storeu_si128((__m128i *)(batch->total + g), _mm_setzero_si128());
+
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const uint8_t *type = batch->type + BATCH_INDEX(batch, i, 0);
+        const uint8_t *first_ball = batch->first_ball + BATCH_INDEX(batch, i, 0);
+        const uint8_t *second_ball = batch->second_ball + BATCH_INDEX(batch, i, 0);
+        uint16_t *score = batch->score + BATCH_INDEX(batch, i, 0);
+
+        for (size_t g = 0; g < count; g += 8)
+        {
+            __m128i frame_score;
+            if (i == MAX_FRAMES - 1)
+            {
+                // 10th frame
+                frame_score = _mm_add_epi16(_mm_add_epi16(load8_sse(first_ball + g), load8_sse(second_ball + g)),
+                                            load8_sse(batch->third_ball + g));
+            }
+            else
+            {
+                __m128i frame_type = load8_sse(type + g);
+                __m128i is_strike = _mm_cmpeq_epi16(frame_type, strike_type);
+                __m128i is_spare = _mm_cmpeq_epi16(frame_type, spare_type);
+                __m128i is_open = _mm_cmpeq_epi16(frame_type, open_type);
+
+                __m128i next_first = load8_sse(first_ball + batch->capacity + g);
+                __m128i next_second = load8_sse(second_ball + batch->capacity + g);
+                __m128i bonus = next_second;
+                if (i < MAX_FRAMES - 2)
+                {
+                    // a strike after a strike takes its next ball from the frame after
+                    __m128i next_strike = _mm_cmpeq_epi16(load8_sse(type + batch->capacity + g), strike_type);
+                    __m128i after_first = load8_sse(first_ball + 2 * batch->capacity + g);
+                    bonus = _mm_blendv_epi8(next_second, after_first, next_strike);
+                }
+
+                __m128i spare = _mm_add_epi16(strike_score, next_first);
+                __m128i strike = _mm_add_epi16(spare, bonus);
+                __m128i open = _mm_add_epi16(load8_sse(first_ball + g), load8_sse(second_ball + g));
+
+                frame_score = _mm_or_si128(_mm_or_si128(_mm_and_si128(is_strike, strike),
+                                                        _mm_and_si128(is_spare, spare)),
+                                           _mm_and_si128(is_open, open));
+                invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(_mm_or_si128(is_strike, is_spare), is_open),
+                                                                 _mm_set1_epi16(-1)));
+            }
+
+            _mm_storeu_si128((__m128i *)(score + g), frame_score);
+            __m128i total = _mm_loadu_si128((const __m128i *)(batch->total + g));
+            _mm_storeu_si128((__m128i *)(batch->total + g), _mm_add_epi16(total, frame_score));
+        }
+    }
+
+    enum bowling_error result = calculate_game_scores_batch_scalar(batch, count, batch->count);
+    if (!_mm_testz_si128(invalid, invalid))
+        result = INVALID_FRAME_TYPE;
+    return result;
+}
+
+__attribute__((target("avx2")))
+static __m256i load16_avx2(const uint8_t *column)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)column));
+}
+
+__attribute__((target("avx2")))
+static enum bowling_error score_batch_avx2(struct game_batch *batch)
+{
+    size_t count = batch->count & ~(size_t)15;
+    const __m256i strike_type = _mm256_set1_epi16(STRIKE);
+    const __m256i spare_type = _mm256_set1_epi16(SPARE);
+    const __m256i open_type = _mm256_set1_epi16(OPEN);
+    const __m256i strike_score = _mm256_set1_epi16(STRIKE_SCORE);
+    __m256i invalid = _mm256_setzero_si256();
+
+    for (size_t g = 0; g < count; g += 16)
+        _mm256_storeu_si256((__m256i *)(batch->total + g), _mm256_setzero_si256());
+
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const uint8_t *type = batch->type + BATCH_INDEX(batch, i, 0);
+        const uint8_t *first_ball = batch->first_ball + BATCH_INDEX(batch, i, 0);
+        const uint8_t *second_ball = batch->second_ball + BATCH_INDEX(batch, i, 0);
+        uint16_t *score = batch->score + BATCH_INDEX(batch, i, 0);
+
+        for (size_t g = 0; g < count; g += 16)
+        {
+            __m256i frame_score;
+            if (i == MAX_FRAMES - 1)
+            {
+                // 10th frame
+                frame_score = _mm256_add_epi16(_mm256_add_epi16(load16_avx2(first_ball + g), load16_avx2(second_ball + g)),
+                                               load16_avx2(batch->third_ball + g));
+            }
+            else
+            {
+                __m256i frame_type = load16_avx2(type + g);
+                __m256i is_strike = _mm256_cmpeq_epi16(frame_type, strike_type);
+                __m256i is_spare = _mm256_cmpeq_epi16(frame_type, spare_type);
+                __m256i is_open = _mm256_cmpeq_epi16(frame_type, open_type);
+
+                __m256i next_first = load16_avx2(first_ball + batch->capacity + g);
+                __m256i next_second = load16_avx2(second_ball + batch->capacity + g);
+                __m256i bonus = next_second;
+                if (i < MAX_FRAMES - 2)
+                {
+                    // a strike after a strike takes its next ball from the frame after
+                    __m256i next_strike = _mm256_cmpeq_epi16(load16_avx2(type + batch->capacity + g), strike_type);
+                    __m256i after_first = load16_avx2(first_ball + 2 * batch->capacity + g);
+                    bonus = _mm256_blendv_epi8(next_second, after_first, next_strike);
+                }
+
+                __m256i spare = _mm256_add_epi16(strike_score, next_first);
+                __m256i strike = _mm256_add_epi16(spare, bonus);
+                __m256i open = _mm256_add_epi16(load16_avx2(first_ball + g), load16_avx2(second_ball + g));
+
+                frame_score = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(is_strike, strike),
+                                                              _mm256_and_si256(is_spare, spare)),
+                                              _mm256_and_si256(is_open, open));
+                invalid = _mm256_or_si256(invalid, _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(is_strike, is_spare), is_open),
+                                                                       _mm256_set1_epi16(-1)));
+            }
+
+            _mm256_storeu_si256((__m256i *)(score + g), frame_score);
+            __m256i total = _mm256_loadu_si256((const __m256i *)(batch->total + g));
+            _mm256_storeu_si256((__m256i *)(batch->total + g), _mm256_add_epi16(total, frame_score));
+        }
+    }
+
+    enum bowling_error result = calculate_game_scores_batch_scalar(batch, count, batch->count);
+    if (!_mm256_testz_si256(invalid, invalid))
+        result = INVALID_FRAME_TYPE;
+    return result;
+}
+
+#endif // HAVE_X86_KERNELS
+
+/// @brief Can this CPU run the kernel?
+/// @return 1 if yes or 0 if no
+int score_kernel_available(enum score_kernel kernel)
+{
+    switch (kernel)
+    {
+    case SCORE_KERNEL_SCALAR:
+        return 1;
+#if HAVE_X86_KERNELS
+    case SCORE_KERNEL_SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case SCORE_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+/// @brief The widest kernel this CPU can run
+enum score_kernel best_score_kernel(void)
+{
+    for (int kernel = SCORE_KERNEL_COUNT - 1; kernel > SCORE_KERNEL_SCALAR; kernel--)
+        if (score_kernel_available((enum score_kernel)kernel))
+            return (enum score_kernel)kernel;
+    return SCORE_KERNEL_SCALAR;
+}
+
+const char *score_kernel_name(enum score_kernel kernel)
+{
+    switch (kernel)
+    {
+    case SCORE_KERNEL_SCALAR: return "scalar";
+    case SCORE_KERNEL_SSE42:  return "sse4.2";
+    case SCORE_KERNEL_AVX2:   return "avx2";
+    default:                  return "unknown";
+    }
+}
+
+/**
+ * Scores every game in a batch with a specific kernel.
+ *
+ * @param batch The games to score; batch->score and batch->total are filled in
+ * @param kernel The kernel to use; falls back to scalar if the CPU can't run it
+ * @return Same as calculate_game_scores_batch()
+ */
+enum bowling_error
+calculate_game_scores_batch_kernel(struct game_batch *batch, enum score_kernel kernel)
+{
+    if (!score_kernel_available(kernel))
+        kernel = SCORE_KERNEL_SCALAR;
+
+    switch (kernel)
+    {
+#if HAVE_X86_KERNELS
+    case SCORE_KERNEL_SSE42:
+        return score_batch_sse42(batch);
+    case SCORE_KERNEL_AVX2:
+        return score_batch_avx2(batch);
+#endif
+    default:
+        return calculate_game_scores_batch_scalar(batch, 0, batch->count);
+    }
+}
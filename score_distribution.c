@@ -0,0 +1,216 @@
+/**
+ * @file score_distribution.c
+ * @brief Exact probability of every final score by dynamic programming
+ *
+ * Each ball adds its pins to the score once for itself, and once more for
+ * every earlier strike or spare still waiting for it as a bonus ball. So
+ * the score is built up ball by ball, and the only thing a frame needs to
+ * know about the frames before it is which bonuses they still owe: the
+ * enum bonus_state, with the extra count of the next ball and the one
+ * after it:
+ * @code
+ * state          next ball  ball after
+ * BONUS_NONE         0          0
+ * BONUS_SPARE        1          0
+ * BONUS_STRIKE       1          1
+ * BONUS_DOUBLE       2          1
+ * @endcode
+ *
+ * score_distribution() carries the probability of every (state, score so
+ * far) pair through the frames. For each frame it goes through every
+ * legal outcome in frame_codes.c, weighted by the chance of rolling it
+ * with the roll model ball() uses, and the 10th frame follows the
+ * throw_frame() rules. That is 10 frames x 4 states x 301 scores x at
+ * most 241 outcomes, well under a millisecond, against the billions of
+ * simulated games it takes to estimate the rare scores.
+ *
+ * The simulator draws from alias tables whose thresholds are rounded to
+ * 32 bits, so its probabilities can differ from the model's pmf in about
+ * the tenth decimal place.
+ */
+#include <math.h>
+#include <string.h>
+
+#include "score_distribution.h"
+#include "frame_codes.h"
+
+// extra count of the next ball and the ball after it, for each bonus_state
+static const int next_ball_bonus[BONUS_STATES] = { 0, 1, 1, 2 };
+static const int ball_after_bonus[BONUS_STATES] = { 0, 0, 1, 1 };
+
+/// @brief Chance of rolling regular_frame_codes[code] in frames 1-9
+double regular_frame_probability(const struct roll_model *model, int code)
+{
+    const struct frame_code *frame = &regular_frame_codes[code];
+
+    if (frame->type == STRIKE)
+        return model->pmf[MAX_PINS][MAX_PINS];
+    return model->pmf[MAX_PINS][frame->first_ball] * model->pmf[MAX_PINS - frame->first_ball][frame->second_ball];
+}
+
+/// @brief Chance of rolling last_frame_codes[code] in the 10th frame
+double last_frame_probability(const struct roll_model *model, int code)
+{
+    const struct frame_code *frame = &last_frame_codes[code];
+    int first = frame->first_ball;
+    int second = frame->second_ball;
+    int third = frame->third_ball;
+
+    if (first == MAX_PINS)
+    {
+        // the third ball has a fresh rack only after a second strike
+        int standing = second == MAX_PINS ? MAX_PINS : MAX_PINS - second;
+        return model->pmf[MAX_PINS][MAX_PINS] * model->pmf[MAX_PINS][second] * model->pmf[standing][third];
+    }
+
+    double p = model->pmf[MAX_PINS][first] * model->pmf[MAX_PINS - first][second];
+    if (first + second == MAX_PINS)
+        p *= model->pmf[MAX_PINS][third];    // a spare earns a ball on a fresh rack
+    return p;
+}
+
+/**
+ * Points added to the score by the balls of a frame in frames 1-9.
+ *
+ * @param code regular_frame_codes index of the frame
+ * @param state bonuses owed when the frame starts
+ * @param next_state receives the bonuses owed after it
+ * @return the frame's pins plus the bonuses they pay to earlier frames
+ */
+int regular_frame_points(int code, enum bonus_state state, enum bonus_state *next_state)
+{
+    const struct frame_code *frame = &regular_frame_codes[code];
+
+    if (frame->type == STRIKE)
+    {
+        *next_state = ball_after_bonus[state] ? BONUS_DOUBLE : BONUS_STRIKE;
+        return STRIKE_SCORE * (1 + next_ball_bonus[state]);
+    }
+
+    *next_state = frame->type == SPARE ? BONUS_SPARE : BONUS_NONE;
+    return frame->first_ball * (1 + next_ball_bonus[state]) + frame->second_ball * (1 + ball_after_bonus[state]);
+}
+
+/// @brief Points added to the score by the balls of the 10th frame, see regular_frame_points()
+int last_frame_points(int code, enum bonus_state state)
+{
+    const struct frame_code *frame = &last_frame_codes[code];
+
+    // the 10th frame's own bonus balls only count once
+    return frame->first_ball * (1 + next_ball_bonus[state]) + frame->second_ball * (1 + ball_after_bonus[state]) +
+           frame->third_ball;
+}
+
+/**
+ * Works out the exact probability of every final score.
+ *
+ * @param model roll probabilities, as used by ball_r()
+ * @param pmf receives the probability of each final score 0-300
+ */
+void score_distribution(const struct roll_model *model, double pmf[MAX_SCORE + 1])
+{
+    double current[BONUS_STATES][MAX_SCORE + 1];
+    double next[BONUS_STATES][MAX_SCORE + 1];
+    double regular[REGULAR_FRAME_CODES];
+    double last[LAST_FRAME_CODES];
+
+    for (int c = 0; c < REGULAR_FRAME_CODES; c++)
+        regular[c] = regular_frame_probability(model, c);
+    for (int c = 0; c < LAST_FRAME_CODES; c++)
+        last[c] = last_frame_probability(model, c);
+
+    memset(current, 0, sizeof(current));
+    current[BONUS_NONE][0] = 1.0;
+
+    // frames 1-9
+    for (int frame = 0; frame < MAX_FRAMES - 1; frame++)
+    {
+        // no score above 30 points a frame is reachable yet
+        int reachable = STRIKE_SCORE * 3 * frame;
+
+        memset(next, 0, sizeof(next));
+        for (int state = 0; state < BONUS_STATES; state++)
+        {
+            for (int c = 0; c < REGULAR_FRAME_CODES; c++)
+            {
+                enum bonus_state next_state;
+                int points = regular_frame_points(c, (enum bonus_state)state, &next_state);
+                for (int score = 0; score <= reachable; score++)
+                    next[next_state][score + points] += current[state][score] * regular[c];
+            }
+        }
+        memcpy(current, next, sizeof(current));
+    }
+
+    // 10th frame
+    memset(pmf, 0, sizeof(double) * (MAX_SCORE + 1));
+    for (int state = 0; state < BONUS_STATES; state++)
+    {
+        for (int c = 0; c < LAST_FRAME_CODES; c++)
+        {
+            int points = last_frame_points(c, (enum bonus_state)state);
+            for (int score = 0; score + points <= MAX_SCORE; score++)
+                pmf[score + points] += current[state][score] * last[c];
+        }
+    }
+}
+
+/// @brief Expected final score
+double distribution_mean(const double pmf[MAX_SCORE + 1])
+{
+    double sum = 0.0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+        sum += s * pmf[s];
+    return sum;
+}
+
+/// @brief Standard deviation of the final score
+double distribution_stddev(const double pmf[MAX_SCORE + 1])
+{
+    double mean = distribution_mean(pmf);
+    double sum = 0.0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+        sum += (s - mean) * (s - mean) * pmf[s];
+    return sqrt(sum);
+}
+
+/// @brief Lowest score with at least 'percent' percent of the probability at or below it
+/// @return the score, matching simulation_percentile()
+int distribution_percentile(const double pmf[MAX_SCORE + 1], double percent)
+{
+    if (percent >= 100.0)
+    {
+        // the tail is too small to reach by adding up from the bottom
+        int s = MAX_SCORE;
+        while (s > 0 && pmf[s] <= 0.0)
+            s--;
+        return s;
+    }
+
+    double needed = percent / 100.0 - 1e-12;
+    double seen = 0.0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+    {
+        seen += pmf[s];
+        if (pmf[s] > 0.0 && seen >= needed)
+            return s;
+    }
+    return MAX_SCORE;
+}
+
+/// @brief Print the summary statistics followed by the probability of every possible score
+void report_distribution(const double pmf[MAX_SCORE + 1], FILE *out)
+{
+    fprintf(out, "Mean:    %11.2f\n", distribution_mean(pmf));
+    fprintf(out, "Std dev: %11.2f\n", distribution_stddev(pmf));
+    fprintf(out, "Min:     %11d\n", distribution_percentile(pmf, 0.0));
+    fprintf(out, "P50:     %11d\n", distribution_percentile(pmf, 50.0));
+    fprintf(out, "P90:     %11d\n", distribution_percentile(pmf, 90.0));
+    fprintf(out, "P99:     %11d\n", distribution_percentile(pmf, 99.0));
+    fprintf(out, "Max:     %11d\n", distribution_percentile(pmf, 100.0));
+
+    fprintf(out, "\nScore  Probability\n");
+    for (int s = 0; s <= MAX_SCORE; s++)
+        if (pmf[s] > 0.0)
+            fprintf(out, "%5d  %.6e\n", s, pmf[s]);
+}
@@ -0,0 +1,31 @@
+// score_distribution.h
+#ifndef SCORE_DISTRIBUTION_H
+#define SCORE_DISTRIBUTION_H
+
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "roll_model.h"
+
+// Bonuses still owed by earlier frames when a frame starts
+enum bonus_state
+{
+    BONUS_NONE,     // nothing pending
+    BONUS_SPARE,    // a spare takes the next ball
+    BONUS_STRIKE,   // a strike takes the next two balls
+    BONUS_DOUBLE,   // two strikes take the next ball, the last of them the ball after too
+    BONUS_STATES
+};
+
+double regular_frame_probability(const struct roll_model *model, int code);
+double last_frame_probability(const struct roll_model *model, int code);
+int regular_frame_points(int code, enum bonus_state state, enum bonus_state *next_state);
+int last_frame_points(int code, enum bonus_state state);
+
+void score_distribution(const struct roll_model *model, double pmf[MAX_SCORE + 1]);
+double distribution_mean(const double pmf[MAX_SCORE + 1]);
+double distribution_stddev(const double pmf[MAX_SCORE + 1]);
+int distribution_percentile(const double pmf[MAX_SCORE + 1], double percent);
+void report_distribution(const double pmf[MAX_SCORE + 1], FILE *out);
+
+#endif // SCORE_DISTRIBUTION_H
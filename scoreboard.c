@@ -0,0 +1,302 @@
+/**
+ * @file scoreboard.c
+ * @brief Live lane scores in shared memory, for displays in other processes
+ *
+ * The scoring process creates a POSIX shared memory segment holding every
+ * lane's current game, and publishes a lane's game after every roll.
+ * Displays (TV overlays, lane monitors, the front desk) map the segment
+ * read-only and copy a lane whenever they redraw: no system calls, no
+ * pipes and no text to parse, and the scoring process never waits for
+ * them.
+ *
+ * Layout (all fields native endian, see scoreboard.h):
+ * - a 64-byte header: magic, version, lane count and lane size; the
+ *   magic is stored last, so a reader that finds it sees the rest
+ * - one struct scoreboard_lane per lane, each starting on its own cache
+ *   line so lanes written by different threads don't share lines
+ *
+ * Each lane has its own seqlock (seqlock.h), written only by the thread
+ * that scores the lane, as the lane server's workers do. A reader copies
+ * the lane and takes it again if a write overlapped, so it only ever
+ * keeps a whole game as it stood after some roll. Unlike
+ * seqlock_read_begin(), scoreboard_read() gives up after
+ * SCOREBOARD_READ_TRIES if the lane stays locked, so a display doesn't
+ * hang on a scoring process that died mid-update.
+ *
+ * scoreboard_create() replaces any segment of the same name; readers
+ * still mapping the old one keep it until they close it. The segment is
+ * left in place when the scoring process closes it, so displays go on
+ * showing the final scores, until it is created again or removed
+ * (rm /dev/shm/NAME on Linux).
+ *
+ * Example output (--watch lanes, while --serve 4 --scoreboard lanes runs):
+ * Lane   Games  Frame  Score   Live
+ *    0     812      4     47     58
+ *    1     809     10    131    139
+ *    2     811      1      0      7
+ *    3     810      7     86     96
+ */
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "scoreboard.h"
+#include "game_display.h"
+
+/// @brief The shm_open() name for 'name', which needs a leading '/'
+/// @return 1 if good or 0 if the name is empty, too long or has another '/'
+static int segment_name(const char *name, char path[NAME_MAX + 1])
+{
+    if (*name == '/')
+        name++;
+    size_t length = strlen(name);
+    if (length == 0 || length >= NAME_MAX || strchr(name, '/'))
+        return 0;
+    path[0] = '/';
+    memcpy(path + 1, name, length + 1);
+    return 1;
+}
+
+static size_t segment_size(int lanes)
+{
+    return sizeof(struct scoreboard_header) + (size_t)lanes * sizeof(struct scoreboard_lane);
+}
+
+static void map_lanes(struct scoreboard *board, void *base, size_t size, int lanes)
+{
+    board->header = base;
+    board->lanes = (struct scoreboard_lane *)((char *)base + sizeof(struct scoreboard_header));
+    board->size = size;
+    board->lane_count = lanes;
+}
+
+/**
+ * Creates a scoreboard for the scoring process, every lane without a game.
+ *
+ * @param board receives the writable mapping
+ * @param name the segment's name, with or without a leading '/'
+ * @param lanes lanes on the board, at most SCOREBOARD_MAX_LANES
+ * @return 1 if good or 0 if the segment could not be created
+ */
+int scoreboard_create(struct scoreboard *board, const char *name, int lanes)
+{
+    char path[NAME_MAX + 1];
+    if (lanes < 1 || lanes > SCOREBOARD_MAX_LANES || !segment_name(name, path))
+        return 0;
+
+    size_t size = segment_size(lanes);
+    shm_unlink(path);
+    int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return 0;
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(path);
+        return 0;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(path);
+        return 0;
+    }
+
+    // the segment starts zeroed, so only what isn't 0 needs setting
+    map_lanes(board, base, size, lanes);
+    for (int lane = 0; lane < lanes; lane++)
+    {
+        seqlock_init(&board->lanes[lane].lock);
+        memset(board->lanes[lane].scores.type, UNDEFINED, sizeof(board->lanes[lane].scores.type));
+    }
+    board->header->version = SCOREBOARD_VERSION;
+    board->header->lanes = (uint32_t)lanes;
+    board->header->lane_size = sizeof(struct scoreboard_lane);
+    atomic_store_explicit(&board->header->magic, SCOREBOARD_MAGIC, memory_order_release);
+    return 1;
+}
+
+/**
+ * Maps a scoreboard read-only, for a display.
+ *
+ * @param board receives the mapping
+ * @param name the segment's name, as given to scoreboard_create()
+ * @return 1 if good or 0 if there is no such scoreboard, it isn't set up
+ *         yet, or it was made by an incompatible build
+ */
+int scoreboard_open(struct scoreboard *board, const char *name)
+{
+    char path[NAME_MAX + 1];
+    struct stat info;
+    if (!segment_name(name, path))
+        return 0;
+
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(struct scoreboard_header))
+    {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)info.st_size;
+    void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return 0;
+
+    struct scoreboard_header *header = base;
+    if (atomic_load_explicit(&header->magic, memory_order_acquire) != SCOREBOARD_MAGIC ||
+        header->version != SCOREBOARD_VERSION || header->lane_size != sizeof(struct scoreboard_lane) ||
+        header->lanes < 1 || header->lanes > SCOREBOARD_MAX_LANES || size < segment_size((int)header->lanes))
+    {
+        munmap(base, size);
+        return 0;
+    }
+    map_lanes(board, base, size, (int)header->lanes);
+    return 1;
+}
+
+/// @brief Unmap the scoreboard; the segment stays for other processes
+void scoreboard_close(struct scoreboard *board)
+{
+    if (board->header)
+        munmap(board->header, board->size);
+    board->header = NULL;
+    board->lanes = NULL;
+}
+
+/**
+ * Publishes a lane's game after a roll, from the one thread scoring the
+ * lane; matches lane_publish_fn once wrapped.
+ *
+ * @param board a board from scoreboard_create()
+ * @param lane the lane, counting from 0
+ * @param state the lane's game after the roll
+ */
+void scoreboard_publish(struct scoreboard *board, int lane, const struct game_state *state)
+{
+    if (lane < 0 || lane >= board->lane_count)
+        return;
+    struct scoreboard_lane *slot = &board->lanes[lane];
+    struct scoreboard_scores *scores = &slot->scores;
+    int complete = game_state_complete(state);
+
+    seqlock_write_begin(&slot->lock);
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        scores->type[i] = (uint8_t)state->frames[i].type;
+        scores->first_ball[i] = (uint8_t)state->frames[i].first_ball;
+        scores->second_ball[i] = (uint8_t)state->frames[i].second_ball;
+        scores->score[i] = (uint16_t)state->frames[i].score;
+        scores->cumulative[i] = i < state->finalized ? (uint16_t)state->cumulative[i] : 0;
+    }
+    scores->third_ball = (uint8_t)state->frames[MAX_FRAMES - 1].third_ball;
+    scores->frame = (uint8_t)state->frame;
+    scores->ball = (uint8_t)state->ball;
+    scores->finalized = (uint8_t)state->finalized;
+    scores->complete = (uint8_t)complete;
+    scores->total = (uint16_t)state->total;
+    scores->live_total = (uint16_t)state->live_total;
+    scores->games += (uint32_t)complete;
+    seqlock_write_end(&slot->lock);
+}
+
+/**
+ * Copies a lane's game as it stood after some roll.
+ *
+ * @param board a board from scoreboard_open() or scoreboard_create()
+ * @param lane the lane, counting from 0
+ * @param scores receives the lane's game
+ * @return 1 if good or 0 if there is no such lane or it stayed locked for
+ *         SCOREBOARD_READ_TRIES tries
+ */
+int scoreboard_read(const struct scoreboard *board, int lane, struct scoreboard_scores *scores)
+{
+    if (lane < 0 || lane >= board->lane_count)
+        return 0;
+    const struct scoreboard_lane *slot = &board->lanes[lane];
+
+    for (int tries = 0; tries < SCOREBOARD_READ_TRIES; tries++)
+    {
+        unsigned sequence = atomic_load_explicit((atomic_uint *)&slot->lock.sequence, memory_order_acquire);
+        if (sequence & 1)
+        {
+            sched_yield();
+            continue;
+        }
+        memcpy(scores, &slot->scores, sizeof(*scores));
+        if (!seqlock_read_retry(&slot->lock, sequence))
+            return 1;
+    }
+    return 0;
+}
+
+/// @brief The frames of a copied lane, for game_display.c and game_render.c
+void scoreboard_frames(const struct scoreboard_scores *scores, struct frame_results frames[MAX_FRAMES])
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        frames[i].type = (enum frame_type)scores->type[i];
+        frames[i].first_ball = scores->first_ball[i];
+        frames[i].second_ball = scores->second_ball[i];
+        frames[i].third_ball = i == MAX_FRAMES - 1 ? scores->third_ball : 0;
+        frames[i].score = scores->score[i];
+    }
+}
+
+/// @brief Print one line per lane: games finished, frame being bowled and score
+void report_scoreboard(const struct scoreboard *board, FILE *out)
+{
+    struct scoreboard_scores scores;
+
+    fprintf(out, "Lane   Games  Frame  Score   Live\n");
+    for (int lane = 0; lane < board->lane_count; lane++)
+    {
+        if (!scoreboard_read(board, lane, &scores))
+        {
+            fprintf(out, "%4d  locked\n", lane);
+            continue;
+        }
+        int frame = scores.frame < MAX_FRAMES ? scores.frame + 1 : MAX_FRAMES;
+        fprintf(out, "%4d %7u %6d %6u %6u\n", lane, scores.games, frame, scores.total, scores.live_total);
+    }
+}
+
+/// @brief Print a lane's game so far, frame by frame as print_frame() does
+/// @return 1 if good or 0 if the lane could not be read
+int report_scoreboard_lane(const struct scoreboard *board, int lane, FILE *out)
+{
+    struct scoreboard_scores scores;
+    struct frame_results frames[MAX_FRAMES];
+
+    if (!scoreboard_read(board, lane, &scores))
+        return 0;
+    scoreboard_frames(&scores, frames);
+
+    fprintf(out, "Lane %d, game %u%s\n", lane, scores.games + !scores.complete,
+            scores.complete ? ", finished" : "");
+    int subtotal = 0;
+    for (int i = 0; i < MAX_FRAMES && frames[i].type != UNDEFINED; i++)
+    {
+        subtotal += frames[i].score;
+        print_frame(frames[i], i, subtotal, out);
+    }
+
+    // the frame being bowled has no type until its last ball
+    int frame = scores.frame;
+    if (frame < MAX_FRAMES && frames[frame].type == UNDEFINED && scores.ball > 0)
+    {
+        fprintf(out, "Frame %2d: %2d", frame + 1, scores.first_ball[frame]);
+        if (scores.ball > 1)
+            fprintf(out, " %2d", scores.second_ball[frame]);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "Score: %u  Live: %u\n", scores.total, scores.live_total);
+    return 1;
+}
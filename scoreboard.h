@@ -0,0 +1,72 @@
+// scoreboard.h
+#ifndef SCOREBOARD_H
+#define SCOREBOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "live_score.h"
+#include "seqlock.h"
+
+#define SCOREBOARD_MAGIC 0x42534342u    // "BCSB"
+#define SCOREBOARD_VERSION 1
+#define SCOREBOARD_MAX_LANES 65536
+#define SCOREBOARD_READ_TRIES 1000      // reads of a lane before giving up on a stuck writer
+
+// One lane's game as published, fixed width so any reader can map it
+struct scoreboard_scores
+{
+    uint32_t games;                     // games finished on the lane
+    uint8_t frame;                      // frame being bowled, MAX_FRAMES once the game is over
+    uint8_t ball;                       // next ball within the frame
+    uint8_t finalized;                  // frames whose score can no longer change
+    uint8_t complete;                   // 1 once the game is over, until the next ball
+    uint16_t total;                     // score of the finalized frames
+    uint16_t live_total;                // every pin and bonus counted so far
+    uint8_t type[MAX_FRAMES];           // enum frame_type, UNDEFINED until bowled
+    uint8_t first_ball[MAX_FRAMES];
+    uint8_t second_ball[MAX_FRAMES];
+    uint8_t third_ball;                 // of the 10th frame
+    uint8_t reserved;
+    uint16_t score[MAX_FRAMES];         // each frame's score so far, bonuses included
+    uint16_t cumulative[MAX_FRAMES];    // running total, set once a frame is finalized
+};
+
+struct scoreboard_lane
+{
+    _Alignas(64) struct seqlock lock;   // a lane to a cache line or two, so lanes don't share lines
+    struct scoreboard_scores scores;
+};
+
+// start of the segment
+struct scoreboard_header
+{
+    _Alignas(64) atomic_uint magic;     // SCOREBOARD_MAGIC once the rest is set up
+    uint32_t version;
+    uint32_t lanes;
+    uint32_t lane_size;                 // sizeof(struct scoreboard_lane)
+};
+
+// a process's mapping of a scoreboard
+struct scoreboard
+{
+    struct scoreboard_header *header;
+    struct scoreboard_lane *lanes;
+    size_t size;                        // bytes mapped
+    int lane_count;
+};
+
+int scoreboard_create(struct scoreboard *board, const char *name, int lanes);
+int scoreboard_open(struct scoreboard *board, const char *name);
+void scoreboard_close(struct scoreboard *board);
+
+void scoreboard_publish(struct scoreboard *board, int lane, const struct game_state *state);
+int scoreboard_read(const struct scoreboard *board, int lane, struct scoreboard_scores *scores);
+void scoreboard_frames(const struct scoreboard_scores *scores, struct frame_results frames[MAX_FRAMES]);
+
+void report_scoreboard(const struct scoreboard *board, FILE *out);
+int report_scoreboard_lane(const struct scoreboard *board, int lane, FILE *out);
+
+#endif // SCOREBOARD_H
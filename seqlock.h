@@ -0,0 +1,74 @@
+/**
+ * @file seqlock.h
+ * @brief Sequence lock: one writer, any number of readers that never block it
+ *
+ * The writer makes the sequence odd while it changes the data and even
+ * again when it is done. A reader notes the sequence, copies the data,
+ * and tries again if the sequence was odd or has moved on since, so it
+ * only ever keeps a copy no write overlapped. The writer never waits for
+ * readers, which suits data written far more often than it is read, or
+ * read by threads that mustn't slow the writer down.
+ * @code
+ * // writer                            // reader
+ * seqlock_write_begin(&lock);          do
+ * ...change the data...                {
+ * seqlock_write_end(&lock);                seq = seqlock_read_begin(&lock);
+ *                                          ...copy the data...
+ *                                      } while (seqlock_read_retry(&lock, seq));
+ * @endcode
+ *
+ * Only one thread may write under a given lock at a time. Readers copy
+ * the data with plain loads and may see a torn copy, which the retry
+ * throws away, so they must not follow pointers in the data before
+ * seqlock_read_retry() has said the copy is good.
+ */
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <sched.h>
+#include <stdatomic.h>
+
+struct seqlock
+{
+    atomic_uint sequence;       // odd while a write is in progress
+};
+
+static inline void seqlock_init(struct seqlock *lock)
+{
+    atomic_init(&lock->sequence, 0);
+}
+
+static inline void seqlock_write_begin(struct seqlock *lock)
+{
+    unsigned sequence = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, sequence + 1, memory_order_relaxed);
+    // the odd sequence is visible before any of the writes to the data
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seqlock_write_end(struct seqlock *lock)
+{
+    unsigned sequence = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, sequence + 1, memory_order_release);
+}
+
+/// @brief Wait for any write in progress to finish
+/// @return the sequence to give seqlock_read_retry()
+static inline unsigned seqlock_read_begin(const struct seqlock *lock)
+{
+    unsigned sequence;
+    while ((sequence = atomic_load_explicit((atomic_uint *)&lock->sequence, memory_order_acquire)) & 1)
+        sched_yield();
+    return sequence;
+}
+
+/// @brief Check the data copied since seqlock_read_begin()
+/// @return 1 if a write overlapped the copy and it must be taken again, or 0 if the copy is good
+static inline int seqlock_read_retry(const struct seqlock *lock, unsigned sequence)
+{
+    // the data is read before the sequence is checked again
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit((atomic_uint *)&lock->sequence, memory_order_relaxed) != sequence;
+}
+
+#endif // SEQLOCK_H
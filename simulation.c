@@ -0,0 +1,256 @@
+/**
+ * @file simulation.c
+ * @brief Multi-threaded batch (Monte Carlo) simulation of many games
+ *
+ * Plays a large number of games, validates and scores each one, and
+ * reduces the final scores into a histogram from which the mean, standard
+ * deviation and percentiles are reported.
+ *
+ * Threading:
+ * - The games are split evenly across the worker threads
+ * - Each thread owns its own generator, seeded from the run seed and the
+ *   thread number, so no random state is shared between threads
+ * - Each thread tallies into its own histogram; the histograms are summed
+ *   once all threads have finished, so no locking is needed while playing
+ * - Games are validated and scored a game_batch at a time
+ * - With config->render set, each thread renders its games into its own
+ *   game_renderer buffer; games are numbered in thread order, so the
+ *   numbers don't depend on which thread writes first
+ *
+ * A run with the same seed and thread count always gives the same results.
+ * With RNG_PHILOX each game is played from its own counter-based stream,
+ * numbered by game, so the results don't depend on the thread count
+ * either, and game k can be played again alone with --replay k.
+ *
+ * Each batch's play, validation, scoring and rendering is timed as a
+ * stage when built with BOWLING_STATS, see bowling_stats.c.
+ *
+ * Example output (--simulate 2000000 --seed 1):
+ * Games:       2000000
+ * Invalid:           0
+ * Mean:         136.49
+ * Std dev:       22.77
+ * Min:              56
+ * P50:             135
+ * P90:             167
+ * P99:             198
+ * Max:             298
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simulation.h"
+#include "game_batch.h"
+#include "frame_validator.h"
+#include "score_calculator.h"
+#include "bowling_stats.h"
+#include "worker_threads.h"
+
+
+// games played and checked together by validate_game_batch() and calculate_game_scores_batch()
+#define SIMULATION_BATCH 4096
+
+struct simulation_worker
+{
+    unsigned long long games;       // games for this worker to play
+    unsigned long long first_game;  // number of this worker's first game
+    int failed;                     // set if the batch could not be allocated or the games written
+    const struct game_renderer *render;
+    const struct roll_model *model;
+    struct bowling_rng rng;
+    struct simulation_results results;
+};
+
+/// @brief Play, validate and score one worker's share of the games
+/// @param arg struct simulation_worker for this thread
+static void *simulation_thread(void *arg)
+{
+    struct simulation_worker *worker = arg;
+    struct frame_results frames[MAX_FRAMES];
+    struct game_batch batch;
+    struct game_renderer render;
+    uint8_t errors[SIMULATION_BATCH];
+
+    if (!game_batch_init(&batch, SIMULATION_BATCH))
+    {
+        worker->failed = 1;
+        return NULL;
+    }
+    if (worker->render && !renderer_init(&render, worker->render->fd, worker->render->format, worker->render->output))
+    {
+        game_batch_free(&batch);
+        worker->failed = 1;
+        return NULL;
+    }
+
+    unsigned long long game = worker->first_game;
+    unsigned long long remaining = worker->games;
+    while (remaining > 0)
+    {
+        size_t games = remaining < SIMULATION_BATCH ? (size_t)remaining : SIMULATION_BATCH;
+        remaining -= games;
+
+        STATS_START(generate);
+        game_batch_clear(&batch);
+        for (size_t g = 0; g < games; g++)
+        {
+            init_game_results(frames);
+            bowling_rng_seek(&worker->rng, game + g);
+            play_game_r(frames, worker->model, &worker->rng);
+            game_batch_add(&batch, frames);
+        }
+        STATS_STOP(STAGE_GENERATE, generate, games);
+
+        STATS_START(validate);
+        validate_game_batch(&batch, errors);
+        STATS_STOP(STAGE_VALIDATE, validate, games);
+        STATS_START(score);
+        calculate_game_scores_batch(&batch);
+        STATS_STOP(STAGE_SCORE, score, games);
+
+        for (size_t g = 0; g < games; g++)
+        {
+            if (errors[g] != NO_ERROR)
+            {
+                worker->results.invalid_games++;
+                STATS_ERROR(errors[g]);
+            }
+            else
+                worker->results.histogram[batch.total[g]]++;
+        }
+
+        if (worker->render)
+        {
+            STATS_START(output);
+            render_game_batch(&render, game, &batch, errors);
+            STATS_STOP(STAGE_OUTPUT, output, games);
+        }
+        game += games;
+        STATS_POLL();
+    }
+
+    if (worker->render && !renderer_finish(&render))
+        worker->failed = 1;
+    game_batch_free(&batch);
+    worker->results.games = worker->games;
+    return NULL;
+}
+
+/**
+ * Plays config->games games spread across config->threads threads.
+ *
+ * @param config number of games, threads and seed for the run
+ * @param results filled in with the combined results of all threads
+ *
+ * If a thread can't be started its share of the games is played on the
+ * calling thread instead.
+ * 
+ * @return 1 if good or 0 if the workers or their buffers could not be
+ *         allocated or a worker could not write out its games
+ */
+int run_simulation(const struct simulation_config *config, struct simulation_results *results)
+{
+    int threads = worker_thread_count(config->threads);
+    if ((unsigned long long)threads > config->games)
+        threads = config->games > 0 ? (int)config->games : 1;
+
+    struct simulation_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    if (!workers)
+        return 0;
+
+    unsigned long long first_game = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        memset(&workers[t].results, 0, sizeof(workers[t].results));
+        workers[t].failed = 0;
+        workers[t].games = config->games / threads + ((unsigned long long)t < config->games % threads);
+        workers[t].first_game = first_game;
+        first_game += workers[t].games;
+        workers[t].model = config->model;
+        workers[t].render = config->render;
+        bowling_rng_init(&workers[t].rng, config->rng, config->seed, t);
+    }
+    run_worker_threads(workers, sizeof(*workers), threads, simulation_thread);
+
+    int good = 1;
+    memset(results, 0, sizeof(*results));
+    for (int t = 0; t < threads; t++)
+    {
+        if (workers[t].failed)
+            good = 0;
+
+        results->games += workers[t].results.games;
+        results->invalid_games += workers[t].results.invalid_games;
+        for (int s = 0; s <= MAX_SCORE; s++)
+            results->histogram[s] += workers[t].results.histogram[s];
+    }
+    free(workers);
+    return good;
+}
+
+/// @brief Mean final score of the valid games
+double simulation_mean(const struct simulation_results *results)
+{
+    unsigned long long scored = results->games - results->invalid_games;
+    if (scored == 0)
+        return 0.0;
+
+    double sum = 0.0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+        sum += (double)s * results->histogram[s];
+    return sum / scored;
+}
+
+/// @brief Standard deviation of the final score of the valid games
+double simulation_stddev(const struct simulation_results *results)
+{
+    unsigned long long scored = results->games - results->invalid_games;
+    if (scored == 0)
+        return 0.0;
+
+    double mean = simulation_mean(results);
+    double sum = 0.0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+        sum += (s - mean) * (s - mean) * results->histogram[s];
+    return sqrt(sum / scored);
+}
+
+/// @brief Lowest score that at least 'percent' percent of valid games reached or stayed under
+/// @return the score, or -1 if no games were scored
+int simulation_percentile(const struct simulation_results *results, double percent)
+{
+    unsigned long long scored = results->games - results->invalid_games;
+    if (scored == 0)
+        return -1;
+
+    double needed = scored * percent / 100.0;
+    unsigned long long seen = 0;
+    for (int s = 0; s <= MAX_SCORE; s++)
+    {
+        seen += results->histogram[s];
+        if (seen > 0 && seen >= needed)
+            return s;
+    }
+    return MAX_SCORE;
+}
+
+/// @brief Print the summary statistics followed by the non-empty histogram buckets
+void report_simulation(const struct simulation_results *results, FILE *out)
+{
+    fprintf(out, "Games:   %11llu\n", results->games);
+    fprintf(out, "Invalid: %11llu\n", results->invalid_games);
+    fprintf(out, "Mean:    %11.2f\n", simulation_mean(results));
+    fprintf(out, "Std dev: %11.2f\n", simulation_stddev(results));
+    fprintf(out, "Min:     %11d\n", simulation_percentile(results, 0.0));
+    fprintf(out, "P50:     %11d\n", simulation_percentile(results, 50.0));
+    fprintf(out, "P90:     %11d\n", simulation_percentile(results, 90.0));
+    fprintf(out, "P99:     %11d\n", simulation_percentile(results, 99.0));
+    fprintf(out, "Max:     %11d\n", simulation_percentile(results, 100.0));
+
+    fprintf(out, "\nScore      Games\n");
+    for (int s = 0; s <= MAX_SCORE; s++)
+        if (results->histogram[s] != 0)
+            fprintf(out, "%5d %11llu\n", s, results->histogram[s]);
+}
@@ -0,0 +1,35 @@
+// simulation.h
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bowling_game.h"
+#include "roll_model.h"
+#include "game_render.h"
+
+struct simulation_config
+{
+    unsigned long long games;   // number of games to play
+    int threads;                // worker threads, 0 for one per core, at most MAX_THREADS (worker_threads.h)
+    uint64_t seed;              // run seed, each thread gets its own stream
+    enum rng_kind rng;          // generator each thread uses
+    const struct roll_model *model;     // roll probabilities
+    const struct game_renderer *render; // if set, every game is written to its fd in its format, under its lock
+};
+
+struct simulation_results
+{
+    unsigned long long games;           // games played
+    unsigned long long invalid_games;   // games that failed validation
+    unsigned long long histogram[MAX_SCORE + 1];    // count of each final score
+};
+
+int run_simulation(const struct simulation_config *config, struct simulation_results *results);
+double simulation_mean(const struct simulation_results *results);
+double simulation_stddev(const struct simulation_results *results);
+int simulation_percentile(const struct simulation_results *results, double percent);
+void report_simulation(const struct simulation_results *results, FILE *out);
+
+#endif // SIMULATION_H
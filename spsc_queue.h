@@ -0,0 +1,99 @@
+/**
+ * @file spsc_queue.h
+ * @brief Lock-free single-producer single-consumer queue of 64-bit items
+ *
+ * A power-of-two ring with the producer's and the consumer's indexes on
+ * their own cache lines. Each side also keeps a private copy of the other
+ * side's index and only reloads it when the ring looks full (or empty), so
+ * in the steady state a push or pop touches no cache line the other thread
+ * writes.
+ *
+ * Exactly one thread may push and exactly one thread may pop. The indexes
+ * only ever increase; the slot is the index masked by the capacity.
+ */
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SPSC_CACHE_LINE 64
+
+struct spsc_queue
+{
+    // consumer side
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t head;   // next item to pop
+    size_t cached_tail;                             // consumer's copy of tail
+
+    // producer side
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t tail;   // next slot to push into
+    size_t cached_head;                             // producer's copy of head
+
+    // fixed after spsc_init()
+    _Alignas(SPSC_CACHE_LINE) size_t mask;
+    uint64_t *items;
+};
+
+/// @brief Allocate the ring
+/// @param capacity items the queue can hold, rounded up to a power of two
+/// @return 1 if good or 0 if memory could not be allocated
+static inline int spsc_init(struct spsc_queue *queue, size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cached_head = 0;
+    queue->cached_tail = 0;
+    queue->mask = size - 1;
+    queue->items = malloc(size * sizeof(queue->items[0]));
+    return queue->items != NULL;
+}
+
+static inline void spsc_free(struct spsc_queue *queue)
+{
+    free(queue->items);
+    queue->items = NULL;
+}
+
+/// @brief Add an item, producer thread only
+/// @return 1 if added or 0 if the queue is full
+static inline int spsc_push(struct spsc_queue *queue, uint64_t item)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if (tail - queue->cached_head > queue->mask)
+    {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail - queue->cached_head > queue->mask)
+            return 0;
+    }
+
+    queue->items[tail & queue->mask] = item;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/// @brief Take the oldest item, consumer thread only
+/// @return 1 if an item was taken or 0 if the queue is empty
+static inline int spsc_pop(struct spsc_queue *queue, uint64_t *item)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if (head == queue->cached_tail)
+    {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->cached_tail)
+            return 0;
+    }
+
+    *item = queue->items[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return 1;
+}
+
+#endif // SPSC_QUEUE_H
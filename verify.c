@@ -0,0 +1,728 @@
+/**
+ * @file verify.c
+ * @brief Differential check of every scorer against a reference scorer
+ *
+ * The program scores games in many ways: the frame-at-a-time scorer, the
+ * fused validate-and-score pass, the batch kernels (scalar, SSE4.2,
+ * AVX2), the lookup-table scorer over frame codes, the live scorer fed a
+ * ball at a time and the rules engine. Each game is scored by all of
+ * them and compared, frame by frame, with a scorer kept here that is as
+ * plain as possible and shares no code with them: it walks the list of
+ * balls and adds the next one or two to each strike or spare.
+ *
+ * The games:
+ * - exhaustive: a frame's score depends only on itself and the two
+ *   frames after it, so the games are every legal triple of frame codes
+ *   at each position: 66^3 triples of regular frames at frames 1-7, and
+ *   66 * 66 * 241 triples ending in the 10th frame at frames 8-10, which
+ *   also covers every 9th and 10th frame pair. The frames outside the
+ *   triple cycle through the codes. 3,062,268 games in all
+ * - random: any number of games with every frame drawn from the codes,
+ *   a strike a third of the time so runs of strikes are common. Game n
+ *   is drawn from Philox stream n, so a failing game can be told by its
+ *   number whatever the thread count
+ *
+ * Every game is also corrupted (one ball or frame type set to a random
+ * value, which is usually illegal) and validate_game(), the fused pass
+ * and both batch validators must give the same error for it.
+ *
+ * Games are numbered exhaustive first, then random, and split evenly
+ * across worker threads, each checking a game_batch at a time with its
+ * own buffers and tallies, which are summed when all have finished.
+ *
+ * The leaderboard (leaderboard.c) is checked apart from the scorers, with
+ * one thread streaming VERIFY_BOARD_GAMES games into a board while
+ * VERIFY_BOARD_READERS threads read its top games, top series and
+ * rolling averages until it is done. Game n's player, session and score
+ * are a function of n, so every copy a reader gets can be checked
+ * against what the writer can have added by then: each entry must be a
+ * game or series that was bowled, the lists sorted, the lowest entry
+ * kept never falling, and each average the average of the player's last
+ * games at some point during the read. Its count is reads, not games.
+ *
+ * Example output (--verify 10000000 --seed 1):
+ * Exhaustive games:      3062268  every legal frame triple
+ * Random games:         10000000  seed 1
+ * Check                    Games  Mismatches
+ * calculate             13062268           0
+ * fused                 13062268           0
+ * batch scalar          13062268           0
+ * batch sse4.2          13062268           0
+ * batch avx2            13062268           0
+ * fused batch           13062268           0
+ * codes                 13062268           0
+ * codes batch           13062268           0
+ * live                  13062268           0
+ * rules                 13062268           0
+ * round trip            13062268           0
+ * validators            13062268           0
+ * leaderboard             2871449           0
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "verify.h"
+#include "bowling_game.h"
+#include "bowling_rng.h"
+#include "bowling_variants.h"
+#include "frame_codes.h"
+#include "frame_validator.h"
+#include "game_batch.h"
+#include "leaderboard.h"
+#include "live_score.h"
+#include "score_calculator.h"
+#include "worker_threads.h"
+
+
+// games checked together by the batch scorers
+#define VERIFY_BATCH 1024
+
+// games with every triple of regular frames at each of frames 1-7, then every triple ending in the 10th
+#define TRIPLE_GAMES ((unsigned long long)REGULAR_FRAME_CODES * REGULAR_FRAME_CODES * REGULAR_FRAME_CODES)
+#define LAST_TRIPLE_GAMES ((unsigned long long)REGULAR_FRAME_CODES * REGULAR_FRAME_CODES * LAST_FRAME_CODES)
+#define EXHAUSTIVE_GAMES ((MAX_FRAMES - 3) * TRIPLE_GAMES + LAST_TRIPLE_GAMES)
+
+// the leaderboard check: games streamed in, by players spread over several chunks, and the readers
+#define VERIFY_BOARD_GAMES (1u << 21)
+#define VERIFY_BOARD_PLAYERS 3000
+#define VERIFY_BOARD_SESSION_GAMES 4    // games each player bowls a session, the first 3 a series
+#define VERIFY_BOARD_TOP 32
+#define VERIFY_BOARD_READERS 3
+
+static const char *const check_names[VERIFY_CHECK_COUNT] = {
+    "calculate", "fused", "batch scalar", "batch sse4.2", "batch avx2", "fused batch",
+    "codes", "codes batch", "live", "rules", "round trip", "validators", "leaderboard"
+};
+
+// one game's inputs and the reference scores
+struct verify_game
+{
+    uint8_t codes[MAX_FRAMES];
+    uint8_t rolls[MAX_ROLLS];
+    int roll_count;
+    int scores[MAX_FRAMES];
+    int total;
+    struct frame_results frames[MAX_FRAMES];
+    struct frame_results corrupt[MAX_FRAMES];
+};
+
+struct verify_buffers
+{
+    struct verify_game games[VERIFY_BATCH];
+    uint8_t codes[VERIFY_BATCH][MAX_FRAMES];    // packed for score_game_codes_batch()
+    uint16_t totals[VERIFY_BATCH];
+    uint8_t errors[VERIFY_BATCH];
+    uint8_t corrupt_errors[VERIFY_BATCH];
+    struct game_batch batch;
+    struct game_batch corrupt_batch;
+};
+
+// the leaderboard check's board, and how far its writer has got
+struct verify_board
+{
+    struct leaderboard board;
+    atomic_uint added;              // games added, stored after each one
+    atomic_int done;
+};
+
+struct verify_board_reader
+{
+    pthread_t thread;
+    int index;
+    struct verify_board *board;
+    struct verify_results results;
+};
+
+struct verify_worker
+{
+    unsigned long long first_game;
+    unsigned long long games;
+    uint64_t seed;
+    int failed;                 // set if the buffers could not be allocated
+    struct verify_results results;
+};
+
+/// @brief Exhaustive game 'number': one frame triple at its position, the other frames cycling through the codes
+static void triple_game(unsigned long long number, uint8_t codes[MAX_FRAMES])
+{
+    int position = number < (MAX_FRAMES - 3) * TRIPLE_GAMES ? (int)(number / TRIPLE_GAMES) : MAX_FRAMES - 3;
+    unsigned long long triple = number - (unsigned long long)position * TRIPLE_GAMES;
+
+    for (int i = 0; i < MAX_FRAMES - 1; i++)
+        codes[i] = (uint8_t)((triple + 7 * i) % REGULAR_FRAME_CODES);
+    codes[MAX_FRAMES - 1] = (uint8_t)(triple % LAST_FRAME_CODES);
+
+    if (position < MAX_FRAMES - 3)
+    {
+        codes[position + 2] = (uint8_t)(triple % REGULAR_FRAME_CODES);
+        triple /= REGULAR_FRAME_CODES;
+    }
+    else
+    {
+        codes[MAX_FRAMES - 1] = (uint8_t)(triple % LAST_FRAME_CODES);
+        triple /= LAST_FRAME_CODES;
+    }
+    codes[position + 1] = (uint8_t)(triple % REGULAR_FRAME_CODES);
+    codes[position] = (uint8_t)(triple / REGULAR_FRAME_CODES);
+}
+
+/// @brief The balls of a game, straight from the code tables
+static int code_rolls(const uint8_t codes[MAX_FRAMES], uint8_t rolls[MAX_ROLLS])
+{
+    int count = 0;
+
+    for (int i = 0; i < MAX_FRAMES - 1; i++)
+    {
+        const struct frame_code *frame = &regular_frame_codes[codes[i]];
+        rolls[count++] = frame->first_ball;
+        if (frame->first_ball != STRIKE_SCORE)
+            rolls[count++] = frame->second_ball;
+    }
+
+    const struct frame_code *last = &last_frame_codes[codes[MAX_FRAMES - 1]];
+    rolls[count++] = last->first_ball;
+    rolls[count++] = last->second_ball;
+    if (last->first_ball + last->second_ball >= MAX_PINS)
+        rolls[count++] = last->third_ball;
+    return count;
+}
+
+/// @brief The reference: each frame is its balls plus the next one or two balls after a spare or strike
+static int reference_score(const uint8_t rolls[MAX_ROLLS], int scores[MAX_FRAMES])
+{
+    int total = 0;
+    int r = 0;
+
+    for (int frame = 0; frame < MAX_FRAMES; frame++)
+    {
+        if (rolls[r] == MAX_PINS)
+        {
+            scores[frame] = MAX_PINS + rolls[r + 1] + rolls[r + 2];
+            r += 1;
+        }
+        else if (rolls[r] + rolls[r + 1] == MAX_PINS)
+        {
+            scores[frame] = MAX_PINS + rolls[r + 2];
+            r += 2;
+        }
+        else
+        {
+            scores[frame] = rolls[r] + rolls[r + 1];
+            r += 2;
+        }
+        total += scores[frame];
+    }
+    return total;
+}
+
+/// @brief Game 'number' of the run, with its reference scores and a corrupted copy
+/// @param rng a RNG_PHILOX generator seeded with the run seed
+static void make_game(struct bowling_rng *rng, unsigned long long number, struct verify_game *game)
+{
+    bowling_rng_seek(rng, number);
+
+    if (number < EXHAUSTIVE_GAMES)
+        triple_game(number, game->codes);
+    else
+    {
+        for (int i = 0; i < MAX_FRAMES - 1; i++)
+            game->codes[i] = bowling_rng_below(rng, 3) == 0 ? 0 : (uint8_t)bowling_rng_below(rng, REGULAR_FRAME_CODES);
+        game->codes[MAX_FRAMES - 1] = (uint8_t)bowling_rng_below(rng, LAST_FRAME_CODES);
+    }
+
+    memset(game->rolls, 0, sizeof(game->rolls));
+    game->roll_count = code_rolls(game->codes, game->rolls);
+    game->total = reference_score(game->rolls, game->scores);
+    decode_game(game->codes, game->frames);
+
+    // one field of one frame set to anything the batch columns can hold
+    memcpy(game->corrupt, game->frames, sizeof(game->corrupt));
+    struct frame_results *frame = &game->corrupt[bowling_rng_below(rng, MAX_FRAMES)];
+    int value = bowling_rng_below(rng, MAX_PINS + 2);
+    switch (bowling_rng_below(rng, 4))
+    {
+    case 0:
+        frame->type = (enum frame_type)bowling_rng_below(rng, UNDEFINED + 1);
+        break;
+    case 1:
+        frame->first_ball = value;
+        break;
+    case 2:
+        frame->second_ball = value;
+        break;
+    default:
+        frame->third_ball = value;
+        break;
+    }
+}
+
+static inline void tally(struct verify_results *results, enum verify_check check, unsigned long long number, int good)
+{
+    results->checked[check]++;
+    if (!good)
+    {
+        if (results->mismatches[check]++ == 0 || number < results->first_mismatch[check])
+            results->first_mismatch[check] = number;
+    }
+}
+
+static int same_scores(const struct verify_game *game, const struct frame_results frames[MAX_FRAMES])
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (frames[i].score != game->scores[i])
+            return 0;
+    return 1;
+}
+
+static int same_balls(const struct frame_results a[MAX_FRAMES], const struct frame_results b[MAX_FRAMES])
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (a[i].type != b[i].type || a[i].first_ball != b[i].first_ball || a[i].second_ball != b[i].second_ball ||
+            (i == MAX_FRAMES - 1 && a[i].third_ball != b[i].third_ball))
+            return 0;
+    return 1;
+}
+
+static int same_batch_scores(const struct verify_game *game, const struct game_batch *batch, size_t g)
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (batch->score[BATCH_INDEX(batch, i, g)] != game->scores[i])
+            return 0;
+    return batch->total[g] == game->total;
+}
+
+/// @brief Every check that looks at one game at a time
+static void check_game(const struct verify_game *game, unsigned long long number, struct verify_results *results)
+{
+    struct frame_results frames[MAX_FRAMES];
+    int scores[MAX_FRAMES];
+    int cumulative[MAX_FRAMES];
+    int total = 0;
+
+    memcpy(frames, game->frames, sizeof(frames));
+    tally(results, CHECK_CALCULATE, number, calculate_game_scores(frames) == NO_ERROR && same_scores(game, frames));
+
+    memcpy(frames, game->frames, sizeof(frames));
+    int good = validate_and_score_game(frames, cumulative) == NO_ERROR && same_scores(game, frames);
+    for (int i = 0; i < MAX_FRAMES && good; i++)
+        good = cumulative[i] == (total += game->scores[i]);
+    tally(results, CHECK_FUSED, number, good);
+
+    good = score_game_codes(game->codes, scores, &total) == NO_ERROR && total == game->total;
+    for (int i = 0; i < MAX_FRAMES && good; i++)
+        good = scores[i] == game->scores[i];
+    tally(results, CHECK_CODES, number, good);
+
+    struct game_state state;
+    init_game_state(&state);
+    good = 1;
+    for (int r = 0; r < game->roll_count && good; r++)
+        good = push_roll(&state, game->rolls[r]) == NO_ERROR;
+    good = good && game_state_complete(&state) && state.total == game->total;
+    total = 0;
+    for (int i = 0; i < MAX_FRAMES && good; i++)
+        good = state.cumulative[i] == (total += game->scores[i]);
+    tally(results, CHECK_LIVE, number, good);
+
+    good = tenpin_score_rolls(game->rolls, game->roll_count, scores, &total) == NO_ERROR && total == game->total;
+    for (int i = 0; i < MAX_FRAMES && good; i++)
+        good = scores[i] == game->scores[i];
+    tally(results, CHECK_RULES, number, good);
+
+    uint8_t codes[MAX_FRAMES];
+    uint8_t rolls[MAX_ROLLS];
+    good = encode_game(game->frames, codes) == NO_ERROR && memcmp(codes, game->codes, sizeof(codes)) == 0;
+    good = good && rolls_from_frames(game->frames, rolls) == game->roll_count &&
+           memcmp(rolls, game->rolls, (size_t)game->roll_count) == 0;
+    good = good && frames_from_rolls(game->rolls, game->roll_count, frames) == NO_ERROR &&
+           same_balls(frames, game->frames);
+    tally(results, CHECK_ROUND_TRIP, number, good);
+}
+
+/// @brief Check one batch of games, 'first' being the number of the first
+static void check_batch(struct verify_buffers *buffers, size_t count, unsigned long long first,
+                        struct verify_results *results)
+{
+    struct game_batch *batch = &buffers->batch;
+    struct game_batch *corrupt = &buffers->corrupt_batch;
+
+    for (size_t g = 0; g < count; g++)
+        check_game(&buffers->games[g], first + g, results);
+
+    for (int kernel = 0; kernel < SCORE_KERNEL_COUNT; kernel++)
+    {
+        if (!score_kernel_available((enum score_kernel)kernel))
+            continue;
+        memset(batch->score, 0xff, MAX_FRAMES * batch->capacity * sizeof(batch->score[0]));
+        memset(batch->total, 0xff, batch->capacity * sizeof(batch->total[0]));
+        int good = calculate_game_scores_batch_kernel(batch, (enum score_kernel)kernel) == NO_ERROR;
+        for (size_t g = 0; g < count; g++)
+            tally(results, CHECK_BATCH_SCALAR + kernel, first + g, good && same_batch_scores(&buffers->games[g], batch, g));
+    }
+
+    memset(batch->score, 0xff, MAX_FRAMES * batch->capacity * sizeof(batch->score[0]));
+    memset(batch->total, 0xff, batch->capacity * sizeof(batch->total[0]));
+    validate_and_score_game_batch(batch, buffers->errors);
+    for (size_t g = 0; g < count; g++)
+        tally(results, CHECK_FUSED_BATCH, first + g,
+              buffers->errors[g] == NO_ERROR && same_batch_scores(&buffers->games[g], batch, g));
+
+    score_game_codes_batch(buffers->codes[0], MAX_FRAMES, count, buffers->totals, buffers->errors);
+    for (size_t g = 0; g < count; g++)
+        tally(results, CHECK_CODES_BATCH, first + g,
+              buffers->errors[g] == NO_ERROR && buffers->totals[g] == buffers->games[g].total);
+
+    // legal games pass every validator, and the corrupted ones fail them all alike
+    validate_game_batch(batch, buffers->errors);
+    validate_game_batch(corrupt, buffers->corrupt_errors);
+    uint8_t fused_errors[VERIFY_BATCH];
+    validate_and_score_game_batch(corrupt, fused_errors);
+    for (size_t g = 0; g < count; g++)
+    {
+        struct frame_results frames[MAX_FRAMES];
+        memcpy(frames, buffers->games[g].frames, sizeof(frames));
+        int good = buffers->errors[g] == NO_ERROR && validate_game(frames) == NO_ERROR;
+
+        memcpy(frames, buffers->games[g].corrupt, sizeof(frames));
+        enum bowling_error error = validate_game(frames);
+        memcpy(frames, buffers->games[g].corrupt, sizeof(frames));
+        good = good && validate_and_score_game(frames, NULL) == error && buffers->corrupt_errors[g] == error &&
+               fused_errors[g] == error;
+        tally(results, CHECK_VALIDATORS, first + g, good);
+    }
+}
+
+/// @brief Make and check one worker's share of the games
+/// @param arg struct verify_worker for this thread
+static void *verify_thread(void *arg)
+{
+    struct verify_worker *worker = arg;
+    struct verify_buffers *buffers = malloc(sizeof(*buffers));
+    struct bowling_rng rng;
+
+    if (!buffers || !game_batch_init(&buffers->batch, VERIFY_BATCH))
+    {
+        free(buffers);
+        worker->failed = 1;
+        return NULL;
+    }
+    if (!game_batch_init(&buffers->corrupt_batch, VERIFY_BATCH))
+    {
+        game_batch_free(&buffers->batch);
+        free(buffers);
+        worker->failed = 1;
+        return NULL;
+    }
+
+    bowling_rng_init(&rng, RNG_PHILOX, worker->seed, 0);
+    unsigned long long number = worker->first_game;
+    unsigned long long remaining = worker->games;
+    while (remaining > 0)
+    {
+        size_t count = remaining < VERIFY_BATCH ? (size_t)remaining : VERIFY_BATCH;
+        remaining -= count;
+
+        game_batch_clear(&buffers->batch);
+        game_batch_clear(&buffers->corrupt_batch);
+        for (size_t g = 0; g < count; g++)
+        {
+            struct verify_game *game = &buffers->games[g];
+            make_game(&rng, number + g, game);
+            memcpy(buffers->codes[g], game->codes, MAX_FRAMES);
+            game_batch_add(&buffers->batch, game->frames);
+            game_batch_add(&buffers->corrupt_batch, game->corrupt);
+        }
+        check_batch(buffers, count, number, &worker->results);
+        number += count;
+    }
+
+    game_batch_free(&buffers->corrupt_batch);
+    game_batch_free(&buffers->batch);
+    free(buffers);
+    return NULL;
+}
+
+/// @brief Score of leaderboard game n, spread over 0-300
+static int board_score(uint32_t n)
+{
+    uint64_t x = ((uint64_t)n + 1) * 0x9e3779b97f4a7c15ull;
+    x ^= x >> 29;
+    return (int)(x % (MAX_SCORE + 1));
+}
+
+/// @brief Games player has bowled once 'added' games are in
+static uint32_t board_player_games(uint32_t player, uint32_t added)
+{
+    return added > player ? (added - player + VERIFY_BOARD_PLAYERS - 1) / VERIFY_BOARD_PLAYERS : 0;
+}
+
+/// @brief Games a read that has just finished can have seen: those added, and the one being added
+static uint32_t games_visible(struct verify_board *board)
+{
+    uint32_t added = atomic_load_explicit(&board->added, memory_order_acquire);
+    return added < VERIFY_BOARD_GAMES ? added + 1 : added;
+}
+
+/// @brief Add the games one at a time, publishing the count after each
+static void *board_writer_thread(void *arg)
+{
+    struct verify_board *board = arg;
+
+    for (uint32_t n = 0; n < VERIFY_BOARD_GAMES; n++)
+    {
+        uint32_t game = n / VERIFY_BOARD_PLAYERS;
+        leaderboard_add_game(&board->board, n % VERIFY_BOARD_PLAYERS, game / VERIFY_BOARD_SESSION_GAMES,
+                             board_score(n));
+        atomic_store_explicit(&board->added, n + 1, memory_order_release);
+    }
+    atomic_store_explicit(&board->done, 1, memory_order_release);
+    return NULL;
+}
+
+/// @brief Check a copy of a top list: real games or series, of the first 'before' games, highest first, lowest not fallen
+static int good_top_list(const struct leaderboard_entry entries[], int count, int series, uint32_t before,
+                         struct leaderboard_entry *lowest)
+{
+    if (count < 0 || count > VERIFY_BOARD_TOP)
+        return 0;
+    for (int i = 0; i < count; i++)
+    {
+        const struct leaderboard_entry *entry = &entries[i];
+        uint32_t game = entry->order / VERIFY_BOARD_PLAYERS;
+        int score = board_score(entry->order);
+        if (series)
+            score += board_score(entry->order - VERIFY_BOARD_PLAYERS) + board_score(entry->order - 2 * VERIFY_BOARD_PLAYERS);
+        if (entry->order >= before || entry->player != entry->order % VERIFY_BOARD_PLAYERS ||
+            entry->session != game / VERIFY_BOARD_SESSION_GAMES || entry->score != (uint32_t)score ||
+            (series && game % VERIFY_BOARD_SESSION_GAMES != LEADERBOARD_SERIES_GAMES - 1))
+            return 0;
+        if (i > 0 && (entry->score > entries[i - 1].score ||
+                      (entry->score == entries[i - 1].score && entry->order < entries[i - 1].order)))
+            return 0;
+    }
+    if (count == VERIFY_BOARD_TOP)
+    {
+        const struct leaderboard_entry *last = &entries[count - 1];
+        if (last->score < lowest->score || (last->score == lowest->score && last->order > lowest->order))
+            return 0;
+        *lowest = *last;
+    }
+    return 1;
+}
+
+/// @brief Check a rolling average: that of the player's last games after some count of games from 'from' to 'to'
+static int good_average(uint32_t player, double average, int games, uint32_t from, uint32_t to)
+{
+    uint32_t sum = (uint32_t)(average * games + 0.5);
+
+    for (uint32_t count = board_player_games(player, from); count <= board_player_games(player, to); count++)
+    {
+        if (games != (count < LEADERBOARD_WINDOW ? (int)count : LEADERBOARD_WINDOW))
+            continue;
+        uint32_t expected = 0;
+        for (uint32_t k = count - (uint32_t)games; k < count; k++)
+            expected += (uint32_t)board_score(player + k * VERIFY_BOARD_PLAYERS);
+        if (expected == sum)
+            return 1;
+    }
+    return 0;
+}
+
+/// @brief Read the top lists and averages until the writer is done, checking every copy
+static void *board_reader_thread(void *arg)
+{
+    struct verify_board_reader *reader = arg;
+    struct verify_board *board = reader->board;
+    struct leaderboard_entry entries[LEADERBOARD_MAX_TOP];
+    struct leaderboard_entry lowest_game = { 0, 0, 0, UINT32_MAX };
+    struct leaderboard_entry lowest_series = { 0, 0, 0, UINT32_MAX };
+    uint32_t player = (uint32_t)reader->index;
+    int last = 0;
+
+    for (uint32_t read = 0; !last; read++)
+    {
+        // the writer being done before the read starts makes this the last one
+        last = atomic_load_explicit(&board->done, memory_order_acquire);
+        uint32_t from = atomic_load_explicit(&board->added, memory_order_acquire);
+        double average;
+        int count;
+        int good;
+
+        // games_visible() is only called once the read is done
+        switch (read % 3)
+        {
+        case 0:
+            count = leaderboard_top_games(&board->board, entries);
+            good = good_top_list(entries, count, 0, games_visible(board), &lowest_game);
+            break;
+        case 1:
+            count = leaderboard_top_series(&board->board, entries);
+            good = good_top_list(entries, count, 1, games_visible(board), &lowest_series);
+            break;
+        default:
+            player = (player + 7) % VERIFY_BOARD_PLAYERS;
+            leaderboard_rolling_average(&board->board, player, &average, &count);
+            good = good_average(player, average, count, from, games_visible(board));
+            break;
+        }
+        tally(&reader->results, CHECK_LEADERBOARD, from, good);
+    }
+    return NULL;
+}
+
+/**
+ * Runs the leaderboard check: one writer and VERIFY_BOARD_READERS readers,
+ * each on its own thread. The writer runs on the calling thread if it
+ * can't be started; readers that can't be started are left out.
+ *
+ * @param results receives the reads checked and the bad ones
+ * @return 1 if good or 0 if memory could not be allocated
+ */
+static int verify_leaderboard(struct verify_results *results)
+{
+    struct verify_board *board = malloc(sizeof(*board));
+    struct verify_board_reader readers[VERIFY_BOARD_READERS];
+    pthread_t writer;
+    int started[VERIFY_BOARD_READERS];
+
+    if (!board)
+        return 0;
+    leaderboard_init(&board->board, VERIFY_BOARD_TOP, LEADERBOARD_WINDOW);
+    atomic_init(&board->added, 0);
+    atomic_init(&board->done, 0);
+
+    for (int r = 0; r < VERIFY_BOARD_READERS; r++)
+    {
+        memset(&readers[r].results, 0, sizeof(readers[r].results));
+        readers[r].index = r;
+        readers[r].board = board;
+        started[r] = pthread_create(&readers[r].thread, NULL, board_reader_thread, &readers[r]) == 0;
+    }
+    int writer_started = pthread_create(&writer, NULL, board_writer_thread, board) == 0;
+    if (writer_started)
+        pthread_join(writer, NULL);
+    else
+        board_writer_thread(board);
+
+    for (int r = 0; r < VERIFY_BOARD_READERS; r++)
+    {
+        const struct verify_results *read = &readers[r].results;
+        if (!started[r])
+            continue;
+        pthread_join(readers[r].thread, NULL);
+        if (read->mismatches[CHECK_LEADERBOARD] > 0 &&
+            (results->mismatches[CHECK_LEADERBOARD] == 0 ||
+             read->first_mismatch[CHECK_LEADERBOARD] < results->first_mismatch[CHECK_LEADERBOARD]))
+            results->first_mismatch[CHECK_LEADERBOARD] = read->first_mismatch[CHECK_LEADERBOARD];
+        results->checked[CHECK_LEADERBOARD] += read->checked[CHECK_LEADERBOARD];
+        results->mismatches[CHECK_LEADERBOARD] += read->mismatches[CHECK_LEADERBOARD];
+    }
+
+    leaderboard_free(&board->board);
+    free(board);
+    return 1;
+}
+
+/**
+ * Checks the exhaustive games and config->games random games across
+ * config->threads threads, then the leaderboard under concurrent reads.
+ *
+ * @param config random games, threads and seed for the run
+ * @param results filled in with the combined tallies of all threads
+ *
+ * If a thread can't be started its share is checked on the calling
+ * thread instead.
+ *
+ * @return 1 if good or 0 if the workers or their buffers could not be
+ *         allocated; the scorers agree if verify_mismatches() is also 0
+ */
+int run_verify(const struct verify_config *config, struct verify_results *results)
+{
+    unsigned long long games = EXHAUSTIVE_GAMES + config->games;
+    int threads = worker_thread_count(config->threads);
+
+    struct verify_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    if (!workers)
+        return 0;
+
+    unsigned long long first_game = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        memset(&workers[t].results, 0, sizeof(workers[t].results));
+        workers[t].failed = 0;
+        workers[t].games = games / threads + ((unsigned long long)t < games % threads);
+        workers[t].first_game = first_game;
+        workers[t].seed = config->seed;
+        first_game += workers[t].games;
+    }
+    run_worker_threads(workers, sizeof(*workers), threads, verify_thread);
+
+    int good = 1;
+    memset(results, 0, sizeof(*results));
+    results->exhaustive_games = EXHAUSTIVE_GAMES;
+    results->random_games = config->games;
+    for (int t = 0; t < threads; t++)
+    {
+        if (workers[t].failed)
+            good = 0;
+
+        for (int c = 0; c < VERIFY_CHECK_COUNT; c++)
+        {
+            const struct verify_results *worker = &workers[t].results;
+            if (worker->mismatches[c] > 0 &&
+                (results->mismatches[c] == 0 || worker->first_mismatch[c] < results->first_mismatch[c]))
+                results->first_mismatch[c] = worker->first_mismatch[c];
+            results->checked[c] += worker->checked[c];
+            results->mismatches[c] += worker->mismatches[c];
+        }
+    }
+    free(workers);
+    return verify_leaderboard(results) && good;
+}
+
+/// @brief Mismatches found by all checks together
+unsigned long long verify_mismatches(const struct verify_results *results)
+{
+    unsigned long long mismatches = 0;
+    for (int c = 0; c < VERIFY_CHECK_COUNT; c++)
+        mismatches += results->mismatches[c];
+    return mismatches;
+}
+
+/// @brief Print the tallies, and the balls of the first game each failing check got wrong
+void report_verify(const struct verify_config *config, const struct verify_results *results, FILE *out)
+{
+    fprintf(out, "Exhaustive games: %12llu  every legal frame triple\n", results->exhaustive_games);
+    fprintf(out, "Random games:     %12llu  seed %llu\n", results->random_games, (unsigned long long)config->seed);
+    fprintf(out, "Check                    Games  Mismatches\n");
+    for (int c = 0; c < VERIFY_CHECK_COUNT; c++)
+    {
+        if (results->checked[c] == 0)
+        {
+            fprintf(out, "%-16s %12s  not available\n", check_names[c], "-");
+            continue;
+        }
+        fprintf(out, "%-16s %12llu %11llu\n", check_names[c], results->checked[c], results->mismatches[c]);
+    }
+
+    for (int c = 0; c < VERIFY_CHECK_COUNT; c++)
+    {
+        if (results->mismatches[c] == 0)
+            continue;
+        if (c == CHECK_LEADERBOARD)
+        {
+            fprintf(out, "%s: first bad read with %llu games added\n", check_names[c], results->first_mismatch[c]);
+            continue;
+        }
+
+        struct verify_game game;
+        struct bowling_rng rng;
+        bowling_rng_init(&rng, RNG_PHILOX, config->seed, 0);
+        make_game(&rng, results->first_mismatch[c], &game);
+        fprintf(out, "%s: first mismatch in game %llu:", check_names[c], results->first_mismatch[c]);
+        for (int r = 0; r < game.roll_count; r++)
+            fprintf(out, " %d", game.rolls[r]);
+        fprintf(out, " (%d)\n", game.total);
+    }
+}
@@ -0,0 +1,47 @@
+// verify.h
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Implementations compared with the reference scorer, see verify.c
+enum verify_check
+{
+    CHECK_CALCULATE,        // calculate_game_scores()
+    CHECK_FUSED,            // validate_and_score_game()
+    CHECK_BATCH_SCALAR,     // calculate_game_scores_batch_kernel(), each kernel
+    CHECK_BATCH_SSE42,
+    CHECK_BATCH_AVX2,
+    CHECK_FUSED_BATCH,      // validate_and_score_game_batch()
+    CHECK_CODES,            // score_game_codes()
+    CHECK_CODES_BATCH,      // score_game_codes_batch()
+    CHECK_LIVE,             // push_roll(), a ball at a time
+    CHECK_RULES,            // tenpin_score_rolls()
+    CHECK_ROUND_TRIP,       // encode_game()/decode_game(), rolls_from_frames()/frames_from_rolls()
+    CHECK_VALIDATORS,       // validate_game() and the fused and batch validators agree
+    CHECK_LEADERBOARD,      // leaderboard reads while another thread adds games, counted in reads
+    VERIFY_CHECK_COUNT
+};
+
+struct verify_config
+{
+    unsigned long long games;   // random games after the exhaustive ones
+    int threads;                // worker threads, 0 for one per core
+    uint64_t seed;              // seed of the random games
+};
+
+struct verify_results
+{
+    unsigned long long exhaustive_games;    // games covering every legal frame triple
+    unsigned long long random_games;
+    unsigned long long checked[VERIFY_CHECK_COUNT];     // games each check ran on, 0 if it couldn't run
+    unsigned long long mismatches[VERIFY_CHECK_COUNT];
+    unsigned long long first_mismatch[VERIFY_CHECK_COUNT];  // lowest game number that failed
+};
+
+int run_verify(const struct verify_config *config, struct verify_results *results);
+unsigned long long verify_mismatches(const struct verify_results *results);
+void report_verify(const struct verify_config *config, const struct verify_results *results, FILE *out);
+
+#endif // VERIFY_H
@@ -0,0 +1,204 @@
+/**
+ * @file what_if.c
+ * @brief Outlook for a game in progress: best, expected and likely final scores
+ *
+ * For a game part way through, what_if_query() gives the highest final
+ * score still possible, the expected final score and the chance of
+ * finishing with at least a target score, under a roll model.
+ *
+ * The points still to come only depend on the frame being started and
+ * on the bonuses earlier frames still owe (enum bonus_state, see
+ * score_distribution.c), not on how the game got there. what_if_init()
+ * works backwards from the 10th frame once per model and tabulates, for
+ * every (frame, bonus state):
+ * - the chance of scoring at least a more points, for every a
+ * - the expected points to come
+ * - the most points possible by the rules, whatever the model says
+ *
+ * A query takes the game as a game_state, so it works after every ball
+ * (use game_state_from_frames() for recorded frames). If the game is
+ * part way through a frame, the rest of that frame is played out with
+ * push_roll() for every combination of balls, at most 121 of them, and
+ * each one looked up in the tables. A query is a few microseconds.
+ *
+ * Usage Example:
+ * @code
+ * struct what_if_tables tables;    // about 110 KB
+ * what_if_init(&tables, &model);
+ * game_state_from_frames(frames, &state);
+ * what_if_query(&tables, &state, 200, &result);
+ * @endcode
+ */
+#include <string.h>
+
+#include "what_if.h"
+#include "frame_codes.h"
+#include "frame_validator.h"
+
+// sums over the ways the current frame can finish
+struct outlook
+{
+    int target;
+    int max_score;
+    double expected_score;
+    double chance;
+};
+
+/**
+ * Builds the tables for a roll model.
+ *
+ * @param tables receives the tables
+ * @param model roll probabilities; must stay valid while the tables are used
+ */
+void what_if_init(struct what_if_tables *tables, const struct roll_model *model)
+{
+    // chance of exactly a more points, for the frame after the one being built
+    double after[BONUS_STATES][MAX_SCORE + 1];
+    double now[BONUS_STATES][MAX_SCORE + 1];
+
+    memset(tables, 0, sizeof(*tables));
+    tables->model = model;
+
+    // the game is over, no more points
+    memset(after, 0, sizeof(after));
+    for (int state = 0; state < BONUS_STATES; state++)
+    {
+        after[state][0] = 1.0;
+        tables->tail[MAX_FRAMES][state][0] = 1.0;
+    }
+
+    for (int frame = MAX_FRAMES - 1; frame >= 0; frame--)
+    {
+        int codes = frame == MAX_FRAMES - 1 ? LAST_FRAME_CODES : REGULAR_FRAME_CODES;
+
+        memset(now, 0, sizeof(now));
+        for (int state = 0; state < BONUS_STATES; state++)
+        {
+            int most = 0;
+            for (int c = 0; c < codes; c++)
+            {
+                enum bonus_state next_state = BONUS_NONE;
+                int points;
+                double p;
+                if (frame == MAX_FRAMES - 1)
+                {
+                    points = last_frame_points(c, (enum bonus_state)state);
+                    p = last_frame_probability(model, c);
+                }
+                else
+                {
+                    points = regular_frame_points(c, (enum bonus_state)state, &next_state);
+                    p = regular_frame_probability(model, c);
+                }
+
+                int best = points + tables->most[frame + 1][next_state];
+                if (best > most)
+                    most = best;
+
+                // bonus states that can't happen at this frame may run past 300; they're never looked up
+                for (int a = 0; a + points <= MAX_SCORE; a++)
+                    now[state][a + points] += p * after[next_state][a];
+            }
+            tables->most[frame][state] = most;
+
+            double expected = 0.0;
+            double tail = 0.0;
+            for (int a = MAX_SCORE; a >= 0; a--)
+            {
+                tail += now[state][a];
+                tables->tail[frame][state][a] = tail;
+                expected += a * now[state][a];
+            }
+            tables->expected[frame][state] = expected;
+        }
+        memcpy(after, now, sizeof(after));
+    }
+}
+
+/// @brief Bonuses owed by earlier frames before the next ball of the game
+static enum bonus_state pending_bonus(const struct game_state *state)
+{
+    int next_ball = 0;
+    int ball_after = 0;
+
+    for (int i = state->finalized; i < state->frame; i++)
+    {
+        next_ball += state->bonus_balls[i] >= 1;
+        ball_after += state->bonus_balls[i] >= 2;
+    }
+    if (next_ball == 2)
+        return BONUS_DOUBLE;
+    if (next_ball == 1)
+        return ball_after ? BONUS_STRIKE : BONUS_SPARE;
+    return BONUS_NONE;
+}
+
+/// @brief Chance of at least 'points' more points from the start of a frame
+static double tail_chance(const struct what_if_tables *tables, int frame, enum bonus_state bonus, int points)
+{
+    if (points <= 0)
+        return 1.0;
+    if (points > MAX_SCORE)
+        return 0.0;
+    return tables->tail[frame][bonus][points];
+}
+
+/**
+ * Plays out the rest of the current frame ball by ball and adds each way it
+ * can finish to the outlook.
+ *
+ * @param p chance of the balls played out so far; ways with no chance
+ *          still count towards the highest possible score
+ */
+static void play_out_frame(const struct what_if_tables *tables, const struct game_state *state,
+                           double p, struct outlook *outlook)
+{
+    // at the start of a frame the tables take over
+    if (state->ball == 0 || game_state_complete(state))
+    {
+        enum bonus_state bonus = pending_bonus(state);
+        int max_score = state->live_total + tables->most[state->frame][bonus];
+        if (max_score > outlook->max_score)
+            outlook->max_score = max_score;
+        outlook->expected_score += p * (state->live_total + tables->expected[state->frame][bonus]);
+        outlook->chance += p * tail_chance(tables, state->frame, bonus, outlook->target - state->live_total);
+        return;
+    }
+
+    int standing = pins_standing(&state->frames[state->frame], state->frame, state->ball);
+    for (int pins = 0; pins <= standing; pins++)
+    {
+        struct game_state next = *state;
+        push_roll(&next, pins);
+        play_out_frame(tables, &next, p * tables->model->pmf[standing][pins], outlook);
+    }
+}
+
+/**
+ * Answers what can still happen in a game.
+ *
+ * @param tables built by what_if_init()
+ * @param state the game so far, at any ball
+ * @param target score to give the chance of reaching
+ * @param result receives the outlook
+ */
+void what_if_query(const struct what_if_tables *tables, const struct game_state *state, int target,
+                   struct what_if_result *result)
+{
+    struct outlook outlook = { target, 0, 0.0, 0.0 };
+
+    play_out_frame(tables, state, 1.0, &outlook);
+
+    result->score = state->live_total;
+    result->max_score = outlook.max_score;
+    result->expected_score = outlook.expected_score;
+    result->chance = outlook.chance;
+}
+
+/// @brief Chance of a final score of at least target, see what_if_query()
+double what_if_chance(const struct what_if_tables *tables, const struct game_state *state, int target)
+{
+    struct what_if_result result;
+    what_if_query(tables, state, target, &result);
+    return result.chance;
+}
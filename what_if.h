@@ -0,0 +1,32 @@
+// what_if.h
+#ifndef WHAT_IF_H
+#define WHAT_IF_H
+
+#include "bowling_game.h"
+#include "roll_model.h"
+#include "live_score.h"
+#include "score_distribution.h"
+
+// Outlook from the start of each frame (MAX_FRAMES: the game is over) with each bonus state
+struct what_if_tables
+{
+    const struct roll_model *model;
+    double tail[MAX_FRAMES + 1][BONUS_STATES][MAX_SCORE + 2];   // chance of at least this many more points
+    double expected[MAX_FRAMES + 1][BONUS_STATES];              // expected points still to come
+    int most[MAX_FRAMES + 1][BONUS_STATES];                     // most points still possible
+};
+
+struct what_if_result
+{
+    int score;              // points counted so far, bonuses included
+    int max_score;          // highest final score still possible
+    double expected_score;  // expected final score
+    double chance;          // chance of a final score of at least the target
+};
+
+void what_if_init(struct what_if_tables *tables, const struct roll_model *model);
+void what_if_query(const struct what_if_tables *tables, const struct game_state *state, int target,
+                   struct what_if_result *result);
+double what_if_chance(const struct what_if_tables *tables, const struct game_state *state, int target);
+
+#endif // WHAT_IF_H
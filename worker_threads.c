@@ -0,0 +1,53 @@
+/**
+ * @file worker_threads.c
+ * @brief Sizing and running a run's worker threads
+ *
+ * The simulation, --verify, calibration and the lane server all split
+ * their work across a caller's thread count, 0 meaning one per core, and
+ * the batch runs start one thread per worker and wait for them all.
+ */
+#include <pthread.h>
+#include <unistd.h>
+
+#include "worker_threads.h"
+
+/// @brief Clamp a thread count to 1..MAX_THREADS, 0 (or less) meaning one per core
+int worker_thread_count(int threads)
+{
+    if (threads <= 0)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    return threads > MAX_THREADS ? MAX_THREADS : threads;
+}
+
+/**
+ * Runs 'body' on each of 'threads' workers, every one on its own thread,
+ * and returns once all have finished.
+ *
+ * @param workers array of 'threads' workers, 'worker_size' bytes each;
+ *        body() is passed a pointer to its worker
+ * @param threads number of workers, at most MAX_THREADS
+ *
+ * A worker whose thread can't be started runs on the calling thread
+ * instead. Whether a worker failed is up to body() to record in it.
+ */
+void run_worker_threads(void *workers, size_t worker_size, int threads, void *(*body)(void *))
+{
+    pthread_t thread[MAX_THREADS];
+    int started[MAX_THREADS];
+
+    for (int t = 0; t < threads; t++)
+    {
+        void *worker = (char *)workers + (size_t)t * worker_size;
+        started[t] = pthread_create(&thread[t], NULL, body, worker) == 0;
+        if (!started[t])
+            body(worker);
+    }
+    for (int t = 0; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(thread[t], NULL);
+    }
+}
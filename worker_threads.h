@@ -0,0 +1,12 @@
+// worker_threads.h
+#ifndef WORKER_THREADS_H
+#define WORKER_THREADS_H
+
+#include <stddef.h>
+
+#define MAX_THREADS 256     // most worker threads a run starts
+
+int worker_thread_count(int threads);
+void run_worker_threads(void *workers, size_t worker_size, int threads, void *(*body)(void *));
+
+#endif // WORKER_THREADS_H